@@ -0,0 +1,155 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "psapi.lib")
+#endif
+#endif
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace MapBenchmarks
+{
+	/// <summary>
+	/// Resident set size of the current process.
+	/// Linux reads /proc/self/status, Windows uses the working set.
+	/// </summary>
+	struct ProcessMemory
+	{
+		size_t rss = 0;  // current resident bytes
+		size_t peak = 0; // high-water mark in bytes
+
+		static ProcessMemory Query()
+		{
+			ProcessMemory mem;
+
+#if defined(_WIN32)
+			PROCESS_MEMORY_COUNTERS counters{};
+			if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			{
+				mem.rss = counters.WorkingSetSize;
+				mem.peak = counters.PeakWorkingSetSize;
+			}
+#elif defined(__linux__)
+			std::ifstream status("/proc/self/status");
+			std::string line;
+			while (std::getline(status, line))
+			{
+				// values are reported as "VmRSS:     1234 kB"
+				if (line.rfind("VmRSS:", 0) == 0)
+					mem.rss = std::stoull(line.substr(6)) * 1024;
+				else if (line.rfind("VmHWM:", 0) == 0)
+					mem.peak = std::stoull(line.substr(6)) * 1024;
+			}
+#endif
+			return mem;
+		}
+
+		/// <summary>
+		/// Resets the high-water mark to the current RSS, so the next 'Query' reports
+		/// the peak of the code in between. Only supported on Linux.
+		/// </summary>
+		/// <returns>False, if the platform can't reset the peak</returns>
+		static bool ResetPeak()
+		{
+#if defined(__linux__)
+			std::FILE* file = std::fopen("/proc/self/clear_refs", "w");
+			if (!file)
+				return false;
+
+			const bool ok = std::fputs("5", file) >= 0;
+			std::fclose(file);
+			return ok;
+#else
+			return false;
+#endif
+		}
+
+		/// <summary>
+		/// Hands freed heap memory back to the OS, so RSS deltas aren't hidden by
+		/// memory the allocator kept around from a previous run.
+		/// </summary>
+		static void ReleaseFreeMemory()
+		{
+#if defined(__GLIBC__)
+			static const bool fixed_threshold = []
+				{
+					// glibc raises the mmap threshold after large frees, which moves
+					// big arrays into the heap. Pin it, so they are always unmapped on free.
+					return mallopt(M_MMAP_THRESHOLD, 128 * 1024) != 0;
+				}();
+
+			(void)fixed_threshold;
+			malloc_trim(0);
+#elif defined(_WIN32)
+			HeapCompact(GetProcessHeap(), 0);
+#endif
+		}
+	};
+
+	class Timer
+	{
+		std::chrono::high_resolution_clock::time_point m_start = std::chrono::high_resolution_clock::now();
+
+	public:
+
+		void Restart() noexcept
+		{
+			m_start = std::chrono::high_resolution_clock::now();
+		}
+
+		[[nodiscard]] double ElapsedMs() const noexcept
+		{
+			const auto now = std::chrono::high_resolution_clock::now();
+			return std::chrono::duration<double, std::milli>(now - m_start).count();
+		}
+	};
+
+	/// <summary>
+	/// Prints one row of a result table, 'name' left aligned and every column right aligned after it,
+	/// floating point columns with two decimals. The header row is the same call with the column titles.
+	/// Restores the formatting of std::cout afterwards.
+	/// </summary>
+	template <class... Columns>
+	static void PrintRow(const std::string& name, const Columns&... columns)
+	{
+		constexpr int name_width = 40;
+		constexpr int column_width = 14;
+
+		const auto flags = std::cout.flags();
+		const auto precision = std::cout.precision();
+
+		std::cout << std::left << std::setw(name_width) << name << std::right << std::fixed << std::setprecision(2);
+		((std::cout << std::setw(column_width) << columns), ...);
+		std::cout << "\n";
+
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+	/// <summary>
+	/// Keeps the compiler from optimizing away benchmark results.
+	/// </summary>
+	template <class T>
+	static void DoNotOptimize(const T& value)
+	{
+#if defined(__clang__) || defined(__GNUC__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const void* volatile sink;
+		sink = &value;
+#endif
+	}
+}
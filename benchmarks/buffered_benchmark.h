@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LinearMap.h"
+#include "LinearMapThreads.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Several threads writing into one shared map.
+	 *
+	 *   mutex per write - a LinearCoreMap and a std::mutex, locked for every Emplace
+	 *   BufferedLinearMap - a Writer per thread, one lock per 'flush_at' writes
+	 *
+	 * Every thread writes random keys of its own, one in eight writes is an Erase.
+	 * The time includes the final flush of every Writer.
+	 */
+
+	template <class Write>
+	static double TimeSharedWrites(const unsigned threads, const size_t writes, Write&& write)
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(threads);
+
+		Timer timer;
+		for (unsigned t = 0; t < threads; ++t)
+			workers.emplace_back([&, t] { write(t, writes); });
+		for (auto& worker : workers)
+			worker.join();
+
+		return timer.ElapsedMs();
+	}
+
+	static void PrintSharedWriteTimes(const std::string& name, const size_t writes, const double ms)
+	{
+		PrintRow(name, ms, (double)writes / (ms * 1000.0));
+	}
+
+	static void BenchmarkBufferedWrites(const unsigned threads = 4, const size_t writes = 4'000'000)
+	{
+		std::cout << "\n--- Buffered Writes Benchmark ---\n";
+		std::cout << "\n" << threads << " threads, " << writes << " writes each, "
+			<< std::thread::hardware_concurrency() << " hardware threads\n";
+		PrintRow("Container", "write(ms)", "Mops/s");
+
+		const auto total = (size_t)threads * writes;
+
+		{
+			LinearCoreMap<uint64_t, uint64_t> map;
+			std::mutex mutex;
+			const auto ms = TimeSharedWrites(threads, writes, [&](const unsigned t, const size_t count)
+				{
+					WorkloadRng rng{ 53 + t };
+					for (size_t i = 0; i < count; ++i)
+					{
+						const auto key = rng.Next();
+						std::lock_guard lock(mutex);
+						if (i % 8 == 7)
+							map.Erase(key);
+						else
+							map.Emplace(key, (uint64_t)i);
+					}
+				});
+			PrintSharedWriteTimes("LinearCoreMap, mutex per write", total, ms);
+			DoNotOptimize(map.Size());
+		}
+
+		for (const size_t flush_at : { (size_t)16, (size_t)1000, (size_t)16'000 })
+		{
+			BufferedLinearMap<uint64_t, uint64_t> map;
+			const auto ms = TimeSharedWrites(threads, writes, [&](const unsigned t, const size_t count)
+				{
+					auto writer = map.MakeWriter(flush_at);
+					WorkloadRng rng{ 53 + t };
+					for (size_t i = 0; i < count; ++i)
+					{
+						const auto key = rng.Next();
+						if (i % 8 == 7)
+							writer.Erase(key);
+						else
+							writer.Emplace(key, (uint64_t)i);
+					}
+				});
+			PrintSharedWriteTimes("BufferedLinearMap, flush at " + std::to_string(flush_at), total, ms);
+			DoNotOptimize(map.Size());
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Static integer sets, a LinearSet<uint64_t> against the bit packed CompactLinearSet.
+	 *
+	 *   bytes/key - table bytes (LinearSet: capacity * 9) or MemoryBytes() per key
+	 *   contains  - random lookups, half of them hit
+	 *
+	 * CompactLinearSet stores only the bits of a key that its bucket doesn't give, so it shrinks with
+	 * the range of the keys: full 64 bit keys, keys below 2^32, and dense ids.
+	 */
+
+	static void PrintCompactRow(const std::string& name, const double bytes_per_key, const size_t lookups, const double ms)
+	{
+		PrintRow(name, bytes_per_key, ms, (double)lookups / (ms * 1000.0));
+	}
+
+	template <class Set>
+	static double TimeContains(Set& set, const std::vector<uint64_t>& lookups)
+	{
+		size_t hits = 0;
+		Timer timer;
+		for (const auto key : lookups)
+			hits += set.Contains(key);
+
+		const auto ms = timer.ElapsedMs();
+		DoNotOptimize(hits);
+		return ms;
+	}
+
+	static void BenchmarkCompactSetOn(const std::string& distribution, const std::vector<uint64_t>& keys, const std::vector<uint64_t>& lookups)
+	{
+		std::cout << "\n" << distribution << ", " << keys.size() << " keys, " << lookups.size() << " lookups\n";
+		PrintRow("Container", "bytes/key", "contains(ms)", "Mops/s");
+
+		LinearSet<uint64_t> set;
+		for (const auto key : keys)
+			set.Emplace(key);
+		PrintCompactRow("LinearSet<uint64_t>", (double)(set.Capacity() * (sizeof(uint64_t) + 1)) / (double)set.Size(),
+			lookups.size(), TimeContains(set, lookups));
+
+		const CompactLinearSet<uint64_t> compact(set);
+		PrintCompactRow("CompactLinearSet<uint64_t>", (double)compact.MemoryBytes() / (double)compact.Size(),
+			lookups.size(), TimeContains(compact, lookups));
+	}
+
+	static void BenchmarkCompactSet(const size_t count = 4'000'000)
+	{
+		std::cout << "\n--- Compact Set Benchmark ---\n";
+
+		WorkloadRng rng{ 53 };
+		std::vector<uint64_t> keys(count), lookups(count);
+
+		const auto run = [&](const std::string& distribution, auto&& make_key)
+			{
+				for (auto& key : keys)
+					key = make_key();
+				for (size_t i = 0; i < count; ++i)
+					lookups[i] = (i & 1) ? keys[rng.Next() % count] : make_key();
+				BenchmarkCompactSetOn(distribution, keys, lookups);
+			};
+
+		run("Random 64 bit", [&] { return rng.Next(); });
+		run("Random below 2^32", [&] { return rng.Next() >> 32; });
+		run("Ids below 2 * count", [&] { return rng.Next() % (count * 2); });
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * A map copied per request, as a snapshot of a configuration.
+	 *
+	 * Every request copies the map, reads a few keys of its copy, and one request in 'write_every'
+	 * also writes one key. LinearCoreMap deep copies on every request, SharedLinearMap only when
+	 * a copy is written.
+	 */
+
+	template <class Map, class Read, class Write>
+	static double TimeCopyRequests(const Map& config, const size_t keys, const size_t requests, const size_t write_every, Read&& read, Write&& write)
+	{
+		WorkloadRng rng{ 47 };
+		size_t sum = 0;
+
+		Timer timer;
+		for (size_t i = 0; i < requests; ++i)
+		{
+			auto copy = config;
+			for (int n = 0; n < 4; ++n)
+				sum += read(copy, rng.Next() % keys);
+
+			if (i % write_every == 0)
+				write(copy, rng.Next() % keys, (uint64_t)i);
+		}
+
+		const auto ms = timer.ElapsedMs();
+		DoNotOptimize(sum);
+		return ms;
+	}
+
+	static void PrintCopyTimes(const std::string& name, const size_t requests, const double ms)
+	{
+		PrintRow(name, ms, ms * 1'000'000.0 / (double)requests);
+	}
+
+	static void BenchmarkCopyOnWriteOn(const size_t keys, const size_t requests, const size_t write_every)
+	{
+		LinearCoreMap<uint64_t, uint64_t> deep;
+		SharedLinearMap<uint64_t, uint64_t> shared;
+		for (uint64_t key = 0; key < keys; ++key)
+		{
+			deep.Emplace(key, key);
+			shared.Emplace(key, key);
+		}
+
+		std::cout << "\n" << keys << " keys, " << requests << " requests, one in " << write_every << " writes\n";
+		PrintRow("Container", "time(ms)", "ns/request");
+
+		PrintCopyTimes("LinearCoreMap<uint64_t, uint64_t>", requests, TimeCopyRequests(deep, keys, requests, write_every,
+			[](auto& map, const uint64_t key) { return map.Get(key); },
+			[](auto& map, const uint64_t key, const uint64_t value) { map.Emplace(key, value); }));
+
+		PrintCopyTimes("SharedLinearMap<uint64_t, uint64_t>", requests, TimeCopyRequests(shared, keys, requests, write_every,
+			[](const auto& map, const uint64_t key) { return map.Get(key); },
+			[](auto& map, const uint64_t key, const uint64_t value) { map.Emplace(key, value); }));
+	}
+
+	static void BenchmarkCopyOnWrite()
+	{
+		std::cout << "\n--- Copy On Write Benchmark ---\n";
+
+		BenchmarkCopyOnWriteOn(100, 1'000'000, 1000);
+		BenchmarkCopyOnWriteOn(10'000, 100'000, 1000);
+		BenchmarkCopyOnWriteOn(10'000, 100'000, 10);
+		BenchmarkCopyOnWriteOn(1'000'000, 200, 10);
+	}
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "key_benchmark.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Erase throughput.
+	 *
+	 *   drain - fill to just below the max load factor, then erase every key in random order
+	 *   churn - keep the map at a steady load, every step erases one key and inserts another
+	 *
+	 * Erase cost depends on the cluster behind the key, so the maps are filled close to 0.7.
+	 */
+
+	/// <summary>
+	/// 64 byte value, every backward shift moves it.
+	/// </summary>
+	struct Payload64
+	{
+		uint64_t data[8] = {};
+
+		Payload64() = default;
+		Payload64(const int value) noexcept { data[0] = (uint64_t)value; }
+	};
+
+	constexpr MapPolicy tombstone_policy{ DeletionPolicy::Tombstone };
+
+	struct EraseTimes
+	{
+		double drain = 0; // ms
+		double churn = 0; // ms
+	};
+
+	template <class Map, class K>
+	static void EraseInsert(Map& map, const K& key, const size_t n)
+	{
+		if constexpr (requires(Map& m) { m.Emplace(key, 0); })
+			map.Emplace(key, (int)n);
+		else if constexpr (requires(Map& m) { m.insert_or_assign(key, 0); })
+			map.insert_or_assign(key, (int)n);
+		else if constexpr (requires(Map& m) { m.Emplace(key); })
+			map.Emplace(key);
+		else
+			map.insert(key);
+	}
+
+	template <class Map, class K>
+	static bool EraseKey(Map& map, const K& key)
+	{
+		if constexpr (requires(Map& m) { m.Erase(key); })
+			return map.Erase(key);
+		else
+			return map.erase(key) != 0;
+	}
+
+	/// <summary>
+	/// 'keys' holds 2 * 'live' distinct keys. The first half is inserted, churn replaces them with the second half.
+	/// Both runs repeat 'rounds' times, times are the sum.
+	/// </summary>
+	template <class Map, class K>
+	static EraseTimes TimeErase(const std::vector<K>& keys, const size_t live, const size_t rounds)
+	{
+		EraseTimes times;
+		size_t erased = 0;
+
+		for (size_t round = 0; round < rounds; ++round)
+		{
+			Map map;
+			for (size_t i = 0; i < live; ++i)
+				EraseInsert(map, keys[i], i);
+
+			std::vector<size_t> order(live);
+			for (size_t i = 0; i < live; ++i)
+				order[i] = i;
+
+			WorkloadRng rng{ 42 };
+			for (size_t i = live - 1; i > 0; --i)
+				std::swap(order[i], order[rng.Next() % (i + 1)]);
+
+			Timer timer;
+			for (const auto i : order)
+				erased += EraseKey(map, keys[i]);
+
+			times.drain += timer.ElapsedMs();
+		}
+
+		for (size_t round = 0; round < rounds; ++round)
+		{
+			Map map;
+			for (size_t i = 0; i < live; ++i)
+				EraseInsert(map, keys[i], i);
+
+			// erase the oldest key, insert a new one, the window moves through the key set
+			Timer timer;
+			for (size_t step = 0; step < live; ++step)
+			{
+				erased += EraseKey(map, keys[step]);
+				EraseInsert(map, keys[live + step], step);
+			}
+
+			times.churn += timer.ElapsedMs();
+		}
+
+		DoNotOptimize(erased);
+		return times;
+	}
+
+	static void PrintEraseTimes(const std::string& name, const size_t operations, const EraseTimes& times)
+	{
+		PrintRow(name, times.drain, (double)operations / (times.drain * 1000.0),
+			times.churn, (double)operations / (times.churn * 1000.0));
+	}
+
+	/// <summary>
+	/// Runs all containers with 'live' keys, at the largest count below the max load factor of a 'table_size' table.
+	/// </summary>
+	static void BenchmarkEraseAt(const size_t table_size, const size_t rounds)
+	{
+		const auto live = (size_t)((double)table_size * 0.69);
+		const auto operations = live * rounds;
+
+		std::cout << "\n" << live << " elements (table " << table_size << ", load ~0.69), " << rounds << " rounds\n";
+		PrintRow("Container", "drain(ms)", "Mops/s", "churn(ms)", "Mops/s");
+
+		// random keys, strided ones would measure the hash instead of the erase
+		std::vector<size_t> int_keys(live * 2);
+		WorkloadRng rng{ 7 };
+		for (auto& key : int_keys)
+			key = rng.Next();
+
+		PrintEraseTimes("LinearMap<int>", operations, TimeErase<LinearMap<int>>(int_keys, live, rounds));
+		PrintEraseTimes("LinearMap<int> tombstones", operations, TimeErase<LinearMap<int, tombstone_policy>>(int_keys, live, rounds));
+		PrintEraseTimes("LinearMap<Payload64>", operations, TimeErase<LinearMap<Payload64>>(int_keys, live, rounds));
+		PrintEraseTimes("LinearMap<Payload64> tombstones", operations, TimeErase<LinearMap<Payload64, tombstone_policy>>(int_keys, live, rounds));
+		PrintEraseTimes("std::unordered_map<size_t, int>", operations, TimeErase<std::unordered_map<size_t, int>>(int_keys, live, rounds));
+		PrintEraseTimes("LinearSet<size_t>", operations, TimeErase<LinearSet<size_t>>(int_keys, live, rounds));
+		PrintEraseTimes("LinearSet<size_t> tombstones", operations, TimeErase<LinearSet<size_t, tombstone_policy>>(int_keys, live, rounds));
+		PrintEraseTimes("std::unordered_set<size_t>", operations, TimeErase<std::unordered_set<size_t>>(int_keys, live, rounds));
+
+		const auto string_keys = MakeStringKeys(live * 2, 24, 7);
+		PrintEraseTimes("LinearCoreMap<string, int>", operations, TimeErase<LinearCoreMap<std::string, int>>(string_keys, live, rounds));
+		PrintEraseTimes("LinearCoreMap<string, int> tombstones", operations, TimeErase<LinearCoreMap<std::string, int, tombstone_policy>>(string_keys, live, rounds));
+		PrintEraseTimes("std::unordered_map<string, int>", operations, TimeErase<std::unordered_map<std::string, int>>(string_keys, live, rounds));
+	}
+
+	static void BenchmarkErase()
+	{
+		std::cout << "\n--- Erase Benchmark ---\n";
+
+		// cache resident, shows the cost of the shift itself
+		BenchmarkEraseAt(1 << 14, 64);
+
+		// the maps grow to this size by themselves, most of the time goes into cache misses
+		BenchmarkEraseAt(1 << 20, 1);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LinearMap.h"
+#include "LinearMapArrow.h"
+#include "LinearMapThreads.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Copying the entries of a map into a key column and a value column.
+	 *
+	 *   Iterator          - range for over the map, writing both columns by index
+	 *   ExportTo          - the used slots found eight control bytes at a time
+	 *   ExportTo, pool    - slot ranges on a WorkStealingPool, each counts its entries first
+	 *   ExportArrow       - ExportTo into new columns, plus the Arrow structs and their release
+	 *
+	 * The columns are allocated and touched before the timing, except for ExportArrow, which allocates its own.
+	 */
+
+	template <class Export>
+	static void TimeExport(const std::string& name, const size_t count, const int repeat, Export&& run)
+	{
+		Timer timer;
+		for (int r = 0; r < repeat; ++r)
+			run();
+		const double ms = timer.ElapsedMs() / repeat;
+		PrintRow(name, ms, (double)count / (ms * 1000.0));
+	}
+
+	static void BenchmarkExport(const size_t count = 8'000'000, const int repeat = 5)
+	{
+		std::cout << "\n--- Columnar Export Benchmark ---\n";
+
+		LinearCoreMap<uint64_t, uint64_t> map;
+		WorkloadRng rng{ 71 };
+		for (size_t i = 0; i < count; ++i)
+			map.Emplace(rng.Next(), i);
+
+		std::cout << "\n" << map.Size() << " entries, " << map.Capacity() << " slots, "
+			<< std::thread::hardware_concurrency() << " hardware threads, ms per export\n";
+		PrintRow("Export", "time(ms)", "M/s");
+
+		std::vector<uint64_t> keys(map.Size(), 1), values(map.Size(), 1);
+
+		TimeExport("Iterator", map.Size(), repeat, [&]
+			{
+				size_t i = 0;
+				for (auto [key, value] : map)
+				{
+					keys[i] = key;
+					values[i] = value;
+					++i;
+				}
+				DoNotOptimize(keys.data());
+			});
+
+		TimeExport("ExportTo", map.Size(), repeat, [&]
+			{
+				map.ExportTo(keys, values);
+				DoNotOptimize(keys.data());
+			});
+
+		WorkStealingPool pool;
+		TimeExport("ExportTo, WorkStealingPool(" + std::to_string(pool.Threads()) + ")", map.Size(), repeat, [&]
+			{
+				map.ExportTo(keys, values, pool);
+				DoNotOptimize(keys.data());
+			});
+
+		TimeExport("ExportArrow", map.Size(), repeat, [&]
+			{
+				ArrowArray array;
+				ArrowSchema schema;
+				ExportArrow(map, &array, &schema);
+				DoNotOptimize(array.children[0]->buffers[1]);
+				array.release(&array);
+				schema.release(&schema);
+			});
+	}
+}
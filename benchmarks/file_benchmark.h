@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "LinearMapFile.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Loading a saved map, the way a service restarts.
+	 *
+	 *   serial    - read the whole file, then insert every entry into a presized map
+	 *   LoadMap   - reader threads read chunks while the calling thread inserts the chunks that arrived
+	 *
+	 * The file is read right after it was written, so it comes from the page cache. From a disk,
+	 * reading takes longer and the overlap saves more.
+	 */
+
+	static double TimeSerialLoad(const std::string& path, LinearCoreMap<uint64_t, uint64_t>& map)
+	{
+		Timer timer;
+
+		std::ifstream file(path, std::ios::binary);
+		Internal::MapFileHeader header{};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		std::vector<uint64_t> keys(header.count), values(header.count);
+		for (uint64_t first = 0; first < header.count; first += header.chunk_entries)
+		{
+			const auto count = (size_t)(std::min)(header.chunk_entries, header.count - first);
+			file.read(reinterpret_cast<char*>(keys.data() + first), (std::streamsize)(count * sizeof(uint64_t)));
+			file.read(reinterpret_cast<char*>(values.data() + first), (std::streamsize)(count * sizeof(uint64_t)));
+		}
+
+		map.Reserve((size_t)((double)header.count / map.MaxLoadFactor()) + 1);
+		map.EmplaceAll(keys.data(), values.data(), keys.size());
+
+		return timer.ElapsedMs();
+	}
+
+	static void PrintLoadTime(const std::string& name, const size_t count, const double ms)
+	{
+		PrintRow(name, ms, (double)count / (ms * 1000.0));
+	}
+
+	static void BenchmarkMapFile(const size_t count = 16'000'000)
+	{
+		std::cout << "\n--- Map File Benchmark ---\n";
+
+		const auto path = (std::filesystem::temp_directory_path() / "fastlinearmap-benchmark.bin").string();
+		{
+			LinearCoreMap<uint64_t, uint64_t> map((size_t)((double)count / LinearCoreMap<uint64_t, uint64_t>::MaxLoadFactor()) + 1);
+			WorkloadRng rng{ 59 };
+			for (size_t i = 0; i < count; ++i)
+				map.Emplace(rng.Next(), (uint64_t)i);
+			SaveMap(map, path);
+		}
+
+		std::cout << "\n" << count << " entries, " << count * 16 / (1024 * 1024) << " MiB\n";
+		PrintRow("Load", "time(ms)", "Mops/s");
+
+		{
+			LinearCoreMap<uint64_t, uint64_t> map;
+			PrintLoadTime("serial read, then insert", count, TimeSerialLoad(path, map));
+		}
+
+		for (const unsigned readers : { 1u, 2u, 4u })
+		{
+			LinearCoreMap<uint64_t, uint64_t> map;
+			Timer timer;
+			LoadMap(map, path, readers);
+			PrintLoadTime("LoadMap, " + std::to_string(readers) + " reader(s)", count, timer.ElapsedMs());
+		}
+
+		std::filesystem::remove(path);
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Skewed lookups with the options for hot keys: the hot key cache (MapPolicy::hot_keys)
+	 * and hit reordering (MapPolicy::reordering).
+	 *
+	 * The map is larger than the last level cache and filled to ~0.69, so clusters are long and a cold
+	 * lookup misses on the control bytes, the key and the value. A cache hit only touches the value.
+	 * The cache holds one key per entry, it only pays off while the hottest keys fit into it.
+	 * Reordering moves hot keys towards the start of their cluster, random keys rarely leave their home
+	 * slot at this load, so only the strided keys show it.
+	 */
+
+	constexpr MapPolicy hot_keys_256{ .hot_keys = 256 };
+	constexpr MapPolicy hot_keys_4096{ .hot_keys = 4096 };
+	constexpr MapPolicy transpose_hits{ .reordering = HitReordering::Transpose };
+
+	/// <summary>
+	/// 'count' indices into 'keys' with a Zipf distribution of exponent 's', rank 0 is the hottest key.
+	/// </summary>
+	static std::vector<size_t> MakeZipfLookups(const size_t keys, const size_t count, const double s, const uint64_t seed)
+	{
+		std::vector<double> cdf(keys);
+		double sum = 0;
+		for (size_t i = 0; i < keys; ++i)
+		{
+			sum += 1.0 / std::pow((double)(i + 1), s);
+			cdf[i] = sum;
+		}
+
+		std::vector<size_t> lookups(count);
+		WorkloadRng rng{ seed };
+		for (auto& lookup : lookups)
+		{
+			const auto u = (double)(rng.Next() >> 11) / (double)(1ull << 53) * sum;
+			lookup = (std::min)((size_t)(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin()), keys - 1);
+		}
+
+		return lookups;
+	}
+
+	/// <summary>
+	/// 'hot_share' of the lookups go to the first 'hot_keys' keys, the rest to any key.
+	/// </summary>
+	static std::vector<size_t> MakeHotSetLookups(const size_t keys, const size_t count, const size_t hot_keys, const double hot_share, const uint64_t seed)
+	{
+		std::vector<size_t> lookups(count);
+		WorkloadRng rng{ seed };
+		const auto threshold = (uint64_t)(hot_share * 1000.0);
+
+		for (auto& lookup : lookups)
+			lookup = rng.Next() % 1000 < threshold ? rng.Next() % hot_keys : rng.Next() % keys;
+
+		return lookups;
+	}
+
+	template <class Map>
+	static double TimeHotKeyLookups(const std::vector<uint64_t>& keys, const std::vector<size_t>& lookups)
+	{
+		Map map(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i)
+			map.Emplace(keys[i], (int)i);
+
+		size_t sum = 0;
+		Timer timer;
+		for (const auto i : lookups)
+			sum += (size_t)map.Get(keys[i]);
+
+		const auto ms = timer.ElapsedMs();
+		DoNotOptimize(sum);
+		return ms;
+	}
+
+	static void PrintHotKeyTimes(const std::string& name, const size_t lookups, const double ms)
+	{
+		PrintRow(name, ms, (double)lookups / (ms * 1000.0));
+	}
+
+	static void BenchmarkHotKeysOn(const std::string& distribution, const std::vector<uint64_t>& keys, const std::vector<size_t>& lookups)
+	{
+		std::cout << "\n" << distribution << ", " << keys.size() << " keys, " << lookups.size() << " lookups\n";
+		PrintRow("Container", "get(ms)", "Mops/s");
+
+		PrintHotKeyTimes("LinearMap<int>", lookups.size(), TimeHotKeyLookups<LinearMap<int>>(keys, lookups));
+		PrintHotKeyTimes("LinearMap<int> hot_keys 256", lookups.size(), TimeHotKeyLookups<LinearMap<int, hot_keys_256>>(keys, lookups));
+		PrintHotKeyTimes("LinearMap<int> hot_keys 4096", lookups.size(), TimeHotKeyLookups<LinearMap<int, hot_keys_4096>>(keys, lookups));
+		PrintHotKeyTimes("LinearMap<int> Transpose", lookups.size(), TimeHotKeyLookups<LinearMap<int, transpose_hits>>(keys, lookups));
+	}
+
+	static void BenchmarkHotKeys(const size_t count = (size_t)((double)(1 << 22) * 0.69), const size_t lookups = 10'000'000)
+	{
+		std::cout << "\n--- Hot Key Cache Benchmark ---\n";
+
+		std::vector<uint64_t> keys(count);
+		WorkloadRng rng{ 21 };
+		for (auto& key : keys)
+			key = rng.Next();
+
+		BenchmarkHotKeysOn("Zipf s=1.0", keys, MakeZipfLookups(count, lookups, 1.0, 5));
+		BenchmarkHotKeysOn("Zipf s=1.2", keys, MakeZipfLookups(count, lookups, 1.2, 5));
+		BenchmarkHotKeysOn("1% of keys take 60%", keys, MakeHotSetLookups(count, lookups, count / 100, 0.6, 5));
+		BenchmarkHotKeysOn("Uniform", keys, MakeHotSetLookups(count, lookups, count, 0.0, 5));
+
+		for (size_t i = 0; i < count; ++i)
+			keys[i] = i * 64; // long clusters with the golden ratio hash, where reordering has something to shorten
+		BenchmarkHotKeysOn("Stride 64, Zipf s=1.2", keys, MakeZipfLookups(count, lookups, 1.2, 5));
+		BenchmarkHotKeysOn("Stride 64, 1% of keys take 60%", keys, MakeHotSetLookups(count, lookups, count / 100, 0.6, 5));
+	}
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Non-integer keys and large values.
+	 *
+	 * Integer keys are hashed inline (InvokeHash), everything else goes through the
+	 * 'm_hash' function pointer. Large values make every Resize move a lot of memory.
+	 * Both maps start small, so the Emplace timings include all the resizes.
+	 */
+
+	struct Key16
+	{
+		uint64_t a = 0;
+		uint64_t b = 0;
+
+		bool operator==(const Key16& other) const noexcept = default;
+	};
+
+	struct Key32
+	{
+		uint64_t a = 0;
+		uint64_t b = 0;
+		uint64_t c = 0;
+		uint64_t d = 0;
+
+		bool operator==(const Key32& other) const noexcept = default;
+	};
+
+	static size_t HashKey16(const Key16& key)
+	{
+		return key.a * 0x9E3779B97F4A7C15ull ^ key.b;
+	}
+
+	static size_t HashKey32(const Key32& key)
+	{
+		auto hash = key.a * 0x9E3779B97F4A7C15ull ^ key.b;
+		hash = hash * 0x9E3779B97F4A7C15ull ^ key.c;
+		return hash * 0x9E3779B97F4A7C15ull ^ key.d;
+	}
+
+	/// <summary>
+	/// Adapts a LinearProbing 'HashFunction' to std::unordered_map, so both maps use the same hash.
+	/// </summary>
+	template <class K, size_t(*Hash)(const K&)>
+	struct HashAdapter
+	{
+		size_t operator()(const K& key) const noexcept
+		{
+			return Hash(key);
+		}
+	};
+
+	struct OperationTimes
+	{
+		double emplace = 0;
+		double get = 0;
+		double miss = 0; // Contains on absent keys
+	};
+
+	template <class Map, class K, class MakeValue>
+	static OperationTimes TimeLinear(Map& map, const std::vector<K>& keys, const std::vector<K>& missing, MakeValue&& make_value)
+	{
+		OperationTimes times;
+		Timer timer;
+
+		for (size_t i = 0; i < keys.size(); ++i)
+			map.Emplace(keys[i], make_value(i));
+
+		times.emplace = timer.ElapsedMs();
+		timer.Restart();
+
+		size_t found = 0;
+		for (const auto& key : keys)
+			found += map.IsValid(map.Get(key));
+
+		times.get = timer.ElapsedMs();
+		timer.Restart();
+
+		for (const auto& key : missing)
+			found += map.Contains(key);
+
+		times.miss = timer.ElapsedMs();
+		DoNotOptimize(found);
+		return times;
+	}
+
+	template <class Map, class K, class MakeValue>
+	static OperationTimes TimeUnordered(Map& map, const std::vector<K>& keys, const std::vector<K>& missing, MakeValue&& make_value)
+	{
+		OperationTimes times;
+		Timer timer;
+
+		for (size_t i = 0; i < keys.size(); ++i)
+			map.insert_or_assign(keys[i], make_value(i));
+
+		times.emplace = timer.ElapsedMs();
+		timer.Restart();
+
+		size_t found = 0;
+		for (const auto& key : keys)
+			found += map.find(key) != map.end();
+
+		times.get = timer.ElapsedMs();
+		timer.Restart();
+
+		for (const auto& key : missing)
+			found += map.contains(key);
+
+		times.miss = timer.ElapsedMs();
+		DoNotOptimize(found);
+		return times;
+	}
+
+	static void PrintKeyScenarioHeader()
+	{
+		PrintRow("Scenario", "Op", "Linear(ms)", "unordered(ms)", "Speedup(x)");
+	}
+
+	static void PrintKeyScenario(const std::string& name, const OperationTimes& linear, const OperationTimes& unordered)
+	{
+		auto row = [&name](const char* op, const double linear_ms, const double unordered_ms)
+			{
+				PrintRow(name, op, linear_ms, unordered_ms, unordered_ms / linear_ms);
+			};
+
+		row("Emplace", linear.emplace, unordered.emplace);
+		row("Get", linear.get, unordered.get);
+		row("Miss", linear.miss, unordered.miss);
+	}
+
+	static std::vector<std::string> MakeStringKeys(const size_t count, const size_t length, const uint32_t seed)
+	{
+		std::mt19937_64 rng(seed);
+		std::vector<std::string> keys(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			// fixed length, but only the last 16 characters differ, like real ids with a common prefix
+			auto& key = keys[i];
+			key.assign(length, 'k');
+
+			auto bits = rng();
+			for (size_t c = 0; c < (std::min)(length, (size_t)16); ++c)
+			{
+				key[length - 1 - c] = static_cast<char>('a' + (bits & 15));
+				bits >>= 4;
+			}
+		}
+
+		return keys;
+	}
+
+	static void BenchmarkStringKeys(const size_t count)
+	{
+		for (const size_t length : { 8, 24, 64, 256 })
+		{
+			const auto keys = MakeStringKeys(count, length, 1234);
+			const auto missing = MakeStringKeys(count, length, 4321);
+			auto make_value = [](const size_t i) { return (int)i; };
+
+			LinearCoreMap<std::string, int> lmap;
+			const auto linear = TimeLinear(lmap, keys, missing, make_value);
+
+			std::unordered_map<std::string, int> umap;
+			const auto unordered = TimeUnordered(umap, keys, missing, make_value);
+
+			PrintKeyScenario("std::string[" + std::to_string(length) + "] -> int", linear, unordered);
+		}
+	}
+
+	template <class K, size_t(*Hash)(const K&), class MakeKey>
+	static void BenchmarkStructKey(const std::string& name, const size_t count, MakeKey&& make_key)
+	{
+		std::vector<K> keys(count);
+		std::vector<K> missing(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			keys[i] = make_key(i);
+			missing[i] = make_key(i + count);
+		}
+
+		auto make_value = [](const size_t i) { return (int)i; };
+
+		LinearCoreMap<K, int> lmap(Hash);
+		const auto linear = TimeLinear(lmap, keys, missing, make_value);
+
+		std::unordered_map<K, int, HashAdapter<K, Hash>> umap;
+		const auto unordered = TimeUnordered(umap, keys, missing, make_value);
+
+		PrintKeyScenario(name, linear, unordered);
+	}
+
+	/// <summary>
+	/// Large values with size_t keys. Every Resize moves all values into the new arrays.
+	/// </summary>
+	template <class V, class MakeValue>
+	static void BenchmarkLargeValue(const std::string& name, const size_t count, MakeValue&& make_value)
+	{
+		std::vector<size_t> keys(count);
+		std::vector<size_t> missing(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			keys[i] = i * 7 + 1;
+			missing[i] = i * 7 + 2;
+		}
+
+		LinearMap<V> lmap;
+		const auto linear = TimeLinear(lmap, keys, missing, make_value);
+
+		std::unordered_map<size_t, V> umap;
+		const auto unordered = TimeUnordered(umap, keys, missing, make_value);
+
+		PrintKeyScenario(name, linear, unordered);
+	}
+
+	/// <summary>
+	/// Runs the string and struct key scenarios, and large value scenarios for the given value types.
+	/// Value types are passed in by the caller, like the test structs in UnitTest.cpp.
+	/// </summary>
+	template <class... ValueScenarios>
+	static void BenchmarkKeyTypes(ValueScenarios&&... value_scenarios)
+	{
+		constexpr size_t count = 200'000;
+
+		std::cout << "\n--- Key/Value Type Benchmark (" << count << " elements) ---\n\n";
+		PrintKeyScenarioHeader();
+
+		BenchmarkStringKeys(count);
+
+		BenchmarkStructKey<Key16, &HashKey16>("Key16 (16 byte POD) -> int", count, [](const size_t i)
+			{
+				return Key16{ i, ~i };
+			});
+
+		BenchmarkStructKey<Key32, &HashKey32>("Key32 (32 byte POD) -> int", count, [](const size_t i)
+			{
+				return Key32{ i, ~i, i * 3, i ^ 0x5555 };
+			});
+
+		(value_scenarios(count), ...);
+	}
+}
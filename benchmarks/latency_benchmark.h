@@ -0,0 +1,106 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Lookup latency percentiles.
+	 *
+	 * Every Get is timed on its own, so the numbers include the clock overhead (~30-40ns for the two reads),
+	 * but the tail shows lookups that walk long clusters. Throughput benchmarks average those away.
+	 * All maps hold the same keys, ~0.69 of a 2^20 table, and look them up in random order.
+	 */
+
+	struct LookupLatency
+	{
+		double p50 = 0;   // ns
+		double p99 = 0;   // ns
+		double p9999 = 0; // ns
+		double max = 0;   // ns
+		double load = 0;
+	};
+
+	template <class Map>
+	static LookupLatency MeasureLookupLatency(const std::vector<uint64_t>& keys, const std::vector<size_t>& order)
+	{
+		Map map;
+		for (size_t i = 0; i < keys.size(); ++i)
+			map.Emplace(keys[i], (int)i);
+
+		std::vector<double> times(order.size());
+		size_t sum = 0;
+
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			sum += (size_t)map.Get(keys[order[i]]);
+			const auto end = std::chrono::steady_clock::now();
+			times[i] = std::chrono::duration<double, std::nano>(end - start).count();
+		}
+
+		DoNotOptimize(sum);
+		std::sort(times.begin(), times.end());
+
+		const auto at = [&times](const double percentile)
+			{
+				return times[(std::min)((size_t)(percentile * (double)times.size()), times.size() - 1)];
+			};
+
+		LookupLatency latency;
+		latency.p50 = at(0.5);
+		latency.p99 = at(0.99);
+		latency.p9999 = at(0.9999);
+		latency.max = times.back();
+		latency.load = map.LoadFactor();
+		return latency;
+	}
+
+	static void PrintLookupLatency(const std::string& name, const LookupLatency& latency)
+	{
+		PrintRow(name, latency.load, latency.p50, latency.p99, latency.p9999, latency.max);
+	}
+
+	static void BenchmarkLookupLatencyOn(const std::string& distribution, const std::vector<uint64_t>& keys)
+	{
+		std::vector<size_t> order(keys.size() * 2);
+		WorkloadRng rng{ 3 };
+		for (auto& i : order)
+			i = rng.Next() % keys.size();
+
+		std::cout << "\n" << distribution << ", " << keys.size() << " keys, " << order.size() << " lookups\n";
+		PrintRow("Container", "Load", "p50(ns)", "p99", "p99.99", "max");
+
+		PrintLookupLatency("LinearMap<int>", MeasureLookupLatency<LinearMap<int>>(keys, order));
+		PrintLookupLatency("HopscotchLinearMap<uint64_t, int>", MeasureLookupLatency<HopscotchLinearMap<uint64_t, int>>(keys, order));
+		PrintLookupLatency("LinearCuckooMap<uint64_t, int, 4>", MeasureLookupLatency<LinearCuckooMap<uint64_t, int, 4>>(keys, order));
+		PrintLookupLatency("LinearCuckooMap<uint64_t, int, 8>", MeasureLookupLatency<LinearCuckooMap<uint64_t, int, 8>>(keys, order));
+	}
+
+	static void BenchmarkLookupLatency()
+	{
+		std::cout << "\n--- Lookup Latency Benchmark ---\n";
+
+		const auto count = (size_t)((double)(1 << 20) * 0.69);
+		std::vector<uint64_t> keys(count);
+
+		WorkloadRng rng{ 17 };
+		for (auto& key : keys)
+			key = rng.Next();
+		BenchmarkLookupLatencyOn("Random", keys);
+
+		for (size_t i = 0; i < count; ++i)
+			keys[i] = i * 1024; // long clusters with the golden ratio hash
+		BenchmarkLookupLatencyOn("Stride 1024", keys);
+	}
+}
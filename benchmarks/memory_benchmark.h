@@ -0,0 +1,269 @@
+#pragma once
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Memory efficiency per container, over a sweep of element counts.
+	 *
+	 * Capacity is always rounded up to a power of two (FormatCapacity), and the map grows
+	 * once the load factor passes 0.7. So the bytes per entry follow a sawtooth: lowest
+	 * right before a resize, and doubled right after it.
+	 *
+	 *   model - capacity * slot bytes / size, what the arrays should cost
+	 *   rss   - measured resident bytes / size, after all inserts
+	 *   peak  - measured high-water mark / size, includes the old + new arrays during Resize
+	 */
+
+	struct MemorySample
+	{
+		size_t count = 0;
+		size_t capacity = 0;   // slots, or buckets for std containers
+		double load = 0;
+		double model = 0;      // bytes per entry, 0 if unknown
+		double rss = 0;        // bytes per entry
+		double peak = -1;      // bytes per entry, negative if the platform can't reset the peak
+	};
+
+	template <class Map, class Fill, class Describe>
+	static MemorySample MeasureMemory(const size_t count, Fill&& fill, Describe&& describe)
+	{
+		MemorySample sample;
+		sample.count = count;
+
+		ProcessMemory::ReleaseFreeMemory();
+		const bool has_peak = ProcessMemory::ResetPeak();
+		const auto before = ProcessMemory::Query();
+
+		{
+			Map map;
+			fill(map, count);
+
+			const auto peak = ProcessMemory::Query().peak;
+
+			// arrays freed by Resize may still be resident inside the heap
+			ProcessMemory::ReleaseFreeMemory();
+			const auto after = ProcessMemory::Query();
+			const auto entries = static_cast<double>(count);
+
+			sample.rss = after.rss > before.rss ? static_cast<double>(after.rss - before.rss) / entries : 0.0;
+			if (has_peak)
+				sample.peak = peak > before.rss ? static_cast<double>(peak - before.rss) / entries : 0.0;
+
+			describe(map, sample);
+			DoNotOptimize(map);
+		}
+
+		return sample;
+	}
+
+	template <class Map>
+	static void DescribeLinear(const Map& map, MemorySample& sample, const size_t slot_bytes)
+	{
+		sample.capacity = map.Capacity();
+		sample.load = map.LoadFactor();
+		sample.model = static_cast<double>(map.Capacity() * slot_bytes) / static_cast<double>(map.Size());
+	}
+
+	template <class Map>
+	static void DescribeUnordered(const Map& map, MemorySample& sample)
+	{
+		sample.capacity = map.bucket_count();
+		sample.load = map.load_factor();
+	}
+
+	static void PrintMemorySamples(const char* name, const std::vector<MemorySample>& samples)
+	{
+		std::cout << "\n" << name << "\n";
+		PrintRow("Elements", "Capacity", "Load", "Model(B)", "RSS(B)", "Peak(B)");
+
+		const auto bytes = [](const double value)
+			{
+				std::ostringstream out;
+				out << std::fixed << std::setprecision(1) << value;
+				return out.str();
+			};
+
+		double min_rss = 1e300;
+		double max_rss = 0;
+
+		for (const auto& sample : samples)
+		{
+			PrintRow(std::to_string(sample.count), sample.capacity, sample.load,
+				sample.model > 0 ? bytes(sample.model) : "-", bytes(sample.rss), sample.peak >= 0 ? bytes(sample.peak) : "n/a");
+
+			if (sample.rss > 0)
+			{
+				min_rss = (std::min)(min_rss, sample.rss);
+				max_rss = (std::max)(max_rss, sample.rss);
+			}
+		}
+
+		if (max_rss > 0)
+			std::cout << "RSS bytes per entry: min " << bytes(min_rss) << ", max " << bytes(max_rss) << "\n";
+	}
+
+	/// <summary>
+	/// Generates 'count' distinct, scattered keys.
+	/// </summary>
+	static size_t MemoryBenchmarkKey(const size_t i) noexcept
+	{
+		return (i + 1) * 0x9E3779B97F4A7C15ull;
+	}
+
+	static void BenchmarkMemoryUsage()
+	{
+		// small counts are dominated by allocator noise, so start at 16k
+		std::vector<size_t> counts;
+		for (double n = 16'384; n <= 2'000'000; n *= 1.25)
+			counts.push_back(static_cast<size_t>(n));
+
+		std::vector<MemorySample> linear_map, hopscotch_map, core_map, set, unordered_map, unordered_set;
+
+		for (const auto count : counts)
+		{
+			linear_map.push_back(MeasureMemory<LinearMap<int>>(count,
+				[](LinearMap<int>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map.Emplace(MemoryBenchmarkKey(i), (int)i);
+				},
+				[](const LinearMap<int>& map, MemorySample& sample)
+				{
+					DescribeLinear(map, sample, sizeof(size_t) + sizeof(int) + sizeof(uint8_t));
+				}));
+
+			hopscotch_map.push_back(MeasureMemory<HopscotchLinearMap<size_t, int>>(count,
+				[](HopscotchLinearMap<size_t, int>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map.Emplace(MemoryBenchmarkKey(i), (int)i);
+				},
+				[](const HopscotchLinearMap<size_t, int>& map, MemorySample& sample)
+				{
+					DescribeLinear(map, sample, sizeof(size_t) + sizeof(int) + sizeof(uint8_t) + sizeof(uint64_t));
+				}));
+
+			core_map.push_back(MeasureMemory<LinearCoreMap<uint32_t, uint32_t>>(count,
+				[](LinearCoreMap<uint32_t, uint32_t>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map.Emplace((uint32_t)MemoryBenchmarkKey(i), (uint32_t)i);
+				},
+				[](const LinearCoreMap<uint32_t, uint32_t>& map, MemorySample& sample)
+				{
+					DescribeLinear(map, sample, sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint8_t));
+				}));
+
+			set.push_back(MeasureMemory<LinearSet<size_t>>(count,
+				[](LinearSet<size_t>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map.Emplace(MemoryBenchmarkKey(i));
+				},
+				[](const LinearSet<size_t>& map, MemorySample& sample)
+				{
+					DescribeLinear(map, sample, sizeof(size_t) + sizeof(uint8_t));
+				}));
+
+			unordered_map.push_back(MeasureMemory<std::unordered_map<size_t, int>>(count,
+				[](std::unordered_map<size_t, int>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map[MemoryBenchmarkKey(i)] = (int)i;
+				},
+				[](const std::unordered_map<size_t, int>& map, MemorySample& sample)
+				{
+					DescribeUnordered(map, sample);
+				}));
+
+			unordered_set.push_back(MeasureMemory<std::unordered_set<size_t>>(count,
+				[](std::unordered_set<size_t>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map.insert(MemoryBenchmarkKey(i));
+				},
+				[](const std::unordered_set<size_t>& map, MemorySample& sample)
+				{
+					DescribeUnordered(map, sample);
+				}));
+		}
+
+		std::cout << "\n--- Memory Benchmark (bytes per entry) ---\n";
+
+		if (!ProcessMemory::ResetPeak())
+			std::cout << "Peak RSS can't be reset on this platform, peak column unavailable.\n";
+
+		PrintMemorySamples("LinearMap<int>", linear_map);
+		PrintMemorySamples("HopscotchLinearMap<size_t, int>", hopscotch_map);
+		PrintMemorySamples("LinearCoreMap<uint32_t, uint32_t>", core_map);
+		PrintMemorySamples("LinearSet<size_t>", set);
+		PrintMemorySamples("std::unordered_map<size_t, int>", unordered_map);
+		PrintMemorySamples("std::unordered_set<size_t>", unordered_set);
+	}
+
+	/// <summary>
+	/// JSON like metadata with a small set of distinct values, about 100 bytes each.
+	/// </summary>
+	static std::string MemoryBenchmarkBlob(const size_t i)
+	{
+		const auto kind = (i * 0x9E3779B97F4A7C15ull >> 32) % 2000;
+		return "{\"type\":\"record\",\"schema\":" + std::to_string(kind % 40) + ",\"owner\":\"team-" + std::to_string(kind)
+			+ "\",\"flags\":[\"indexed\",\"replicated\"],\"ttl\":86400}";
+	}
+
+	/// <summary>
+	/// Large values that repeat, stored per key and dictionary encoded.
+	/// </summary>
+	static void BenchmarkDictionaryMemory()
+	{
+		std::vector<size_t> counts;
+		for (double n = 16'384; n <= 2'000'000; n *= 2)
+			counts.push_back(static_cast<size_t>(n));
+
+		std::vector<MemorySample> core_map, dictionary_map;
+
+		for (const auto count : counts)
+		{
+			core_map.push_back(MeasureMemory<LinearCoreMap<size_t, std::string>>(count,
+				[](LinearCoreMap<size_t, std::string>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map.Emplace(MemoryBenchmarkKey(i), MemoryBenchmarkBlob(i));
+				},
+				[](const LinearCoreMap<size_t, std::string>& map, MemorySample& sample)
+				{
+					DescribeLinear(map, sample, sizeof(size_t) + sizeof(std::string) + sizeof(uint8_t));
+				}));
+
+			dictionary_map.push_back(MeasureMemory<DictionaryLinearMap<size_t, std::string>>(count,
+				[](DictionaryLinearMap<size_t, std::string>& map, const size_t n)
+				{
+					for (size_t i = 0; i < n; ++i)
+						map.Emplace(MemoryBenchmarkKey(i), MemoryBenchmarkBlob(i));
+				},
+				[](const DictionaryLinearMap<size_t, std::string>& map, MemorySample& sample)
+				{
+					sample.capacity = map.Capacity();
+					sample.load = (double)map.Size() / (double)map.Capacity();
+				}));
+		}
+
+		std::cout << "\n--- Dictionary Memory Benchmark (bytes per entry, ~100 byte values, 2000 distinct) ---\n";
+
+		PrintMemorySamples("LinearCoreMap<size_t, std::string>", core_map);
+		PrintMemorySamples("DictionaryLinearMap<size_t, std::string>", dictionary_map);
+	}
+}
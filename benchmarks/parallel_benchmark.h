@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LinearMap.h"
+#include "LinearMapThreads.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * The parallel map operations on a WorkStealingPool against their serial versions.
+	 *
+	 *   EmplaceAll - insert random keys into a presized map
+	 *   Rehash     - move every entry into a table twice as large
+	 *   scan       - sum the values, ForEachInSlots over the ranges of the executor
+	 *   EraseIf    - erase every fourth key
+	 *
+	 * A pool of one thread runs the region sort of the parallel inserts, without any threads to share it.
+	 */
+
+	struct ParallelTimes
+	{
+		double emplace = 0; // ms
+		double rehash = 0;  // ms
+		double for_each = 0; // ms
+		double erase = 0;   // ms
+	};
+
+	template <class Executor>
+	static ParallelTimes TimeParallel(const std::vector<uint64_t>& keys, Executor&& executor)
+	{
+		ParallelTimes times;
+		auto input = keys;
+		std::vector<uint64_t> values(keys.size(), 1);
+
+		LinearCoreMap<uint64_t, uint64_t> map((size_t)((double)keys.size() / map.MaxLoadFactor()) + 1);
+		Timer timer;
+		map.EmplaceAll(input.data(), values.data(), input.size(), executor);
+		times.emplace = timer.ElapsedMs();
+
+		timer.Restart();
+		map.Rehash(map.Capacity() * 2, executor);
+		times.rehash = timer.ElapsedMs();
+
+		std::atomic<uint64_t> sum = 0;
+		timer.Restart();
+		executor(map.Capacity(), [&](const size_t first, const size_t last)
+			{
+				uint64_t part = 0;
+				map.ForEachInSlots(first, last, [&](const uint64_t&, const uint64_t& value) { part += value; });
+				sum += part;
+			});
+		times.for_each = timer.ElapsedMs();
+
+		timer.Restart();
+		const auto erased = map.EraseIf([](const uint64_t& key, const uint64_t&) { return key % 4 == 0; }, executor);
+		times.erase = timer.ElapsedMs();
+
+		DoNotOptimize(sum.load());
+		DoNotOptimize(erased);
+		return times;
+	}
+
+	static void PrintParallelTimes(const std::string& name, const ParallelTimes& times)
+	{
+		PrintRow(name, times.emplace, times.rehash, times.for_each, times.erase);
+	}
+
+	static void BenchmarkParallel(const size_t count = 8'000'000)
+	{
+		std::cout << "\n--- Parallel Operations Benchmark ---\n";
+
+		std::vector<uint64_t> keys(count);
+		WorkloadRng rng{ 59 };
+		for (auto& key : keys)
+			key = rng.Next();
+
+		std::cout << "\n" << count << " keys, " << std::thread::hardware_concurrency() << " hardware threads\n";
+		PrintRow("Executor", "emplace(ms)", "rehash(ms)", "scan(ms)", "erase(ms)");
+
+		PrintParallelTimes("serial", TimeParallel(keys, Internal::SerialExecutor{}));
+
+		for (const unsigned threads : { 1u, 4u, std::thread::hardware_concurrency() })
+		{
+			if (threads == std::thread::hardware_concurrency() && (threads == 1 || threads == 4))
+				continue; // printed already
+
+			WorkStealingPool pool(threads);
+			PrintParallelTimes("WorkStealingPool(" + std::to_string(threads) + ")", TimeParallel(keys, pool));
+		}
+	}
+}
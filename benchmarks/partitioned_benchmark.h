@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * One large LinearCoreMap against a PartitionedLinearMap, as the build and probe side of a hash join.
+	 *
+	 *   build - insert every key of the build side
+	 *   probe - look up as many random keys, about half of them hit
+	 *
+	 * The tables are far larger than the last level cache, so a single lookup of the large map misses
+	 * in cache and TLB. The batch operations of the partitioned map sort the keys by partition first,
+	 * after that every lookup finds its partition in L2.
+	 */
+
+	struct JoinTimes
+	{
+		double build = 0; // ms
+		double probe = 0; // ms
+	};
+
+	static void PrintJoinTimes(const std::string& name, const size_t count, const JoinTimes& times)
+	{
+		PrintRow(name, times.build, (double)count / (times.build * 1000.0),
+			times.probe, (double)count / (times.probe * 1000.0));
+	}
+
+	template <class Map>
+	static JoinTimes TimeJoinSingle(Map& map, const std::vector<uint64_t>& build, const std::vector<uint64_t>& probe)
+	{
+		JoinTimes times;
+		size_t sum = 0;
+
+		Timer timer;
+		for (size_t i = 0; i < build.size(); ++i)
+			map.Emplace(build[i], (uint64_t)i);
+		times.build = timer.ElapsedMs();
+
+		timer.Restart();
+		for (const auto key : probe)
+			sum += map.Get(key);
+		times.probe = timer.ElapsedMs();
+
+		DoNotOptimize(sum);
+		return times;
+	}
+
+	static JoinTimes TimeJoinBatch(const std::vector<uint64_t>& build, const std::vector<uint64_t>& probe)
+	{
+		JoinTimes times;
+		PartitionedLinearMap<uint64_t, uint64_t> map(build.size());
+
+		auto keys = build;
+		std::vector<uint64_t> values(build.size());
+		for (size_t i = 0; i < values.size(); ++i)
+			values[i] = i;
+
+		Timer timer;
+		map.EmplaceAll(keys.data(), values.data(), keys.size());
+		times.build = timer.ElapsedMs();
+
+		std::vector<uint64_t> out(probe.size());
+		timer.Restart();
+		const auto hits = map.GetAll(probe.data(), out.data(), probe.size());
+		times.probe = timer.ElapsedMs();
+
+		DoNotOptimize(hits);
+		DoNotOptimize(out[probe.size() / 2]);
+		return times;
+	}
+
+	static void BenchmarkPartitioned(const size_t count = 8'000'000)
+	{
+		std::cout << "\n--- Partitioned Map Benchmark ---\n";
+
+		std::vector<uint64_t> build(count), probe(count);
+		WorkloadRng rng{ 31 };
+		for (auto& key : build)
+			key = rng.Next();
+		for (size_t i = 0; i < count; ++i)
+			probe[i] = (i & 1) ? build[rng.Next() % count] : rng.Next();
+
+		std::cout << "\n" << count << " keys, " << count << " lookups\n";
+		PrintRow("Container", "build(ms)", "Mops/s", "probe(ms)", "Mops/s");
+
+		{
+			LinearCoreMap<uint64_t, uint64_t> map((size_t)((double)count / map.MaxLoadFactor()) + 1);
+			PrintJoinTimes("LinearCoreMap<uint64_t, uint64_t>", count, TimeJoinSingle(map, build, probe));
+		}
+		{
+			PartitionedLinearMap<uint64_t, uint64_t> map(count);
+			PrintJoinTimes("PartitionedLinearMap, single keys", count, TimeJoinSingle(map, build, probe));
+		}
+		PrintJoinTimes("PartitionedLinearMap, batches", count, TimeJoinBatch(build, probe));
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "key_benchmark.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Probing policies per key distribution.
+	 *
+	 *   insert - Emplace of every key into an empty map
+	 *   hit    - Get of every key
+	 *   miss   - Contains of keys that aren't in the map
+	 *   erase  - Erase of every other key, then 'hit' again over the remaining keys and tombstones
+	 *
+	 * The golden ratio hash keeps the low bits of strided keys close together, which is where
+	 * linear probing builds long clusters and the other probings should win.
+	 * HopscotchLinearMap hashes integers with Splitmix64 instead, strided keys cost it nothing extra.
+	 */
+
+	constexpr MapPolicy linear_probing{};
+	constexpr MapPolicy triangular_probing{ .probing = ProbingPolicy::Triangular };
+	constexpr MapPolicy group_probing{ .probing = ProbingPolicy::GroupLinear };
+
+	struct ProbingTimes
+	{
+		double insert = 0; // ms
+		double hit = 0;    // ms
+		double miss = 0;   // ms
+		double erase = 0;  // ms, erase plus the lookups after it
+	};
+
+	template <class Map, class K>
+	static ProbingTimes TimeProbing(const std::vector<K>& keys, const std::vector<K>& missing)
+	{
+		ProbingTimes times;
+		size_t found = 0;
+		Map map;
+
+		Timer timer;
+		for (size_t i = 0; i < keys.size(); ++i)
+			map.Emplace(keys[i], (int)i);
+		times.insert = timer.ElapsedMs();
+
+		timer.Restart();
+		for (const auto& key : keys)
+			found += (size_t)map.Get(key);
+		times.hit = timer.ElapsedMs();
+
+		timer.Restart();
+		for (const auto& key : missing)
+			found += map.Contains(key);
+		times.miss = timer.ElapsedMs();
+
+		timer.Restart();
+		for (size_t i = 0; i < keys.size(); i += 2)
+			found += map.Erase(keys[i]);
+		for (size_t i = 1; i < keys.size(); i += 2)
+			found += (size_t)map.Get(keys[i]);
+		times.erase = timer.ElapsedMs();
+
+		DoNotOptimize(found);
+		return times;
+	}
+
+	static void PrintProbingTimes(const std::string& name, const ProbingTimes& times)
+	{
+		PrintRow(name, times.insert, times.hit, times.miss, times.erase);
+	}
+
+	/// <summary>
+	/// Runs the probing policies and the bounded probing maps on one key distribution.
+	/// </summary>
+	template <class K>
+	static void BenchmarkProbingOn(const std::string& distribution, const std::vector<K>& keys, const std::vector<K>& missing)
+	{
+		std::cout << "\n" << distribution << ", " << keys.size() << " keys\n";
+		PrintRow("Probing", "insert(ms)", "hit(ms)", "miss(ms)", "erase(ms)");
+
+		PrintProbingTimes("Linear", TimeProbing<LinearCoreMap<K, int, linear_probing>>(keys, missing));
+		PrintProbingTimes("Triangular", TimeProbing<LinearCoreMap<K, int, triangular_probing>>(keys, missing));
+		PrintProbingTimes("GroupLinear", TimeProbing<LinearCoreMap<K, int, group_probing>>(keys, missing));
+		PrintProbingTimes("HopscotchLinearMap", TimeProbing<HopscotchLinearMap<K, int>>(keys, missing));
+		PrintProbingTimes("LinearCuckooMap", TimeProbing<LinearCuckooMap<K, int>>(keys, missing));
+	}
+
+	static void BenchmarkProbing(const size_t count = 1'000'000)
+	{
+		std::cout << "\n--- Probing Policy Benchmark ---\n";
+
+		std::vector<uint64_t> keys(count), missing(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			keys[i] = i;
+			missing[i] = i + count;
+		}
+		BenchmarkProbingOn("Sequential", keys, missing);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			keys[i] = i * 1024;
+			missing[i] = i * 1024 + 512;
+		}
+		BenchmarkProbingOn("Stride 1024", keys, missing);
+
+		WorkloadRng rng{ 11 };
+		for (size_t i = 0; i < count; ++i)
+		{
+			keys[i] = rng.Next();
+			missing[i] = rng.Next();
+		}
+		BenchmarkProbingOn("Random", keys, missing);
+
+		BenchmarkProbingOn("Strings (24 chars)", MakeStringKeys(count / 4, 24, 1234), MakeStringKeys(count / 4, 24, 4321));
+	}
+}
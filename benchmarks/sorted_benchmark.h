@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LinearMap.h"
+#include "LinearMapThreads.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Reading a map in key order, the time to get the sorted entries into a std::vector.
+	 *
+	 *   copy + std::sort    - copy the entries through the Iterator, std::sort by key
+	 *   ExtractSorted       - after a change of the map, it radix sorts the slots
+	 *   ExtractSorted, kept - the map hasn't changed since the last call, only the copy
+	 *   SortedView, kept    - the same without the copy, summing the values in order
+	 *
+	 * Every row but the kept ones emplaces one new key first, like a report between writes.
+	 */
+
+	template <class Read>
+	static void TimeSorted(const std::string& name, const int repeat, Read&& read)
+	{
+		Timer timer;
+		for (int r = 0; r < repeat; ++r)
+			read(r);
+		PrintRow(name, timer.ElapsedMs() / repeat);
+	}
+
+	static void BenchmarkSorted(const size_t count = 4'000'000, const int repeat = 3)
+	{
+		std::cout << "\n--- Sorted Extraction Benchmark ---\n";
+
+		LinearCoreMap<uint64_t, uint64_t> map;
+		WorkloadRng rng{ 67 };
+		for (size_t i = 0; i < count; ++i)
+			map.Emplace(rng.Next(), i);
+
+		std::cout << "\n" << map.Size() << " entries, " << std::thread::hardware_concurrency() << " hardware threads, ms per read\n";
+		PrintRow("Read", "time(ms)");
+
+		std::vector<std::pair<uint64_t, uint64_t>> out;
+		const auto change = [&](const int r) { map.Emplace(rng.Next(), (uint64_t)r); };
+
+		TimeSorted("copy + std::sort", repeat, [&](const int r)
+			{
+				change(r);
+				out.clear();
+				out.reserve(map.Size());
+				for (auto [key, value] : map)
+					out.emplace_back(key, value);
+				std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+				DoNotOptimize(out.data());
+			});
+
+		TimeSorted("ExtractSorted", repeat, [&](const int r)
+			{
+				change(r);
+				map.ExtractSorted(out);
+				DoNotOptimize(out.data());
+			});
+
+		WorkStealingPool pool;
+		TimeSorted("ExtractSorted, WorkStealingPool(" + std::to_string(pool.Threads()) + ")", repeat, [&](const int r)
+			{
+				change(r);
+				map.ExtractSorted(out, pool);
+				DoNotOptimize(out.data());
+			});
+
+		TimeSorted("ExtractSorted, kept", repeat, [&](int)
+			{
+				map.ExtractSorted(out);
+				DoNotOptimize(out.data());
+			});
+
+		TimeSorted("SortedView, kept", repeat, [&](int)
+			{
+				uint64_t sum = 0;
+				for (auto [key, value] : map.SortedView())
+					sum += value;
+				DoNotOptimize(sum);
+			});
+	}
+}
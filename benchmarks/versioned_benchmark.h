@@ -0,0 +1,169 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Consistent scans over a map that keeps taking updates, the way analytics queries read a live map.
+	 *
+	 *   updates - a stream of Emplace and Erase on random keys
+	 *   queries - every 'query_every' updates, one query sums all values of a consistent view
+	 *
+	 * LinearCoreMap has to deep copy the map for every query, then scans the copy.
+	 * VersionedLinearMap takes a snapshot and scans it in pieces between the updates, so the updates
+	 * go on during the query, and only the versions replaced meanwhile are kept.
+	 */
+
+	struct ScanTimes
+	{
+		double updates_only = 0; // ms, the update stream without queries
+		double with_queries = 0; // ms, updates and queries
+		size_t checksum = 0;     // sum of the query results, the same for both maps
+	};
+
+	static void PrintScanTimes(const std::string& name, const size_t updates, const ScanTimes& times)
+	{
+		PrintRow(name, times.updates_only, (double)updates / (times.updates_only * 1000.0),
+			times.with_queries, (double)updates / (times.with_queries * 1000.0), times.checksum);
+	}
+
+	/// <summary>
+	/// Update 'i' of the stream: erases one key in eight, writes the others.
+	/// </summary>
+	template <class Map>
+	static void ApplyUpdate(Map& map, WorkloadRng& rng, const size_t keys, const size_t i)
+	{
+		const auto key = rng.Next() % keys;
+		if ((i & 7) == 7)
+			map.Erase(key);
+		else
+			map.Emplace(key, (uint64_t)i);
+	}
+
+	template <class Map>
+	static void FillForScan(Map& map, const size_t keys)
+	{
+		for (size_t key = 0; key < keys; ++key)
+			map.Emplace((uint64_t)key, (uint64_t)key);
+	}
+
+	static ScanTimes TimeCopyScans(const size_t keys, const size_t updates, const size_t query_every)
+	{
+		ScanTimes times;
+		{
+			LinearCoreMap<uint64_t, uint64_t> map(keys * 2);
+			FillForScan(map, keys);
+
+			WorkloadRng rng{ 41 };
+			Timer timer;
+			for (size_t i = 0; i < updates; ++i)
+				ApplyUpdate(map, rng, keys, i);
+			times.updates_only = timer.ElapsedMs();
+		}
+
+		LinearCoreMap<uint64_t, uint64_t> map(keys * 2);
+		FillForScan(map, keys);
+
+		WorkloadRng rng{ 41 };
+		Timer timer;
+		for (size_t i = 0; i < updates; ++i)
+		{
+			if (i % query_every == 0)
+			{
+				const LinearCoreMap<uint64_t, uint64_t> view(map); // deep copy
+				size_t sum = 0;
+				for (const auto& [key, value] : view)
+					sum += value;
+				times.checksum += sum;
+			}
+
+			ApplyUpdate(map, rng, keys, i);
+		}
+		times.with_queries = timer.ElapsedMs();
+
+		return times;
+	}
+
+	static ScanTimes TimeSnapshotScans(const size_t keys, const size_t updates, const size_t query_every)
+	{
+		using Map = VersionedLinearMap<uint64_t, uint64_t>;
+		ScanTimes times;
+		{
+			Map map(keys * 2);
+			FillForScan(map, keys);
+
+			WorkloadRng rng{ 41 };
+			Timer timer;
+			for (size_t i = 0; i < updates; ++i)
+				ApplyUpdate(map, rng, keys, i);
+			times.updates_only = timer.ElapsedMs();
+		}
+
+		Map map(keys * 2);
+		FillForScan(map, keys);
+
+		// a query scans the snapshot in pieces, and finishes well before the next one starts
+		const size_t piece = 4096;
+		const size_t updates_per_piece = 16;
+
+		WorkloadRng rng{ 41 };
+		Timer timer;
+		Map::Snapshot snapshot;
+		size_t position = Internal::npos;
+		size_t sum = 0;
+
+		const auto scan_piece = [&]
+			{
+				position = snapshot.ForEachFrom(position, piece, [&sum](const uint64_t&, const uint64_t& value) { sum += value; });
+				if (position != Internal::npos)
+					return;
+
+				times.checksum += sum;
+				sum = 0;
+				snapshot.Release();
+			};
+
+		for (size_t i = 0; i < updates; ++i)
+		{
+			if (i % query_every == 0)
+			{
+				while (position != Internal::npos) // the last query didn't finish in time
+					scan_piece();
+
+				snapshot = map.TakeSnapshot();
+				position = 0;
+			}
+			else if (position != Internal::npos && i % updates_per_piece == 0)
+			{
+				scan_piece();
+			}
+
+			ApplyUpdate(map, rng, keys, i);
+		}
+
+		while (position != Internal::npos)
+			scan_piece();
+		times.with_queries = timer.ElapsedMs();
+
+		return times;
+	}
+
+	static void BenchmarkVersioned(const size_t keys = 1'000'000, const size_t updates = 8'000'000, const size_t query_every = 1'000'000)
+	{
+		std::cout << "\n--- Versioned Map Benchmark ---\n";
+		std::cout << "\n" << keys << " keys, " << updates << " updates, a consistent scan every " << query_every << " updates\n";
+		PrintRow("Container", "updates(ms)", "Mops/s", "+scans(ms)", "Mops/s", "checksum");
+
+		PrintScanTimes("LinearCoreMap, deep copy per scan", updates, TimeCopyScans(keys, updates, query_every));
+		PrintScanTimes("VersionedLinearMap, snapshot per scan", updates, TimeSnapshotScans(keys, updates, query_every));
+	}
+}
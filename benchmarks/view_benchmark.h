@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(LMAP_PARALLEL_STL) || defined(_MSC_VER)
+#include <execution>
+#endif
+
+#include "LinearMap.h"
+#include "LinearMapThreads.h"
+#include "benchmark_utils.h"
+#include "workload_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Summing the values of a map, through the Iterator and through the random access views.
+	 *
+	 *   Iterator           - range for over the map
+	 *   Values()           - creating the view, which lists the used slots, and std::reduce over it
+	 *   Slots()            - std::transform_reduce over every slot, skipping the empty ones
+	 *   par_unseq          - the same with std::execution::par_unseq, if the standard library has it
+	 *                        (MSVC, or libstdc++ with TBB: LMAP_PARALLEL_STL in CMakeLists.txt)
+	 *   WorkStealingPool   - Slots() split by index over a pool
+	 */
+
+	template <class Sum>
+	static void TimeViewSum(const std::string& name, const int repeat, Sum&& sum)
+	{
+		uint64_t total = 0;
+		Timer timer;
+		for (int r = 0; r < repeat; ++r)
+			total += sum();
+		PrintRow(name, timer.ElapsedMs() / repeat, total / repeat);
+		DoNotOptimize(total);
+	}
+
+	static void BenchmarkViews(const size_t count = 8'000'000, const int repeat = 5)
+	{
+		std::cout << "\n--- Range Views Benchmark ---\n";
+
+		LinearCoreMap<uint64_t, uint64_t> map;
+		WorkloadRng rng{ 61 };
+		for (size_t i = 0; i < count; ++i)
+			map.Emplace(rng.Next(), i & 0xffff);
+
+		std::cout << "\n" << map.Size() << " entries, " << map.Capacity() << " slots, "
+			<< std::thread::hardware_concurrency() << " hardware threads, ms per sum\n";
+		PrintRow("Loop", "sum(ms)", "sum");
+
+		const auto used_value = [](const auto& slot) { return slot.used ? slot.value : uint64_t{ 0 }; };
+
+		TimeViewSum("Iterator", repeat, [&]
+			{
+				uint64_t sum = 0;
+				for (auto [key, value] : map)
+					sum += value;
+				return sum;
+			});
+
+		TimeViewSum("Values(), std::reduce", repeat, [&]
+			{
+				const auto values = map.Values();
+				return std::reduce(values.begin(), values.end(), uint64_t{ 0 });
+			});
+
+		TimeViewSum("Slots(), std::transform_reduce", repeat, [&]
+			{
+				const auto slots = map.Slots();
+				return std::transform_reduce(slots.begin(), slots.end(), uint64_t{ 0 }, std::plus<>{}, used_value);
+			});
+
+#if defined(LMAP_PARALLEL_STL) || defined(_MSC_VER)
+		TimeViewSum("Slots(), par_unseq", repeat, [&]
+			{
+				const auto slots = map.Slots();
+				return std::transform_reduce(std::execution::par_unseq, slots.begin(), slots.end(), uint64_t{ 0 },
+					std::plus<>{}, used_value);
+			});
+#endif
+
+		WorkStealingPool pool;
+		TimeViewSum("Slots(), WorkStealingPool(" + std::to_string(pool.Threads()) + ")", repeat, [&]
+			{
+				const auto slots = map.Slots();
+				std::atomic<uint64_t> sum = 0;
+				pool(slots.size(), [&](const size_t first, const size_t last)
+					{
+						sum += std::transform_reduce(slots.begin() + first, slots.begin() + last, uint64_t{ 0 },
+							std::plus<>{}, used_value);
+					});
+				return sum.load();
+			});
+	}
+}
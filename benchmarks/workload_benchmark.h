@@ -0,0 +1,201 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "LinearMap.h"
+#include "benchmark_utils.h"
+#include "key_benchmark.h"
+
+namespace MapBenchmarks
+{
+	using namespace LinearProbing;
+
+	/*
+	 * Mixed operation workloads, used as the PGO training run and to compare builds.
+	 *
+	 * Every workload fills the map with half of its key set, then runs a deterministic
+	 * stream of Emplace/Get/Contains/Erase on random keys of the set, so about half of
+	 * the lookups hit. The same seed gives the same stream in every build.
+	 */
+
+	struct OperationMix
+	{
+		int emplace = 25;  // percent
+		int get = 25;
+		int contains = 25;
+		// the rest is Erase
+	};
+
+	struct WorkloadResult
+	{
+		std::string name;
+		size_t operations = 0;
+		double ms = 0;
+		size_t checksum = 0; // must match between builds
+	};
+
+	/// <summary>
+	/// xorshift64*, cheaper than mt19937, so the generator doesn't dominate the profile.
+	/// </summary>
+	struct WorkloadRng
+	{
+		uint64_t state;
+
+		uint64_t Next() noexcept
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+	};
+
+	template <class Map, class K>
+	static void WorkloadInsert(Map& map, const K& key, const size_t n)
+	{
+		if constexpr (requires(Map& m) { m.Emplace(key, 0); })
+			map.Emplace(key, (int)n);
+		else
+			map.Emplace(key);
+	}
+
+	template <class Map, class K>
+	static WorkloadResult RunWorkload(const std::string& name, Map& map, const std::vector<K>& keys,
+		const size_t operations, const OperationMix& mix)
+	{
+		constexpr bool has_get = requires(Map& m, const K& k) { m.Get(k); };
+
+		for (size_t i = 0; i < keys.size(); i += 2)
+			WorkloadInsert(map, keys[i], i);
+
+		WorkloadRng rng{ 0x9E3779B97F4A7C15ull ^ keys.size() };
+		size_t checksum = 0;
+		Timer timer;
+
+		for (size_t n = 0; n < operations; ++n)
+		{
+			const auto r = rng.Next();
+			const auto& key = keys[(r >> 8) % keys.size()];
+			const int op = (int)(r % 100);
+
+			if (op < mix.emplace)
+			{
+				WorkloadInsert(map, key, n);
+			}
+			else if (op < mix.emplace + mix.get)
+			{
+				if constexpr (has_get)
+				{
+					const auto& value = map.Get(key);
+					if (map.IsValid(value))
+						checksum += (size_t)value;
+				}
+				else
+				{
+					checksum += map.Contains(key);
+				}
+			}
+			else if (op < mix.emplace + mix.get + mix.contains)
+			{
+				checksum += map.Contains(key);
+			}
+			else
+			{
+				checksum += map.Erase(key);
+			}
+		}
+
+		WorkloadResult result;
+		result.name = name;
+		result.operations = operations;
+		result.ms = timer.ElapsedMs();
+		result.checksum = checksum + map.Size();
+		DoNotOptimize(result.checksum);
+		return result;
+	}
+
+	static std::vector<uint64_t> MakeIntegerKeys(const size_t count, const uint64_t seed)
+	{
+		WorkloadRng rng{ seed };
+		std::vector<uint64_t> keys(count);
+
+		// half random, half strided like ids
+		for (size_t i = 0; i < count; ++i)
+			keys[i] = (i & 1) ? rng.Next() : i * 64 + 1;
+
+		return keys;
+	}
+
+	/// <summary>
+	/// Runs all workloads once. 'scale' multiplies key counts and operations,
+	/// 1.0 takes a few seconds per workload set.
+	/// </summary>
+	inline std::vector<WorkloadResult> RunMapWorkloads(const double scale)
+	{
+		const auto scaled = [scale](const size_t n) { return (std::max)((size_t)(n * scale), (size_t)64); };
+
+		constexpr OperationMix read_heavy{ 10, 45, 40 };
+		constexpr OperationMix churn{ 40, 10, 10 };
+		constexpr OperationMix set_mix{ 30, 0, 50 };
+
+		std::vector<WorkloadResult> results;
+
+		const auto int_keys = MakeIntegerKeys(scaled(1'000'000), 1234);
+		const auto small_keys = MakeIntegerKeys(4096, 99);
+		const auto string_keys = MakeStringKeys(scaled(200'000), 24, 1234);
+
+		{
+			LinearMap<int> map;
+			results.push_back(RunWorkload("LinearMap<int> read-heavy", map, int_keys, int_keys.size() * 4, read_heavy));
+		}
+		{
+			LinearMap<int> map;
+			results.push_back(RunWorkload("LinearMap<int> churn", map, int_keys, int_keys.size() * 4, churn));
+		}
+		{
+			LinearCoreMap<uint32_t, uint32_t> map;
+			std::vector<uint32_t> keys(small_keys.begin(), small_keys.end());
+			results.push_back(RunWorkload("LinearCoreMap<u32,u32> L1", map, keys, scaled(4'000'000), churn));
+		}
+		{
+			LinearCoreMap<std::string, int> map;
+			results.push_back(RunWorkload("LinearCoreMap<string,int> read", map, string_keys, string_keys.size() * 4, read_heavy));
+		}
+		{
+			LinearCoreMap<std::string, int> map;
+			results.push_back(RunWorkload("LinearCoreMap<string,int> churn", map, string_keys, string_keys.size() * 4, churn));
+		}
+		{
+			LinearSet<uint64_t> set;
+			results.push_back(RunWorkload("LinearSet<uint64_t> mixed", set, int_keys, int_keys.size() * 4, set_mix));
+		}
+
+		return results;
+	}
+
+	inline void PrintWorkloadResults(const std::vector<WorkloadResult>& results)
+	{
+		PrintRow("Workload", "Ops", "ms", "Mops/s");
+
+		for (const auto& result : results)
+			PrintRow(result.name, result.operations, result.ms, (double)result.operations / (result.ms * 1000.0));
+	}
+
+	/// <summary>
+	/// Writes 'name<TAB>ms<TAB>checksum' lines, read back by scripts/pgo_build.sh.
+	/// </summary>
+	inline bool WriteWorkloadReport(const std::string& path, const std::vector<WorkloadResult>& results)
+	{
+		std::ofstream out(path);
+		if (!out)
+			return false;
+
+		for (const auto& result : results)
+			out << result.name << "\t" << std::fixed << std::setprecision(3) << result.ms << "\t" << result.checksum << "\n";
+
+		return (bool)out;
+	}
+}
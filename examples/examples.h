@@ -4,7 +4,9 @@
 #include <vector>
 #include <tuple>
 #include <string>
+#if __has_include(<format>)
 #include <format>
+#endif
 
 #include "LinearMap.h"
 
@@ -195,7 +197,11 @@ namespace MapExamples
 
 		auto print_location = [](Coordinates& location)
 			{
+#if defined(__cpp_lib_format)
 				std::cout << std::format("x: {}, y: {}, z: {}\n", location.x, location.y, location.z);
+#else
+				std::cout << "x: " << location.x << ", y: " << location.y << ", z: " << location.z << "\n";
+#endif
 			};
 
 		Coordinates& location1 = navigation.Get(8);
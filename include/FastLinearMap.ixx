@@ -0,0 +1,49 @@
+/*
+FastLinearMap as a C++20 named module.
+
+	import FastLinearMap;
+
+	LinearProbing::LinearMap<int> map;
+
+The header is included in lean mode, so importers don't get <iostream> and friends,
+nor the likely/unlikely/UNREACHABLE macros.
+*/
+
+module;
+
+#define LMAP_LEAN
+#include "LinearMap.h"
+
+export module FastLinearMap;
+
+export namespace LinearProbing
+{
+	using LinearProbing::LinearMap;
+	using LinearProbing::LinearCoreMap;
+	using LinearProbing::LinearSet;
+	using LinearProbing::HopscotchLinearMap;
+	using LinearProbing::LinearCuckooMap;
+	using LinearProbing::PartitionedLinearMap;
+	using LinearProbing::VersionedLinearMap;
+	using LinearProbing::CopyOnWrite;
+	using LinearProbing::SharedLinearMap;
+	using LinearProbing::SharedLinearSet;
+	using LinearProbing::MappedLinearMap;
+	using LinearProbing::MappedLinearSet;
+	using LinearProbing::DictionaryLinearMap;
+	using LinearProbing::CompactLinearSet;
+	using LinearProbing::MapPolicy;
+	using LinearProbing::DeletionPolicy;
+	using LinearProbing::ProbingPolicy;
+	using LinearProbing::HitReordering;
+
+	namespace Internal
+	{
+		using LinearProbing::Internal::HashFunction;
+		using LinearProbing::Internal::HashMixer;
+		using LinearProbing::Internal::HashMixerName;
+		using LinearProbing::Internal::MixHash;
+		using LinearProbing::Internal::LinearHash;
+		using LinearProbing::Internal::LinearCoreMapImpl;
+	}
+}
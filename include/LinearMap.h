@@ -10,18 +10,56 @@ This file includes the following classes:
 LinearMap<T>          - A linear probing hash map with size_t keys and T values.
 LinearCoreMap<K,V>	  - A linear probing hash map with K keys and V values.
 LinearSet<K>		  - A linear probing hash set with K keys.
+HopscotchLinearMap<K,V> - A hopscotch hash map with K keys and V values, bounded lookups, load factor 0.9.
+LinearCuckooMap<K,V>  - A bucketized cuckoo hash map with K keys and V values, lookups read at most two buckets.
+PartitionedLinearMap<K,V> - Many small LinearCoreMaps, picked by the top hash bits, with batch operations
+                        that run one partition at a time. For maps far beyond the last level cache.
+VersionedLinearMap<K,V> - A linear probing hash map that keeps older versions for snapshots (MVCC),
+                        consistent reads without copying the map.
+SharedLinearMap<K,V>, SharedLinearSet<K> - Copy on write handles (CopyOnWrite<Map>), copies share one
+                        map until they are written.
+MappedLinearMap<K,V>, MappedLinearSet<K> - A read only linear probing hash map or set in a caller provided
+                        memory region, e.g. shared memory, that any process can attach to.
+DictionaryLinearMap<K,V> - A linear probing hash map that stores every distinct value once, for large values
+                        that repeat.
+CompactLinearSet<K>   - An immutable, bit packed hash set of integer keys, a few bytes per key.
+
+Build options:
+
+LMAP_LEAN                  - Leaves out <iostream>, <fstream>, <iomanip> and <optional>, which the
+                             maps don't need. Use it if you include this header in many files.
+                             <vector> (slot lists of the views, parallel inserts, the versions),
+                             <span> (the 'ExportTo' columns) and <utility> stay, the maps use them.
+LMAP_EXTERN_TEMPLATES      - Declares the common instantiations (LinearMap<int>, LinearSet<uint64_t>)
+                             extern, so including files don't compile them again.
+LMAP_INSTANTIATE_TEMPLATES - Define it in exactly one source file, to compile those instantiations.
+LMAP_TRACE                 - Reports every Erase to 'Internal::erase_trace' (probes, shifted entries).
+
+FastLinearMap.ixx wraps this header into the C++20 module 'FastLinearMap'.
 
 */
 
 #pragma once
 #include <tuple>
+#include <memory>
+#include <cstring>
+#include <string>
+#include <stdexcept>
 #include <functional>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <vector>
+#include <utility>
+
+#if !defined(LMAP_LEAN)
 #include <iostream>
 #include <fstream>
 #include <optional>
-#include <bit>
-#include <algorithm>
 #include <iomanip>
+#endif
 
 #if defined(__clang__) or defined(__GNUC__)
 #define OPTIMIZED
@@ -32,6 +70,16 @@ LinearSet<K>		  - A linear probing hash set with K keys.
 #define UNREACHABLE() ((void)0) // fallback
 #endif
 
+#if defined(__clang__)
+#define ASSUME(x) __builtin_assume(x)
+#elif defined(__GNUC__)
+#define ASSUME(x) do { if (!(x)) __builtin_unreachable(); } while (0)
+#elif defined(_MSC_VER)
+#define ASSUME(x) __assume(x)
+#else
+#define ASSUME(x) ((void)0)
+#endif
+
 #if defined(OPTIMIZED)
 #define likely(x)   __builtin_expect(!!(x), 1)
 #define unlikely(x) __builtin_expect(!!(x), 0)
@@ -42,8 +90,118 @@ LinearSet<K>		  - A linear probing hash set with K keys.
 
 namespace LinearProbing
 {
+	/// <summary>
+	/// How Erase removes a key.
+	/// BackwardShift moves the rest of the cluster up, so lookups never pass deleted slots.
+	/// Tombstone only marks the slot. Inserts reuse tombstones, and once entries plus tombstones
+	/// pass the max load factor, the table is rebuilt: at the same size, if tombstones make up
+	/// at least half of the load. Cheaper for large keys and long clusters.
+	/// </summary>
+	enum class DeletionPolicy : int
+	{
+		BackwardShift = 0,
+		Tombstone = 1,
+	};
+
+	/// <summary>
+	/// Order in which a lookup visits the slots after the home slot of a key.
+	/// Linear visits the next slot. Fastest while clusters stay short, but strided keys with a
+	/// weak hash pile up into long clusters (primary clustering).
+	/// Triangular adds 1, 2, 3, ... slots, which visits every slot of a power of two table once.
+	/// Keys with nearby homes spread out, at the cost of a cache miss per probe on large tables.
+	/// GroupLinear checks 8 slot groups at once (one 64 bit load of the control bytes), and only
+	/// stops at a group with an empty slot. Inside a group, keys take any free slot.
+	/// Only Linear can shift backward, the others always erase with tombstones.
+	/// Hopscotch and Cuckoo are the probings of HopscotchLinearMap and LinearCuckooMap, the other maps and sets don't support them.
+	/// </summary>
+	enum class ProbingPolicy : int
+	{
+		Linear = 0,
+		Triangular = 1,
+		GroupLinear = 2,
+		Hopscotch = 3,
+		Cuckoo = 4,
+	};
+
+	/// <summary>
+	/// What a Get hit does with the entry it found, with linear probing.
+	/// Transpose swaps it with the slot before it, unless it is in its home slot. Keys that are read often
+	/// move step by step towards the start of their cluster and resolve on the first probes.
+	/// The swap keeps every key between its home and the end of its cluster, so backward shifting still works.
+	/// A Get moves entries, so references from earlier lookups may point to another value afterwards.
+	/// (Moving hits straight to their home slot pushes the key there to the back, and made the average probe longer.)
+	/// </summary>
+	enum class HitReordering : int
+	{
+		None = 0,
+		Transpose = 1,
+	};
+
+	/// <summary>
+	/// Compile time options of the maps and sets, e.g. LinearCoreMap<K, V, MapPolicy{ DeletionPolicy::Tombstone }>
+	/// or LinearSet<K, MapPolicy{ .probing = ProbingPolicy::Triangular }>.
+	/// hot_keys: entries of a direct mapped cache in front of Get and Contains of LinearCoreMap and LinearMap,
+	/// a power of two or 0 for none. It remembers the slot of the last key found per entry, so repeated
+	/// lookups of the same keys skip the probe. Sets don't have one.
+	/// reordering: see HitReordering, Get of LinearCoreMap and LinearMap only.
+	/// </summary>
+	struct MapPolicy
+	{
+		DeletionPolicy deletion = DeletionPolicy::BackwardShift;
+		ProbingPolicy probing = ProbingPolicy::Linear;
+		size_t hot_keys = 0;
+		HitReordering reordering = HitReordering::None;
+	};
+
 	namespace Internal
 	{
+		// control bytes of 'm_used'
+		constexpr uint8_t slot_empty = 0;
+		constexpr uint8_t slot_full = 1;
+		constexpr uint8_t slot_deleted = 2; // tombstone, only with DeletionPolicy::Tombstone
+
+		constexpr size_t npos = ~(size_t)0;
+
+		constexpr size_t probe_group_size = 8; // slots per group of ProbingPolicy::GroupLinear
+
+		constexpr size_t parallel_region_slots = 1 << 12; // slots filled by one task of a parallel insert
+		constexpr size_t parallel_blocks = 64;            // input parts of the sort of a parallel insert
+
+		/// <summary>
+		/// Executor of the operations that take one, it runs 'f(first, last)' for all of [0, count) on the calling thread.
+		/// An executor is called as 'executor(count, f)' and may run 'f' on any ranges that cover [0, count) once,
+		/// concurrently. WorkStealingPool of LinearMapThreads.h is one that uses several threads.
+		/// </summary>
+		struct SerialExecutor
+		{
+			template <typename F>
+			void operator()(const size_t count, F&& f) const
+			{
+				if (count != 0)
+					f((size_t)0, count);
+			}
+		};
+
+		/// <summary>
+		/// True, for the probings that keep every key at a bounded distance from its home.
+		/// Their tables are implemented by HopscotchLinearMap and LinearCuckooMap.
+		/// </summary>
+		constexpr bool IsBoundedProbing(const ProbingPolicy probing) noexcept
+		{
+			return probing == ProbingPolicy::Hopscotch || probing == ProbingPolicy::Cuckoo;
+		}
+
+		/// <summary>
+		/// True, if Erase leaves tombstones. Backward shifting needs linear probing, bounded probings need neither.
+		/// </summary>
+		constexpr bool UsesTombstones(const MapPolicy policy) noexcept
+		{
+			if (IsBoundedProbing(policy.probing))
+				return false;
+
+			return policy.deletion == DeletionPolicy::Tombstone || policy.probing != ProbingPolicy::Linear;
+		}
+
 		template<class T>
 		using HashFunction = size_t(*)(const T& key);
 
@@ -61,18 +219,184 @@ namespace LinearProbing
 			std::is_pointer_v<T> ||
 			std::is_null_pointer_v<T>;
 
+		enum class HashMixer : int
+		{
+			Custom = 0,
+			Splitmix64 = 1,
+			WyhashFinal = 2,
+			GoldenRatio = 3,
+		};
+
+		constexpr HashMixer default_hash_mixer = HashMixer::GoldenRatio;
+
+		/// <summary>
+		/// All mixers, used by tools that compare them. Add new mixers here too.
+		/// </summary>
+		constexpr HashMixer all_hash_mixers[] = {
+			HashMixer::Custom,
+			HashMixer::Splitmix64,
+			HashMixer::WyhashFinal,
+			HashMixer::GoldenRatio,
+		};
+
+		constexpr const char* HashMixerName(const HashMixer mixer) noexcept
+		{
+			switch (mixer)
+			{
+			case HashMixer::Custom:      return "Custom";
+			case HashMixer::Splitmix64:  return "Splitmix64";
+			case HashMixer::WyhashFinal: return "Wyhash Final";
+			case HashMixer::GoldenRatio: return "Golden ratio";
+			}
+			return "Unknown";
+		}
+
+		/// <summary>
+		/// Scrambles the hash 'n', so it can be masked into a power of two table of 'data_size' slots.
+		/// </summary>
+		template <HashMixer mixer>
+		size_t MixHash(const size_t n, const size_t data_size) noexcept
+		{
+			auto x = n + 1; // fix for 0 keys
+
+			if constexpr (mixer == HashMixer::Custom)
+			{
+				x ^= x >> 21;
+				x ^= x << 37;
+				x ^= x >> 4;
+				x *= 0x165667919E3779F9ULL;
+				x ^= x >> 32;
+			}
+			else if constexpr (mixer == HashMixer::Splitmix64)
+			{
+				x += 0x9e3779b97f4a7c15;
+				x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+				x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+				x ^= (x >> 31);
+			}
+			else if constexpr (mixer == HashMixer::WyhashFinal)
+			{
+				x ^= x >> 32;
+				x *= 0xd6e8feb86659fd93;
+				x ^= x >> 32;
+				x *= 0xd6e8feb86659fd93;
+				x ^= x >> 32;
+			}
+			else if constexpr (mixer == HashMixer::GoldenRatio)
+			{
+				constexpr size_t golden_ratio = 11400714819323198485ULL;
+				return (x * golden_ratio) & (data_size - 1);
+			}
+
+			return x;
+		}
+
+		/// <summary>
+		/// Runtime dispatch to 'MixHash', for tools that iterate over 'all_hash_mixers'.
+		/// </summary>
+		inline size_t MixHash(const HashMixer mixer, const size_t n, const size_t data_size) noexcept
+		{
+			switch (mixer)
+			{
+			case HashMixer::Custom:      return MixHash<HashMixer::Custom>(n, data_size);
+			case HashMixer::Splitmix64:  return MixHash<HashMixer::Splitmix64>(n, data_size);
+			case HashMixer::WyhashFinal: return MixHash<HashMixer::WyhashFinal>(n, data_size);
+			case HashMixer::GoldenRatio: return MixHash<HashMixer::GoldenRatio>(n, data_size);
+			}
+			return MixHash<default_hash_mixer>(n, data_size);
+		}
+
+#if defined(LMAP_TRACE)
+		constexpr bool trace_enabled = true;
+#else
+		constexpr bool trace_enabled = false;
+#endif
+
+		/// <summary>
+		/// What one successful Erase did. Only filled in, when LMAP_TRACE is defined.
+		/// </summary>
+		struct EraseTrace
+		{
+			size_t slot = 0;    // slot of the erased key
+			size_t probes = 0;  // slots compared to find the key
+			size_t scanned = 0; // entries behind the key checked by the backward shift
+			size_t moved = 0;   // entries moved into a hole
+		};
+
+		/// <summary>
+		/// Called after every successful Erase of a map or set, when LMAP_TRACE is defined.
+		/// </summary>
+		inline void (*erase_trace)(const EraseTrace& trace) = nullptr;
+
+		/// <summary>
+		/// Hash of 'key' before mixing. Integers and floats use their bits, other keys 'hash'.
+		/// </summary>
+		template <class T>
+		[[nodiscard]] size_t KeyHash(const T& key, const HashFunction<T> hash) noexcept
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				return static_cast<uint64_t>(key);
+			}
+			else if constexpr (std::is_floating_point_v<T>)
+			{
+				if constexpr (sizeof(T) == 4)
+				{
+					return static_cast<uint64_t>(std::bit_cast<uint32_t>(key));
+				}
+				else
+				{
+					return std::bit_cast<uint64_t>(key);
+				}
+			}
+			else
+			{
+				return hash(key);
+			}
+		}
+
+		/// <summary>
+		/// std::hash for keys that have one, otherwise nullptr and a custom hash function must be provided.
+		/// </summary>
 		template <class T>
+		[[nodiscard]] HashFunction<T> DefaultHash() noexcept
+		{
+			if constexpr (std::is_default_constructible_v<std::hash<T>>)
+			{
+				return [](const T& key)
+					{
+						return std::hash<T>{}(key);
+					};
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		template <class T, MapPolicy policy = MapPolicy{}>
 		class LinearHash
 		{
 		protected:
 
 			HashFunction<T> m_hash = nullptr;
 			size_t m_count = 0;
+			size_t m_deleted = 0; // tombstones
 			size_t m_data_size = 0;
-			static constexpr double max_load_factor = 0.7;
+
+			// every key of a hopscotch or cuckoo table sits within a fixed distance of its home, so they can fill up further
+			static constexpr double max_load_factor = policy.probing == ProbingPolicy::Cuckoo ? 0.95
+				: policy.probing == ProbingPolicy::Hopscotch ? 0.9 : 0.7;
+
+			// the golden ratio keeps strided keys on a few homes, more than a hopscotch neighborhood holds
+			static constexpr HashMixer hash_mixer = policy.probing == ProbingPolicy::Hopscotch ? HashMixer::Splitmix64 : default_hash_mixer;
+			static constexpr bool use_tombstones = UsesTombstones(policy);
+			static constexpr ProbingPolicy probing = policy.probing;
 
 		public:
 
+			static constexpr MapPolicy map_policy = policy;
+
 			virtual ~LinearHash() = default;
 
 			[[nodiscard]] size_t Size() const noexcept
@@ -90,6 +414,19 @@ namespace LinearProbing
 				return static_cast<double>(m_count) / static_cast<double>(m_data_size);
 			}
 
+			[[nodiscard]] static constexpr double MaxLoadFactor() noexcept
+			{
+				return max_load_factor;
+			}
+
+			/// <summary>
+			/// Number of tombstones, always 0 with DeletionPolicy::BackwardShift and linear probing.
+			/// </summary>
+			[[nodiscard]] size_t Tombstones() const noexcept
+			{
+				return m_deleted;
+			}
+
 			virtual void Reserve(const size_t capacity)
 			{
 				throw std::runtime_error("not implemented");
@@ -101,16 +438,12 @@ namespace LinearProbing
 
 			/// <summary>
 			/// Will grow or shrink the map to 'new_capacity', while keeping existing data.
+			/// The capacity is rounded up, until the data fits within the max load factor.
 			/// </summary>
 			/// <param name="new_capacity"></param>
 			void Rehash(size_t new_capacity) 
 			{
-				new_capacity = FormatCapacity(new_capacity);
-
-				if (new_capacity < this->m_count)
-					throw std::out_of_range("New capacity is smaller than the current size of the map");
-
-				this->Resize(new_capacity);
+				this->Resize(RehashSize(new_capacity));
 			}
 
 			void SetHashFunction(HashFunction<T> hash_func) noexcept
@@ -118,50 +451,48 @@ namespace LinearProbing
 				m_hash = hash_func;
 			}
 
+			[[nodiscard]] HashFunction<T> GetHashFunction() const noexcept
+			{
+				return m_hash;
+			}
+
 		protected:
 
+			[[nodiscard]] size_t RehashSize(size_t new_capacity) const
+			{
+				new_capacity = FormatCapacity(new_capacity);
+
+				if (new_capacity < this->m_count)
+					throw std::out_of_range("New capacity is smaller than the current size of the map");
+
+				while ((double)this->m_count > (double)new_capacity * max_load_factor)
+					new_capacity *= 2; // a full table would never end a probe
+
+				return new_capacity;
+			}
+
 			void SetDefaultHash() noexcept
 			{
-				m_hash = [](const T& key)
-					{
-						return std::hash<T>{}(key);
-					};
+				m_hash = DefaultHash<T>(); // nullptr without std::hash, a custom hash function must be provided
 			}
 
 			[[nodiscard]] size_t InvokeHash(const T& key) const noexcept
 			{
-				if constexpr (std::is_integral_v<T>)
-				{
-					return static_cast<uint64_t>(key);
-				}
-				else if constexpr (std::is_floating_point_v<T>)
-				{
-					if constexpr (sizeof(T) == 4)
-					{
-						return static_cast<uint64_t>(std::bit_cast<uint32_t>(key));
-					}
-					else
-					{
-						return std::bit_cast<uint64_t>(key);
-					}
-				}
-				else
-				{
-					return m_hash(key);
-				}
+				return KeyHash(key, m_hash);
 			}
 
-			[[nodiscard]] std::tuple<size_t, size_t> GetSlot(const T& key, const size_t data_size) noexcept
+			[[nodiscard]] std::tuple<size_t, size_t> GetSlot(const T& key, const size_t data_size) const noexcept
 			{
-				if (!m_hash)
-					UNREACHABLE();
+				if constexpr (!std::is_arithmetic_v<T>)
+				{
+					if (!m_hash)
+						UNREACHABLE(); // arithmetic keys don't use m_hash, so it may be null
+				}
 
 				const size_t hash = HashImpl(InvokeHash(key), data_size);
 				const auto size = data_size;
 
-#if defined(OPTIMIZED)
-				__builtin_assume(size != 0 && (size & (size - 1)) == 0); // always power of two
-#endif
+				ASSUME(size != 0 && (size & (size - 1)) == 0); // always power of two
 
 				const auto last_index = size - 1;
 				const auto start = hash & last_index;
@@ -170,1327 +501,5144 @@ namespace LinearProbing
 
 			static size_t HashImpl(const size_t n, const size_t data_size) noexcept
 			{
-				auto x = n + 1; // fix for 0 keys
-				constexpr int hash_id = 3;
+				return MixHash<hash_mixer>(n, data_size);
+			}
 
-				if constexpr (hash_id == 0) // Custom
-				{
-					x ^= x >> 21;
-					x ^= x << 37;
-					x ^= x >> 4;
-					x *= 0x165667919E3779F9ULL;
-					x ^= x >> 32;
-				}
-				else if constexpr (hash_id == 1)  // Splitmix64
-				{
-					x += 0x9e3779b97f4a7c15;
-					x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
-					x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
-					x ^= (x >> 31);
-				}
-				else if constexpr (hash_id == 2) // Wyhash Final
-				{
-					x ^= x >> 32;
-					x *= 0xd6e8feb86659fd93;
-					x ^= x >> 32;
-					x *= 0xd6e8feb86659fd93;
-					x ^= x >> 32;
-				}
-				else if constexpr (hash_id == 3) // Golden ratio
-				{
-					constexpr size_t golden_ratio = 11400714819323198485ULL;
-					return (x * golden_ratio) & (data_size - 1);
-				}
+			/// <summary>
+			/// Home slot of a key that is already in the table. Cheaper than 'GetSlot', no tuple and no 'm_hash' check.
+			/// </summary>
+			[[nodiscard]] size_t HomeSlot(const T& key, const size_t last_index) const noexcept
+			{
+				return HashImpl(InvokeHash(key), last_index + 1) & last_index;
+			}
 
-				return x;
+			/// <summary>
+			/// Slot after 'i' on the probe sequence, 'step' counts the probes so far (triangular probing).
+			/// </summary>
+			static size_t NextSlot(const size_t i, size_t& step, const size_t last_index) noexcept
+			{
+				if constexpr (probing == ProbingPolicy::Triangular)
+					return (i + ++step) & last_index;
+				else
+					return (i + 1) & last_index;
 			}
 
-			static size_t FormatCapacity(size_t n) noexcept
+			// GroupLinear reads the control bytes of a group as one word, bit 0 of every byte is one slot.
+			// Only slot_full is odd, and no control byte uses more than the lowest two bits.
+			static_assert(slot_empty == 0 && slot_full == 1 && slot_deleted == 2);
+			static constexpr uint64_t group_low_bits = 0x0101010101010101ull;
+
+			static uint64_t LoadGroup(const uint8_t* used, const size_t group) noexcept
 			{
-				n = (std::max)(n, 8ull);                     // minimum size
-				size_t next = 1ull << std::bit_width(n - 1); // next power of two
-				return next;
+				uint64_t word;
+				std::memcpy(&word, used + group, sizeof(word));
+				return word;
 			}
 
-			virtual void Init(size_t capacity, bool overwrite_hash)
+			static uint64_t FullSlots(const uint64_t word) noexcept
 			{
-				throw std::runtime_error("not implemented");
+				return word & group_low_bits;
 			}
 
-			virtual void Resize(size_t new_size)
+			static uint64_t FreeSlots(const uint64_t word) noexcept
 			{
-				throw std::runtime_error("not implemented");
+				return ~word & group_low_bits; // empty or tombstone
 			}
 
-			void EnsureCapacity(const size_t count) noexcept
+			static uint64_t EmptySlots(const uint64_t word) noexcept
 			{
-				const auto free = this->m_data_size - this->m_count;
-				const size_t free_lf = (size_t)((double)free * max_load_factor);
-				if (count < free_lf)
-					return; // enough space
+				return ~(word | word >> 1) & group_low_bits;
+			}
 
-				const auto need = count - free_lf;
-				auto new_size = FormatCapacity(this->m_data_size + need);
-				Resize(new_size);
+			/// <summary>
+			/// Offset in the group of the lowest slot in 'mask'. Remove it with 'mask &= mask - 1'.
+			/// </summary>
+			static size_t SlotInGroup(const uint64_t mask) noexcept
+			{
+				if constexpr (std::endian::native == std::endian::little)
+					return (size_t)std::countr_zero(mask) / 8;
+				else
+					return probe_group_size - 1 - (size_t)std::countr_zero(mask) / 8;
 			}
-		};
 
+			/// <summary>
+			/// Slot of 'key', or 'npos' if it isn't in the table.
+			/// </summary>
+			[[nodiscard]] size_t FindIndex(const T& key, const T* keys, const uint8_t* used) const noexcept
+			{
+				const auto [start, last_index] = GetSlot(key, m_data_size);
+				return FindIndexFrom(key, start, keys, used);
+			}
 
-	template <class K, class V>
-	class LinearCoreMapImpl : public LinearHash<K> // linear probing hash map
-	{
-	protected:
+			/// <summary>
+			/// 'FindIndex' for a caller that already has the home slot 'start' of 'key'.
+			/// </summary>
+			[[nodiscard]] size_t FindIndexFrom(const T& key, const size_t start, const T* keys, const uint8_t* used) const noexcept
+			{
+				const auto last_index = m_data_size - 1;
 
-		// TODO: Test out future optimization AVX. New memory layout
+				if constexpr (probing == ProbingPolicy::GroupLinear)
+				{
+					for (auto group = start & ~(probe_group_size - 1); ; group = (group + probe_group_size) & last_index)
+					{
+						const auto word = LoadGroup(used, group);
+						for (auto full = FullSlots(word); full; full &= full - 1)
+						{
+							const auto i = group + SlotInGroup(full);
+							if (keys[i] == key)
+								return i;
+						}
+
+						if (EmptySlots(word))
+							return npos;
+					}
+				}
 
-		std::unique_ptr<K[]> m_keys;
-		std::unique_ptr<V[]>  m_values;
-		std::unique_ptr<uint8_t[]>   m_used;
+				size_t step = 0;
+				for (auto i = start; ; i = NextSlot(i, step, last_index))
+				{
+					if (used[i] == slot_empty)
+						return npos;
 
-		std::unique_ptr<K[]> m_keys_new;
-		std::unique_ptr<V[]>  m_values_new;
-		std::unique_ptr<uint8_t[]>   m_used_new;
+					if constexpr (use_tombstones)
+					{
+						if (used[i] == slot_deleted)
+							continue; // the key of a tombstone is the default key
+					}
 
-	private:
+					if (keys[i] == key)
+						return i;
+				}
+			}
 
-		K m_default_key{}; // never modify this
-		V m_default_value; // never modify this
-		V m_default_value_ref; // never modify this
+			struct InsertSlot
+			{
+				size_t index; // slot of the key, or where it goes
+				bool found;   // the key is already in the table
+			};
 
-	public:
+			/// <summary>
+			/// Slot of 'key', if present. Otherwise the slot a new key goes into:
+			/// the first tombstone on the way, or the empty slot that ended the probe.
+			/// </summary>
+			[[nodiscard]] InsertSlot FindInsertSlot(const T& key, const T* keys, const uint8_t* used) noexcept
+			{
+				auto [start, last_index] = GetSlot(key, m_data_size);
+				auto reuse = npos;
 
-#ifndef NDEBUG
-#define LM_ASSERT_INTEGRITY() DbgIntegrityCheck()
-#else
-#define LM_ASSERT_INTEGRITY()
-#endif
+				if constexpr (probing == ProbingPolicy::GroupLinear)
+				{
+					for (auto group = start & ~(probe_group_size - 1); ; group = (group + probe_group_size) & last_index)
+					{
+						const auto word = LoadGroup(used, group);
+						for (auto full = FullSlots(word); full; full &= full - 1)
+						{
+							const auto i = group + SlotInGroup(full);
+							if (keys[i] == key)
+								return { i, true };
+						}
+
+						const auto free = FreeSlots(word);
+						if (reuse == npos && free)
+							reuse = group + SlotInGroup(free);
+
+						if (EmptySlots(word))
+							return { reuse, false }; // an empty slot is free too, so 'reuse' is set
+					}
+				}
 
-		explicit LinearCoreMapImpl(const size_t capacity)
-		{
-			LinearCoreMapImpl::Init(capacity);
-		}
+				size_t step = 0;
+				for (auto i = start; ; i = NextSlot(i, step, last_index))
+				{
+					if (used[i] == slot_empty)
+						return { reuse != npos ? reuse : i, false };
 
-		explicit LinearCoreMapImpl(HashFunction<K> hash_func)
-		{
-			LinearCoreMapImpl::Init(64, true);
-			this->m_hash = hash_func;
-		}
+					if constexpr (use_tombstones)
+					{
+						if (used[i] == slot_deleted)
+						{
+							if (reuse == npos)
+								reuse = i;
+							continue;
+						}
+					}
+
+					if (keys[i] == key)
+						return { i, true };
+				}
+			}
+
+			/// <summary>
+			/// First empty slot on the probe sequence of 'key', in a table of 'data_size' slots without tombstones.
+			/// Used by Resize, where every key is new.
+			/// </summary>
+			[[nodiscard]] size_t FindEmptySlot(const T& key, const uint8_t* used, const size_t data_size) noexcept
+			{
+				auto [start, last_index] = GetSlot(key, data_size);
+
+				if constexpr (probing == ProbingPolicy::GroupLinear)
+				{
+					for (auto group = start & ~(probe_group_size - 1); ; group = (group + probe_group_size) & last_index)
+					{
+						const auto empty = EmptySlots(LoadGroup(used, group));
+						if (empty)
+							return group + SlotInGroup(empty);
+					}
+				}
+
+				size_t step = 0;
+				auto i = start;
+				while (used[i])
+					i = NextSlot(i, step, last_index);
+
+				return i;
+			}
+
+			/// <summary>
+			/// Number of slots (groups with GroupLinear) a lookup of 'key' visits, to find it in 'slot'.
+			/// </summary>
+			[[nodiscard]] size_t ProbeLength(const T& key, const size_t slot) const noexcept
+			{
+				const auto last_index = m_data_size - 1;
+				const auto home = HomeSlot(key, last_index);
+
+				if constexpr (probing == ProbingPolicy::Triangular)
+				{
+					size_t probes = 1, step = 0;
+					for (auto i = home; i != slot; i = NextSlot(i, step, last_index))
+						++probes;
+
+					return probes;
+				}
+				else if constexpr (probing == ProbingPolicy::GroupLinear)
+				{
+					const auto mask = ~(probe_group_size - 1);
+					return (((slot & mask) - (home & mask)) & last_index) / probe_group_size + 1;
+				}
+				else
+				{
+					return ((slot - home) & last_index) + 1;
+				}
+			}
+
+			/// <summary>
+			/// Marks slot 'i' as used, and counts it.
+			/// </summary>
+			void Occupy(uint8_t* used, const size_t i) noexcept
+			{
+				if constexpr (use_tombstones)
+					m_deleted -= used[i] == slot_deleted;
+
+				used[i] = slot_full;
+				++m_count;
+			}
+
+			/// <summary>
+			/// True, if 'extra' more entries would pass the max load factor.
+			/// Tombstones count as used, they lengthen the probes just the same.
+			/// </summary>
+			[[nodiscard]] bool IsOverloaded(const size_t extra) const noexcept
+			{
+				return (double)(m_count + m_deleted + extra) > (double)m_data_size * max_load_factor;
+			}
+
+			/// <summary>
+			/// Size to resize to, once the table is overloaded. If tombstones take up most of the load,
+			/// rebuilding at the same size is enough.
+			/// </summary>
+			[[nodiscard]] size_t GrownSize() const noexcept
+			{
+				if constexpr (use_tombstones)
+				{
+					if ((double)m_count <= (double)m_data_size * max_load_factor * 0.5)
+						return m_data_size;
+				}
+
+				return m_data_size * 2;
+			}
+
+			/// <summary>
+			/// Tombstone deletion of slot 'i', the caller resets its key and value.
+			/// Linear: if the next slot is empty, no probe passes this slot, so it and the tombstones
+			/// right before it become empty again.
+			/// GroupLinear: same for a group that still has an empty slot, no probe passes it.
+			/// Triangular: probes of other homes may pass the slot, it always becomes a tombstone.
+			/// Tombstones count towards the load factor, the next insert into an overloaded table rebuilds it ('GrownSize').
+			/// </summary>
+			void MarkDeleted(uint8_t* used, size_t i) noexcept
+			{
+				const auto last_index = m_data_size - 1;
+				--m_count;
+
+				if constexpr (probing == ProbingPolicy::Triangular)
+				{
+					used[i] = slot_deleted;
+					++m_deleted;
+				}
+				else if constexpr (probing == ProbingPolicy::GroupLinear)
+				{
+					const auto group = i & ~(probe_group_size - 1);
+					if (!EmptySlots(LoadGroup(used, group)))
+					{
+						used[i] = slot_deleted;
+						++m_deleted;
+						return;
+					}
+
+					used[i] = slot_empty;
+					for (auto j = group; j < group + probe_group_size; ++j)
+					{
+						if (used[j] == slot_deleted)
+						{
+							used[j] = slot_empty;
+							--m_deleted;
+						}
+					}
+				}
+				else if (used[(i + 1) & last_index] != slot_empty)
+				{
+					used[i] = slot_deleted;
+					++m_deleted;
+				}
+				else
+				{
+					used[i] = slot_empty;
+					for (i = (i - 1) & last_index; used[i] == slot_deleted; i = (i - 1) & last_index)
+					{
+						used[i] = slot_empty;
+						--m_deleted;
+					}
+				}
+			}
+
+			/// <summary>
+			/// Backward shift deletion with linear probing, 'hole' is the slot of the erased key.
+			/// The entries of the cluster behind it move up, if the hole lies between their home and their slot.
+			/// Otherwise, a lookup starting at their home wouldn't pass the new slot.
+			/// 'move(from, to)' moves one entry. With 'blind_moves', every entry is moved into the hole,
+			/// and the hole only advances if the entry was allowed to move. The hole is overwritten later
+			/// anyway, so this trades a copy of small trivial entries for an unpredictable branch.
+			/// </summary>
+			/// <returns>The slot that is free afterwards</returns>
+			template <bool blind_moves, class Move>
+			size_t ShiftBackward(const T* keys, const uint8_t* used, size_t hole, Move&& move, EraseTrace& trace) const noexcept
+			{
+				const auto last_index = m_data_size - 1;
+
+				for (auto i = (hole + 1) & last_index; used[i]; i = (i + 1) & last_index)
+				{
+					const auto home = HomeSlot(keys[i], last_index);
+					const bool stays = ((i - home) & last_index) < ((i - hole) & last_index);
+
+					if constexpr (trace_enabled)
+					{
+						++trace.scanned;
+						trace.moved += !stays;
+					}
+
+					if constexpr (blind_moves)
+					{
+						move(i, hole);
+						hole = stays ? hole : i;
+					}
+					else
+					{
+						if (stays)
+							continue;
+
+						move(i, hole);
+						hole = i;
+					}
+				}
+
+				return hole;
+			}
+
+			static void Trace(const EraseTrace& trace) noexcept
+			{
+				if constexpr (trace_enabled)
+				{
+					if (erase_trace)
+						erase_trace(trace);
+				}
+			}
+
+			static size_t FormatCapacity(size_t n) noexcept
+			{
+				n = (std::max)(n, (size_t)8);                // minimum size
+				size_t next = 1ull << std::bit_width(n - 1); // next power of two
+				return next;
+			}
+
+			virtual void Init(size_t capacity, bool overwrite_hash)
+			{
+				throw std::runtime_error("not implemented");
+			}
+
+			virtual void Resize(size_t new_size)
+			{
+				throw std::runtime_error("not implemented");
+			}
+
+			/// <summary>
+			/// Size to resize to before inserting 'count' entries, or 0 if they fit.
+			/// </summary>
+			[[nodiscard]] size_t CapacityFor(const size_t count) const noexcept
+			{
+				const auto required = this->m_count + count; // worst case, no duplicates
+				if (!IsOverloaded(count))
+					return 0; // enough space
+
+				return FormatCapacity((size_t)((double)required / max_load_factor) + 1);
+			}
+
+			void EnsureCapacity(const size_t count) noexcept
+			{
+				if (const auto new_size = CapacityFor(count))
+					Resize(new_size);
+			}
+
+			/// <summary>
+			/// Inserts 'count' items into the table 'keys'/'used' of 'data_size' slots, on the threads of 'executor'.
+			/// The table is split into regions of 'parallel_region_slots' and the items are sorted by the region of
+			/// their home. Each region inserts its items in input order, so no two threads write the same slot.
+			/// An item whose probe reaches the end of its region goes to 'deferred' for the caller to insert serially,
+			/// in input order, as do all items of a table with fewer than two regions.
+			/// 'key_of(item)' is the key of an item, 'place(item, slot, found)' stores it into 'slot', its key too unless 'found'.
+			/// Returns the number of slots it filled, and how many of them were tombstones.
+			/// </summary>
+			template <class KeyOf, class Place, class Executor>
+			std::pair<size_t, size_t> PlaceByRegion(const size_t count, KeyOf&& key_of, const T* keys, uint8_t* used, const size_t data_size,
+				Place&& place, Executor&& executor, std::vector<size_t>& deferred) const
+			{
+				static_assert(probing == ProbingPolicy::Linear, "a probe must stay in the slots after its home");
+
+				deferred.clear();
+				const auto regions = data_size / parallel_region_slots;
+				if (regions < 2)
+				{
+					deferred.resize(count);
+					for (size_t item = 0; item < count; ++item)
+						deferred[item] = item;
+					return { 0, 0 };
+				}
+
+				const auto last_index = data_size - 1;
+				const auto region_shift = (size_t)std::countr_zero(parallel_region_slots);
+				const auto blocks = (std::min)(parallel_blocks, count);
+
+				// counting sort by region, stable, the blocks of the input count and scatter in parallel
+				std::vector<size_t> offsets(blocks * regions);
+				std::vector<size_t> order(count);
+
+				const auto for_blocks = [&](auto&& visit)
+					{
+						executor(blocks, [&](const size_t first, const size_t last)
+							{
+								for (auto block = first; block < last; ++block)
+								{
+									auto* block_offsets = &offsets[block * regions];
+									for (auto item = block * count / blocks; item < (block + 1) * count / blocks; ++item)
+										visit(block_offsets[HomeSlot(key_of(item), last_index) >> region_shift], item);
+								}
+							});
+					};
+
+				for_blocks([](size_t& offset, size_t) { ++offset; });
+
+				std::vector<size_t> region_start(regions + 1);
+				size_t total = 0;
+				for (size_t region = 0; region < regions; ++region)
+				{
+					region_start[region] = total;
+					for (size_t block = 0; block < blocks; ++block)
+					{
+						const auto items = offsets[block * regions + region];
+						offsets[block * regions + region] = total;
+						total += items;
+					}
+				}
+				region_start[regions] = total;
+
+				for_blocks([&](size_t& offset, const size_t item) { order[offset++] = item; });
+
+				std::vector<uint8_t> left(count); // by position in 'order', the probe reached the end of the region
+				std::vector<std::pair<size_t, size_t>> filled(regions);
+
+				executor(regions, [&](const size_t first, const size_t last)
+					{
+						for (auto region = first; region < last; ++region)
+						{
+							const auto end = (region + 1) << region_shift;
+							size_t slots = 0, tombstones = 0;
+
+							for (auto position = region_start[region]; position < region_start[region + 1]; ++position)
+							{
+								const auto item = order[position];
+								const T& key = key_of(item);
+								auto reuse = npos;
+
+								for (auto i = HomeSlot(key, last_index); ; ++i)
+								{
+									if (i == end)
+									{
+										left[position] = 1;
+										break;
+									}
+
+									if (used[i] == slot_empty)
+									{
+										const auto slot = reuse != npos ? reuse : i;
+										tombstones += reuse != npos;
+										++slots;
+										used[slot] = slot_full;
+										place(item, slot, false);
+										break;
+									}
+
+									if constexpr (use_tombstones)
+									{
+										if (used[i] == slot_deleted)
+										{
+											if (reuse == npos)
+												reuse = i;
+											continue;
+										}
+									}
+
+									if (keys[i] == key)
+									{
+										place(item, i, true);
+										break;
+									}
+								}
+							}
+
+							filled[region] = { slots, tombstones };
+						}
+					});
+
+				for (size_t position = 0; position < count; ++position)
+				{
+					if (left[position])
+						deferred.push_back(order[position]);
+				}
+
+				std::pair<size_t, size_t> sum{ 0, 0 };
+				for (const auto& [slots, tombstones] : filled)
+				{
+					sum.first += slots;
+					sum.second += tombstones;
+				}
+
+				return sum;
+			}
+		};
+
+		/// <summary>
+		/// Front cache of MapPolicy::hot_keys, maps the low bits of a home slot to the slot its last found key sits in.
+		/// A hit costs one compare against an entry that stays in L1, instead of the probe through the large arrays.
+		/// Slots only move on Resize, Clear and backward shift Erase, those bump the epoch, which drops every entry at once.
+		/// Only the non-const lookups use it, a const 'operator[]' bypasses it, so concurrent const readers don't write.
+		/// </summary>
+		template <class K, size_t entries>
+		class HotKeyCache
+		{
+			static_assert(std::has_single_bit(entries), "MapPolicy::hot_keys must be a power of two");
+
+			struct Entry
+			{
+				K key{};
+				size_t slot = 0;
+				size_t epoch = 0; // valid while equal to 'm_epoch'
+			};
+
+			Entry m_entries[entries] = {};
+			size_t m_epoch = 1;
+
+		public:
+
+			/// <summary>
+			/// Slot of 'key', if it is the cached key of 'home', otherwise 'npos'.
+			/// </summary>
+			[[nodiscard]] size_t Find(const K& key, const size_t home) const noexcept
+			{
+				const auto& entry = m_entries[home & (entries - 1)];
+				return entry.epoch == m_epoch && entry.key == key ? entry.slot : npos;
+			}
+
+			void Store(const K& key, const size_t home, const size_t slot) noexcept
+			{
+				auto& entry = m_entries[home & (entries - 1)];
+				entry.key = key;
+				entry.slot = slot;
+				entry.epoch = m_epoch;
+			}
+
+			/// <summary>
+			/// Drops the entry that 'home' maps to, the only one that can hold the key of that home.
+			/// </summary>
+			void Forget(const size_t home) noexcept
+			{
+				m_entries[home & (entries - 1)].epoch = 0;
+			}
+
+			void Invalidate() noexcept
+			{
+				++m_epoch;
+			}
+		};
+
+		template <class K>
+		class HotKeyCache<K, 0>
+		{
+		public:
+			void Forget(size_t) noexcept {}
+			void Invalidate() noexcept {}
+		};
+
+		/// <summary>
+		/// Random access iterator over table slots, '*it' is 'access(slot)'. It walks the listed 'slots',
+		/// or every slot of the table if there is no list.
+		/// </summary>
+		template <class Access>
+		class SlotIterator
+		{
+			Access m_access{};
+			const size_t* m_slots = nullptr;
+			std::ptrdiff_t m_index = 0;
+
+		public:
+			using reference = decltype(std::declval<const Access&>()(size_t{}));
+			using value_type = std::remove_cvref_t<reference>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using iterator_category = std::random_access_iterator_tag;
+			using iterator_concept = std::random_access_iterator_tag;
+
+			SlotIterator() = default;
+
+			SlotIterator(const Access access, const size_t* slots, const std::ptrdiff_t index) noexcept
+				: m_access(access), m_slots(slots), m_index(index)
+			{
+			}
+
+			/// <summary>
+			/// Slot in the table of the element.
+			/// </summary>
+			[[nodiscard]] size_t Slot() const noexcept
+			{
+				return m_slots ? m_slots[m_index] : (size_t)m_index;
+			}
+
+			reference operator*() const noexcept { return m_access(Slot()); }
+			reference operator[](const difference_type n) const noexcept { return *(*this + n); }
+
+			SlotIterator& operator++() noexcept { ++m_index; return *this; }
+			SlotIterator& operator--() noexcept { --m_index; return *this; }
+			SlotIterator operator++(int) noexcept { auto copy = *this; ++m_index; return copy; }
+			SlotIterator operator--(int) noexcept { auto copy = *this; --m_index; return copy; }
+			SlotIterator& operator+=(const difference_type n) noexcept { m_index += n; return *this; }
+			SlotIterator& operator-=(const difference_type n) noexcept { m_index -= n; return *this; }
+
+			friend SlotIterator operator+(SlotIterator it, const difference_type n) noexcept { return it += n; }
+			friend SlotIterator operator+(const difference_type n, SlotIterator it) noexcept { return it += n; }
+			friend SlotIterator operator-(SlotIterator it, const difference_type n) noexcept { return it -= n; }
+			friend difference_type operator-(const SlotIterator& a, const SlotIterator& b) noexcept { return a.m_index - b.m_index; }
+
+			friend bool operator==(const SlotIterator& a, const SlotIterator& b) noexcept { return a.m_index == b.m_index; }
+			friend auto operator<=>(const SlotIterator& a, const SlotIterator& b) noexcept { return a.m_index <=> b.m_index; }
+		};
+
+		/// <summary>
+		/// Random access view over table slots, see 'SlotIterator'. Copies share the slot list.
+		/// </summary>
+		template <class Access>
+		class SlotView : public std::ranges::view_interface<SlotView<Access>>
+		{
+			Access m_access{};
+			std::shared_ptr<const std::vector<size_t>> m_slots;
+			size_t m_size = 0;
+
+		public:
+
+			using iterator = SlotIterator<Access>;
+
+			SlotView() = default;
+
+			/// <summary>
+			/// Every slot of a table of 'size' slots.
+			/// </summary>
+			SlotView(const Access access, const size_t size) noexcept : m_access(access), m_size(size)
+			{
+			}
+
+			/// <summary>
+			/// The slots in 'slots'.
+			/// </summary>
+			SlotView(const Access access, std::vector<size_t> slots)
+				: m_access(access), m_slots(std::make_shared<const std::vector<size_t>>(std::move(slots))), m_size(m_slots->size())
+			{
+			}
+
+			/// <summary>
+			/// The slots in 'slots', shared with the owner of the list.
+			/// </summary>
+			SlotView(const Access access, std::shared_ptr<const std::vector<size_t>> slots) noexcept
+				: m_access(access), m_slots(std::move(slots)), m_size(m_slots->size())
+			{
+			}
+
+			[[nodiscard]] iterator begin() const noexcept
+			{
+				return iterator(m_access, m_slots ? m_slots->data() : nullptr, 0);
+			}
+
+			[[nodiscard]] iterator end() const noexcept
+			{
+				return iterator(m_access, m_slots ? m_slots->data() : nullptr, (std::ptrdiff_t)m_size);
+			}
+
+			[[nodiscard]] size_t size() const noexcept
+			{
+				return m_size;
+			}
+		};
+
+		/// <summary>
+		/// Calls 'f(slot)' for the slots in [first, last) of 'used' that hold an entry, in table order.
+		/// </summary>
+		template <class F>
+		void ForEachUsedSlot(const uint8_t* used, const size_t first, const size_t last, F&& f)
+		{
+			auto i = first;
+			if constexpr (std::endian::native == std::endian::little)
+			{
+				// eight control bytes per word, like ProbingPolicy::GroupLinear, bit 0 of a byte is set for slot_full only
+				for (; i + 8 <= last; i += 8)
+				{
+					uint64_t word;
+					std::memcpy(&word, used + i, sizeof(word));
+					for (auto full = word & 0x0101010101010101ull; full; full &= full - 1)
+						f(i + (size_t)std::countr_zero(full) / 8);
+				}
+			}
+
+			for (; i < last; ++i)
+			{
+				if (used[i] == slot_full)
+					f(i);
+			}
+		}
+
+		/// <summary>
+		/// Number of slots in [first, last) of 'used' that hold an entry.
+		/// </summary>
+		[[nodiscard]] inline size_t CountUsedSlots(const uint8_t* used, const size_t first, const size_t last) noexcept
+		{
+			size_t count = 0;
+			auto i = first;
+			for (; i + 8 <= last; i += 8)
+			{
+				uint64_t word;
+				std::memcpy(&word, used + i, sizeof(word));
+				count += (size_t)std::popcount(word & 0x0101010101010101ull);
+			}
+
+			for (; i < last; ++i)
+				count += used[i] == slot_full;
+
+			return count;
+		}
+
+		/// <summary>
+		/// Slots of 'used' that hold an entry, in table order.
+		/// </summary>
+		[[nodiscard]] inline std::vector<size_t> OccupiedSlots(const uint8_t* used, const size_t data_size, const size_t count)
+		{
+			std::vector<size_t> slots;
+			slots.reserve(count);
+			ForEachUsedSlot(used, 0, data_size, [&](const size_t slot) { slots.push_back(slot); });
+			return slots;
+		}
+
+		/// <summary>
+		/// Calls 'copy(slot, position)' for every slot of 'used' that holds an entry, 'position' counts the entries
+		/// before it in table order. 'executor' runs blocks of slots, each block counts its entries first to know its start.
+		/// </summary>
+		template <class Copy, class Executor>
+		void CompactSlots(const uint8_t* used, const size_t data_size, Executor&& executor, Copy&& copy)
+		{
+			const auto blocks = (std::min)(parallel_blocks, (std::max)(data_size / parallel_region_slots, (size_t)1));
+			const auto block_first = [&](const size_t block) { return block * data_size / blocks; };
+
+			std::vector<size_t> starts(blocks + 1);
+			if (blocks > 1)
+			{
+				executor(blocks, [&](const size_t first, const size_t last)
+					{
+						for (auto block = first; block < last; ++block)
+							starts[block + 1] = CountUsedSlots(used, block_first(block), block_first(block + 1));
+					});
+
+				for (size_t block = 0; block < blocks; ++block)
+					starts[block + 1] += starts[block];
+			}
+
+			executor(blocks, [&](const size_t first, const size_t last)
+				{
+					for (auto block = first; block < last; ++block)
+					{
+						auto position = starts[block];
+						ForEachUsedSlot(used, block_first(block), block_first(block + 1), [&](const size_t slot) { copy(slot, position++); });
+					}
+				});
+		}
+
+		constexpr size_t radix_bits = 11;
+		constexpr size_t radix_min_parallel = 1 << 16; // fewer keys sort in one block
+
+		/// <summary>
+		/// Slots of 'used' that hold an entry, ordered by their key. Integer keys get one radix pass on their highest
+		/// bits that differ, the buckets of that pass are small enough to sort in the cache. 'executor' runs the blocks
+		/// of the pass and the bucket sorts. Other keys are sorted by 'operator<' on the calling thread.
+		/// </summary>
+		template <class K, class Executor>
+		[[nodiscard]] std::vector<size_t> SortedSlots(const K* keys, const uint8_t* used, const size_t data_size, const size_t count,
+			Executor&& executor)
+		{
+			auto slots = OccupiedSlots(used, data_size, count);
+
+			if constexpr (!std::is_integral_v<K> || std::is_same_v<K, bool>)
+			{
+				std::ranges::sort(slots, std::less<>{}, [keys](const size_t slot) -> const K& { return keys[slot]; });
+				return slots;
+			}
+			else
+			{
+				using U = std::make_unsigned_t<K>;
+				constexpr U sign = std::is_signed_v<K> ? (U)((U)1 << (sizeof(K) * 8 - 1)) : 0; // flipped, negatives go first
+				constexpr size_t digits = 1 << radix_bits;
+
+				struct Item
+				{
+					U key;
+					size_t slot;
+				};
+
+				const auto n = slots.size();
+				if (n == 0)
+					return slots;
+
+				const auto blocks = n < radix_min_parallel ? 1 : parallel_blocks;
+				const auto first_key = (U)((U)keys[slots[0]] ^ sign);
+
+				std::vector<Item> items(n), sorted(n);
+				std::vector<U> differ(blocks); // bits in which the keys of a block differ from the first key
+				std::vector<size_t> offsets(blocks * digits);
+
+				const auto for_blocks = [&](auto&& visit)
+					{
+						executor(blocks, [&](const size_t first, const size_t last)
+							{
+								for (auto block = first; block < last; ++block)
+									visit(block, block * n / blocks, (block + 1) * n / blocks);
+							});
+					};
+
+				for_blocks([&](const size_t block, const size_t first, const size_t last)
+					{
+						U bits = 0;
+						for (auto i = first; i < last; ++i)
+						{
+							items[i] = { (U)((U)keys[slots[i]] ^ sign), slots[i] };
+							bits |= (U)(items[i].key ^ first_key);
+						}
+						differ[block] = bits;
+					});
+
+				// the bits above 'width' are the same in every key
+				U varying = 0;
+				for (const auto bits : differ)
+					varying |= bits;
+				const auto width = (size_t)std::bit_width(varying);
+				const auto shift = width > radix_bits ? width - radix_bits : 0;
+				const auto digit_of = [shift](const Item& item) { return (size_t)(item.key >> shift) & (digits - 1); };
+
+				// stable counting sort by the digit, the blocks count and scatter in parallel
+				for_blocks([&](const size_t block, const size_t first, const size_t last)
+					{
+						auto* block_offsets = &offsets[block * digits];
+						for (auto i = first; i < last; ++i)
+							++block_offsets[digit_of(items[i])];
+					});
+
+				std::vector<size_t> bucket_start(digits + 1);
+				size_t total = 0;
+				for (size_t digit = 0; digit < digits; ++digit)
+				{
+					bucket_start[digit] = total;
+					for (size_t block = 0; block < blocks; ++block)
+					{
+						const auto keys_in_block = offsets[block * digits + digit];
+						offsets[block * digits + digit] = total;
+						total += keys_in_block;
+					}
+				}
+				bucket_start[digits] = total;
+
+				for_blocks([&](const size_t block, const size_t first, const size_t last)
+					{
+						auto* block_offsets = &offsets[block * digits];
+						for (auto i = first; i < last; ++i)
+							sorted[block_offsets[digit_of(items[i])]++] = items[i];
+					});
+
+				if (shift != 0) // otherwise every bucket holds one key
+				{
+					executor(digits, [&](const size_t first, const size_t last)
+						{
+							for (auto digit = first; digit < last; ++digit)
+							{
+								std::sort(sorted.begin() + (std::ptrdiff_t)bucket_start[digit], sorted.begin() + (std::ptrdiff_t)bucket_start[digit + 1],
+									[](const Item& a, const Item& b) { return a.key < b.key; });
+							}
+						});
+				}
+
+				for_blocks([&](size_t, const size_t first, const size_t last)
+					{
+						for (auto i = first; i < last; ++i)
+							slots[i] = sorted[i].slot;
+					});
+				return slots;
+			}
+		}
+
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	class LinearCoreMapImpl : public LinearHash<K, policy> // linear probing hash map
+	{
+		static_assert(!Internal::IsBoundedProbing(policy.probing), "use HopscotchLinearMap or LinearCuckooMap");
+
+		static_assert(policy.reordering == HitReordering::None || policy.probing == ProbingPolicy::Linear,
+			"hit reordering needs linear probing");
+		static_assert(policy.reordering == HitReordering::None || policy.hot_keys == 0,
+			"hit reordering moves the slots the hot key cache remembers");
+
+		static constexpr bool use_hot_keys = policy.hot_keys != 0;
+
+	protected:
+
+		// TODO: Test out future optimization AVX. New memory layout
+
+		std::unique_ptr<K[]> m_keys;
+		std::unique_ptr<V[]>  m_values;
+		std::unique_ptr<uint8_t[]>   m_used;
+
+		std::unique_ptr<K[]> m_keys_new;
+		std::unique_ptr<V[]>  m_values_new;
+		std::unique_ptr<uint8_t[]>   m_used_new;
+
+	private:
+
+		K m_default_key{}; // never modify this
+		V m_default_value; // never modify this
+		V m_default_value_ref; // never modify this
+
+		HotKeyCache<K, policy.hot_keys> m_hot;
+		std::shared_ptr<const std::vector<size_t>> m_sorted; // slots in key order, reset by every insert, erase and move
+
+	public:
+
+#ifndef NDEBUG
+#define LM_ASSERT_INTEGRITY() DbgIntegrityCheck()
+#else
+#define LM_ASSERT_INTEGRITY()
+#endif
+
+		explicit LinearCoreMapImpl(const size_t capacity)
+		{
+			LinearCoreMapImpl::Init(capacity);
+		}
+
+		explicit LinearCoreMapImpl(HashFunction<K> hash_func)
+		{
+			LinearCoreMapImpl::Init(64, true);
+			this->m_hash = hash_func;
+		}
+
+		explicit LinearCoreMapImpl(const size_t capacity, HashFunction<K> hash_func)
+		{
+			LinearCoreMapImpl::Init(capacity, true);
+			this->m_hash = hash_func;
+		}
+
+		explicit LinearCoreMapImpl()
+		{
+			LinearCoreMapImpl::Init();
+		}
+
+		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
+			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, K>&&
+		std::convertible_to<std::ranges::range_reference_t<ValueRange>, V>
+			explicit LinearCoreMapImpl(KeyRange& keys, ValueRange& values)
+		{
+			LinearCoreMapImpl::Init();
+			EmplaceAll(keys, values);
+		}
+
+		template <std::ranges::input_range PairRange>
+			requires requires(const std::ranges::range_value_t<PairRange>& p) {
+				{ std::get<0>(p) } -> std::convertible_to<K>;
+				{ std::get<1>(p) } -> std::convertible_to<V>;
+		}
+		explicit LinearCoreMapImpl(PairRange& pairs)
+		{
+			LinearCoreMapImpl::Init();
+			EmplaceAll(pairs);
+		}
+
+		explicit LinearCoreMapImpl(K* keys, V* values, const size_t count)
+		{
+			LinearCoreMapImpl::Init();
+			EmplaceAll(keys, values, count);
+		}
+
+		~LinearCoreMapImpl() override = default;
+
+		LinearCoreMapImpl(const LinearCoreMapImpl& other) // Copy constructor (deep copy)
+			: m_keys(std::make_unique<K[]>(other.m_data_size)),
+			m_values(std::make_unique<V[]>(other.m_data_size)),
+			m_used(std::make_unique<uint8_t[]>(other.m_data_size)),
+			m_hot(other.m_hot), // same slots
+			m_sorted(other.m_sorted)
+		{
+			InitDefaults();
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
+			std::copy_n(other.m_values.get(), other.m_data_size, m_values.get());
+			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+		}
+
+		LinearCoreMapImpl& operator=(const LinearCoreMapImpl& other) // Copy assignment (deep copy)
+		{
+			if (this == &other)
+				return *this;
+
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			m_keys = std::make_unique<K[]>(other.m_data_size);
+			m_values = std::make_unique<V[]>(other.m_data_size);
+			m_used = std::make_unique<uint8_t[]>(other.m_data_size);
+
+			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
+			std::copy_n(other.m_values.get(), other.m_data_size, m_values.get());
+			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+			m_hot = other.m_hot;
+			m_sorted = other.m_sorted;
+
+			return *this;
+		}
+
+		LinearCoreMapImpl(LinearCoreMapImpl&& other) noexcept // Move constructor
+			: m_keys(std::move(other.m_keys)),
+			m_values(std::move(other.m_values)),
+			m_used(std::move(other.m_used)),
+			m_keys_new(std::move(other.m_keys_new)),
+			m_values_new(std::move(other.m_values_new)),
+			m_used_new(std::move(other.m_used_new)),
+			m_hot(other.m_hot),
+			m_sorted(std::move(other.m_sorted))
+		{
+			InitDefaults();
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			other.m_count = 0;
+			other.m_deleted = 0;
+			other.m_data_size = 0;
+			other.m_hot.Invalidate();
+		}
+
+		LinearCoreMapImpl& operator=(LinearCoreMapImpl&& other) noexcept // Move assignment
+		{
+			if (this == &other)
+				return *this;
+
+			m_keys = std::move(other.m_keys);
+			m_values = std::move(other.m_values);
+			m_used = std::move(other.m_used);
+
+			m_keys_new = std::move(other.m_keys_new);
+			m_values_new = std::move(other.m_values_new);
+			m_used_new = std::move(other.m_used_new);
+			m_hot = other.m_hot;
+			m_sorted = std::move(other.m_sorted);
+
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			other.m_count = 0;
+			other.m_deleted = 0;
+			other.m_data_size = 0;
+			other.m_hot.Invalidate();
+
+			return *this;
+		}
+
+		void DbgIntegrityCheck() const
+		{
+			/*
+			 * Check if m_default_value has been modified at some point.
+			 */
+
+#ifndef NDEBUG
+			bool ok;
+			if constexpr (Internal::HasEqual<V>::value)
+			{
+				ok = (m_default_value == m_default_value_ref);
+			}
+			else if constexpr (Internal::is_safe_compare_v<V> && sizeof(V) > 0)
+			{
+				ok = std::memcmp(&m_default_value, &m_default_value_ref, sizeof(V)) == 0;
+			}
+			else
+			{
+				ok = true;
+			}
+
+			if (!ok)
+			{
+				std::fprintf(stderr, "LinearMap integrity check failed: m_default_value modified!\n");
+#if defined(_MSC_VER)
+				__debugbreak();
+#elif defined(__GNUC__)
+				__builtin_trap();
+#else
+				std::abort();
+#endif
+			}
+#endif
+		}
+
+		V& operator[](const K& key) noexcept
+		{
+			return GetOrCreate(key, [this] {return m_default_value; });
+		}
+
+		/// <summary>
+		/// Lookup without any side effect, no hit reordering and no hot key cache,
+		/// so concurrent const readers are safe and views of the map stay valid.
+		/// </summary>
+		const V& operator[](const K& key) const noexcept
+		{
+			const auto i = this->FindIndex(key, m_keys.get(), m_used.get());
+			return i != npos ? m_values[i] : m_default_value;
+		}
+
+		/// <summary>
+		/// Checks if a reference (V&) differs from the map's default.
+		/// Works for both comparable and trivially copyable types.
+		/// </summary>
+		/// <param name="value"></param>
+		/// <returns>True, V& value is not the map default</returns>
+		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		{
+			LM_ASSERT_INTEGRITY();
+			auto origin = &m_default_value;
+			auto sample = &value;
+			return origin != sample;
+		}
+
+		/// <summary>
+		/// Clear all data from the map, while keeping the allocated memory.
+		/// </summary>
+		void Clear() noexcept final
+		{
+			std::fill_n(m_used.get(), this->m_data_size, false);
+			std::fill_n(m_keys.get(), this->m_data_size, m_default_key);
+			this->m_count = 0;
+			this->m_deleted = 0;
+			m_hot.Invalidate();
+			m_sorted.reset();
+		}
+
+		/// <summary>
+		/// Will allocate memory for at least 'capacity' elements. Existing data will be lost.
+		/// Should only be used on an empty map, or to clear this map.
+		/// Don't use this before using 'EmplaceAll'. Because, it will ensure capacity internally.
+		/// </summary>
+		/// <param name="capacity">Desired map size</param>
+		void Reserve(const size_t capacity) noexcept final
+		{
+			auto size = this->FormatCapacity(capacity);
+			m_keys = std::make_unique<K[]>(size);
+			m_values = std::make_unique<V[]>(size);
+			m_used = std::make_unique<uint8_t[]>(size);
+			this->m_count = 0;
+			this->m_deleted = 0;
+			this->m_data_size = size;
+			m_hot.Invalidate();
+			m_sorted.reset();
+		}
+
+		[[nodiscard]] bool Contains(const K& key) noexcept
+		{
+			return Find(key) != npos;
+		}
+
+		[[nodiscard]] V& Get(const K& key) noexcept
+		{
+			if constexpr (policy.reordering != HitReordering::None)
+			{
+				const auto [home, last_index] = this->GetSlot(key, this->m_data_size);
+				const auto i = this->FindIndexFrom(key, home, m_keys.get(), m_used.get());
+				if (i == npos)
+					return m_default_value;
+
+				return m_values[i != home ? MoveForward(i) : i];
+			}
+			else
+			{
+				const auto i = Find(key);
+				return i != npos ? m_values[i] : m_default_value;
+			}
+		}
+
+		/// <summary>
+		/// Will return the value for 'key', if found.
+		/// Or emplace a new value created by 'create_func'.
+		/// </summary>
+		/// <typeparam name="F"></typeparam>
+		/// <param name="key"></param>
+		/// <param name="create_func"></param>
+		/// <returns></returns>
+		template <typename KeyVal, typename F> requires std::is_invocable_v<F>
+		V& GetOrCreate(KeyVal&& key, F&& create_func) noexcept
+		{
+			return GetOrCreateImpl(
+				std::forward<KeyVal>(key),
+				[&]() -> V { return std::invoke(std::forward<F>(create_func)); }
+			);
+		}
+
+		template <typename KeyVal, typename... Args>
+		V& GetOrCreate(KeyVal&& key, Args&&... args) noexcept
+		{
+			return GetOrCreateImpl(
+				std::forward<KeyVal>(key),
+				[&]() -> V { return V(std::forward<Args>(args)...); }
+			);
+		}
+
+		template <typename KeyVal, typename... Args>
+		bool TryEmplace(KeyVal&& key, Args&&... args) noexcept
+		{
+			return TryEmplaceImpl(
+				std::forward<KeyVal>(key),
+				[&]() -> V { return V(std::forward<Args>(args)...); }
+			);
+		}
+
+		template <typename KeyVal, typename F> requires std::is_invocable_v<F>
+		bool TryEmplace(KeyVal&& key, F&& create_func) noexcept
+		{
+			return TryEmplaceImpl(
+				std::forward<KeyVal>(key),
+				[&]() -> V { return std::invoke(std::forward<F>(create_func)); }
+			);
+		}
+
+		template <typename KeyType, typename ValType>
+		void Emplace(KeyType&& key, ValType&& value) noexcept
+		{
+			const auto [i, found] = this->FindInsertSlot(key, m_keys.get(), m_used.get());
+			if (found)
+				m_values[i] = std::forward<ValType>(value); // update
+			else
+				Insert(std::forward<KeyType>(key), std::forward<ValType>(value), i);
+		}
+
+		template <typename Tuple>
+		void Emplace(Tuple&& tuple) noexcept requires (std::tuple_size_v<std::remove_cvref_t<Tuple>> == 2)
+		{
+			std::apply([this]<typename T0, typename T1>(T0 && key, T1 && value) {
+				this->Emplace(std::forward<T0>(key), std::forward<T1>(value));
+			}, std::forward<Tuple>(tuple));
+		}
+
+		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
+			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, K>&&
+		std::convertible_to<std::ranges::range_reference_t<ValueRange>, V>
+			void EmplaceAll(KeyRange& keys, ValueRange& values) noexcept
+		{
+			auto key_it = std::begin(keys);
+			auto key_end = std::end(keys);
+			auto val_it = std::begin(values);
+
+			this->EnsureCapacity(std::distance(key_it, key_end));
+
+			while (key_it != key_end)
+			{
+				EmplaceNoGrow(std::ranges::iter_move(key_it), std::ranges::iter_move(val_it));
+
+				++key_it;
+				++val_it;
+			}
+		}
+
+		template <std::ranges::input_range PairRange>
+			requires requires(const std::ranges::range_value_t<PairRange>& p) {
+				{ std::get<0>(p) } -> std::convertible_to<K>;
+				{ std::get<1>(p) } -> std::convertible_to<V>;
+		}
+		void EmplaceAll(PairRange& pairs) noexcept
+		{
+			this->EnsureCapacity(std::ranges::distance(pairs));
+
+			for (auto&& p : pairs)
+			{
+				K&& key = std::get<0>(std::move(p));
+				V&& value = std::get<1>(std::move(p));
+				EmplaceNoGrow(std::move(key), std::move(value));
+			}
+		}
+
+		void EmplaceAll(K* keys, V* values, const size_t count) noexcept
+		{
+			if (!keys || !values || count == 0)
+				return;
+
+			this->EnsureCapacity(count);
+
+			for (size_t idx = 0; idx < count; ++idx)
+			{
+				K& key = keys[idx];
+				V& value = values[idx];
+				EmplaceNoGrow(std::move(key), std::move(value));
+			}
+		}
+
+		/// <summary>
+		/// 'EmplaceAll' on the threads of 'executor', e.g. a WorkStealingPool of LinearMapThreads.h.
+		/// Every region of the table is filled by one task, keys whose probe would leave their region are
+		/// inserted serially after. Tables of fewer than two regions, and probings other than linear, insert serially.
+		/// </summary>
+		template <class Executor>
+		void EmplaceAll(K* keys, V* values, const size_t count, Executor&& executor)
+		{
+			if constexpr (policy.probing != ProbingPolicy::Linear)
+			{
+				EmplaceAll(keys, values, count);
+			}
+			else
+			{
+				if (!keys || !values || count == 0)
+					return;
+
+				if (const auto new_size = this->CapacityFor(count))
+					ResizeOn(new_size, executor);
+
+				std::vector<size_t> deferred;
+				const auto [slots, tombstones] = this->PlaceByRegion(count, [&](const size_t item) -> const K& { return keys[item]; },
+					m_keys.get(), m_used.get(), this->m_data_size, [&](const size_t item, const size_t slot, const bool found)
+					{
+						if (!found)
+							m_keys[slot] = std::move(keys[item]);
+						m_values[slot] = std::move(values[item]);
+					}, executor, deferred);
+
+				this->m_count += slots;
+				this->m_deleted -= tombstones;
+				m_sorted.reset();
+
+				for (const auto item : deferred)
+					EmplaceNoGrow(std::move(keys[item]), std::move(values[item]));
+			}
+		}
+
+		using LinearHash<K, policy>::Rehash;
+
+		/// <summary>
+		/// 'Rehash' on the threads of 'executor', the entries move into the new table region by region like 'EmplaceAll'.
+		/// </summary>
+		template <class Executor>
+		void Rehash(const size_t new_capacity, Executor&& executor)
+		{
+			ResizeOn(this->RehashSize(new_capacity), executor);
+		}
+
+		/// <summary>
+		/// Calls 'f(key, value)' for the entries in the slots [first, last) of the table, 'last' at most 'Capacity()'.
+		/// Disjoint slot ranges can be visited from different threads.
+		/// </summary>
+		template <typename F>
+		void ForEachInSlots(const size_t first, const size_t last, F&& f)
+		{
+			for (auto i = first; i < last; ++i)
+			{
+				if (m_used[i] == slot_full)
+					f(std::as_const(m_keys[i]), m_values[i]);
+			}
+		}
+
+		template <typename F>
+		void ForEachInSlots(const size_t first, const size_t last, F&& f) const
+		{
+			for (auto i = first; i < last; ++i)
+			{
+				if (m_used[i] == slot_full)
+					f(std::as_const(m_keys[i]), std::as_const(m_values[i]));
+			}
+		}
+
+		/// <summary>
+		/// Calls 'f(key, value)' for every entry. An 'executor' splits the table into slot ranges for its threads,
+		/// then 'f' must be safe to call concurrently.
+		/// </summary>
+		template <typename F, class Executor = SerialExecutor>
+		void ForEach(F&& f, Executor&& executor = {})
+		{
+			executor(this->m_data_size, [&](const size_t first, const size_t last) { ForEachInSlots(first, last, f); });
+		}
+
+		template <typename F, class Executor = SerialExecutor>
+		void ForEach(F&& f, Executor&& executor = {}) const
+		{
+			executor(this->m_data_size, [&](const size_t first, const size_t last) { ForEachInSlots(first, last, f); });
+		}
+
+		/// <summary>
+		/// Erases every entry for which 'pred(key, value)' is true, and returns how many.
+		/// 'executor' only runs 'pred', the erases stay on the calling thread, because they shift entries across the ranges.
+		/// </summary>
+		template <typename Pred, class Executor = SerialExecutor>
+		size_t EraseIf(Pred&& pred, Executor&& executor = {})
+		{
+			std::vector<uint8_t> erase(this->m_data_size);
+			executor(this->m_data_size, [&](const size_t first, const size_t last)
+				{
+					for (auto i = first; i < last; ++i)
+						erase[i] = m_used[i] == slot_full && pred(std::as_const(m_keys[i]), std::as_const(m_values[i]));
+				});
+
+			std::vector<K> keys;
+			for (size_t i = 0; i < this->m_data_size; ++i)
+			{
+				if (erase[i])
+					keys.push_back(m_keys[i]);
+			}
+
+			for (const auto& key : keys)
+				Erase(key);
+
+			return keys.size();
+		}
+
+		bool Erase(const K& key) noexcept
+		{
+			auto hole = this->FindIndex(key, m_keys.get(), m_used.get());
+			if (hole == npos)
+				return false;
+
+			m_sorted.reset();
+
+			EraseTrace trace;
+			trace.slot = hole;
+			if constexpr (trace_enabled)
+				trace.probes = this->ProbeLength(key, hole);
+
+			if constexpr (Internal::UsesTombstones(policy))
+			{
+				if constexpr (use_hot_keys)
+					m_hot.Forget(this->HomeSlot(key, this->m_data_size - 1)); // no other entry moves
+
+				m_keys[hole] = m_default_key;
+				m_values[hole] = m_default_value;
+				this->MarkDeleted(m_used.get(), hole);
+				this->Trace(trace);
+				return true;
+			}
+
+			// Backward shift, example with the key at index 4 erased
+			// Homes:  4 4 3 7 4
+			//
+			// [0,0,0,1,1,1,1,1,1,0]
+			// [0,0,0,A,B,C,D,E,F,0]
+			//
+			// C (home 4) moves into the hole at 4, D (home 3) into the new hole at 5.
+			// E stays, its home 7 is after the hole at 6. F (home 4) moves into 6.
+			//
+			// [0,0,0,1,1,1,1,1,0,0]
+			// [0,0,0,A,C,D,F,E,0,0]
+
+			constexpr bool blind_moves = std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V> && sizeof(K) + sizeof(V) <= 32;
+
+			hole = this->template ShiftBackward<blind_moves>(m_keys.get(), m_used.get(), hole, [this](const size_t from, const size_t to)
+				{
+					m_keys[to] = std::move(m_keys[from]);
+					m_values[to] = std::move(m_values[from]);
+				}, trace);
+
+			m_used[hole] = slot_empty;
+			m_keys[hole] = m_default_key;
+			m_values[hole] = m_default_value;
+			m_hot.Invalidate();
+
+			--this->m_count;
+			this->Trace(trace);
+			return true;
+		}
+
+
+		class Iterator {
+		public:
+			using value_type = std::pair<const K, V>;
+			using reference = std::pair<const K, V>&;
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+
+			value_type val;
+
+		private:
+			K* m_keys;
+			V* m_values;
+			uint8_t* m_used;
+			size_t m_index;
+			size_t m_size;
+
+			void advance() noexcept
+			{
+				while (m_index < m_size && m_used[m_index] != slot_full)
+					++m_index;
+			}
+
+		public:
+			Iterator(K* keys, V* values, uint8_t* used, size_t index, size_t size)
+				: m_keys(keys), m_values(values), m_used(used), m_index(index), m_size(size) 
+			{
+				advance();
+			}
+
+			struct Proxy {
+
+				const K& first;
+				V& second;
+
+				// TODO: Help. No idea how to make "auto&" and "auto" work.
+
+				operator value_type() const noexcept {
+					return { first, second };
+				}
+			};
+
+			Proxy operator*() noexcept {
+
+				return Proxy{ m_keys[m_index], m_values[m_index] };
+			}
+
+			Iterator& operator++() noexcept {
+				++m_index;
+				advance();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const noexcept {
+				return m_index == other.m_index;
+			}
+			bool operator!=(const Iterator& other) const noexcept {
+				return !(*this == other);
+			}
+		};
+
+		Iterator begin() const noexcept {
+			return Iterator(m_keys.get(), m_values.get(), m_used.get(), 0, this->m_data_size);
+		}
+
+		Iterator end() const noexcept {
+			return Iterator(m_keys.get(), m_values.get(), m_used.get(), this->m_data_size, this->m_data_size);
+		}
+
+		/// <summary>
+		/// Element of 'Slots()'. An empty slot has 'used' false and the default key and value.
+		/// 'Value' is V, or const V in the views of a const map.
+		/// </summary>
+		template <class Value>
+		struct BasicSlotProxy
+		{
+			const K& key;
+			Value& value;
+			bool used;
+		};
+
+		using SlotProxy = BasicSlotProxy<V>;
+		using ConstSlotProxy = BasicSlotProxy<const V>;
+
+		/// <summary>
+		/// Element of 'Entries() const', the Proxy of 'Iterator' with a const value.
+		/// </summary>
+		struct ConstEntryProxy
+		{
+			const K& first;
+			const V& second;
+
+			operator typename Iterator::value_type() const noexcept { return { first, second }; }
+		};
+
+	private:
+
+		template <class Value>
+		struct SlotAccess
+		{
+			const K* keys;
+			Value* values;
+			const uint8_t* used;
+
+			BasicSlotProxy<Value> operator()(const size_t i) const noexcept { return { keys[i], values[i], used[i] == slot_full }; }
+		};
+
+		struct KeyAccess
+		{
+			const K* keys;
+
+			const K& operator()(const size_t i) const noexcept { return keys[i]; }
+		};
+
+		template <class Value>
+		struct ValueAccess
+		{
+			Value* values;
+
+			Value& operator()(const size_t i) const noexcept { return values[i]; }
+		};
+
+		template <class Value>
+		struct EntryAccess
+		{
+			using Proxy = std::conditional_t<std::is_const_v<Value>, ConstEntryProxy, typename Iterator::Proxy>;
+
+			const K* keys;
+			Value* values;
+
+			Proxy operator()(const size_t i) const noexcept { return { keys[i], values[i] }; }
+		};
+
+	public:
+
+		/// <summary>
+		/// Random access view of all 'Capacity()' slots of the table, as SlotProxy{ key, value, used }.
+		/// Free to create, and it splits for parallel algorithms, unlike the forward 'Iterator':
+		/// std::for_each(std::execution::par_unseq, slots.begin(), slots.end(), [](auto slot) { if (slot.used) ... });
+		/// Values may be changed through it. Any insert, erase or resize invalidates it.
+		/// </summary>
+		[[nodiscard]] SlotView<SlotAccess<V>> Slots() noexcept
+		{
+			return { SlotAccess<V>{ m_keys.get(), m_values.get(), m_used.get() }, this->m_data_size };
+		}
+
+		/// <summary>
+		/// 'Slots()' of a const map, as ConstSlotProxy{ key, value, used }, read only.
+		/// </summary>
+		[[nodiscard]] SlotView<SlotAccess<const V>> Slots() const noexcept
+		{
+			return { SlotAccess<const V>{ m_keys.get(), m_values.get(), m_used.get() }, this->m_data_size };
+		}
+
+		/// <summary>
+		/// Random access view of the keys, in table order. Creating it lists the used slots, one pass over
+		/// the control bytes and 8 bytes per entry, copies of the view share the list. Invalidated like 'Slots()'.
+		/// </summary>
+		[[nodiscard]] SlotView<KeyAccess> Keys() const
+		{
+			return { KeyAccess{ m_keys.get() }, OccupiedSlots(m_used.get(), this->m_data_size, this->m_count) };
+		}
+
+		/// <summary>
+		/// Random access view of the values, in the order of 'Keys()'. Values may be changed through it.
+		/// </summary>
+		[[nodiscard]] SlotView<ValueAccess<V>> Values()
+		{
+			return { ValueAccess<V>{ m_values.get() }, OccupiedSlots(m_used.get(), this->m_data_size, this->m_count) };
+		}
+
+		/// <summary>
+		/// 'Values()' of a const map, read only.
+		/// </summary>
+		[[nodiscard]] SlotView<ValueAccess<const V>> Values() const
+		{
+			return { ValueAccess<const V>{ m_values.get() }, OccupiedSlots(m_used.get(), this->m_data_size, this->m_count) };
+		}
+
+		/// <summary>
+		/// Random access view of the entries as the Proxy{ first, second } of 'Iterator'.
+		/// </summary>
+		[[nodiscard]] SlotView<EntryAccess<V>> Entries()
+		{
+			return { EntryAccess<V>{ m_keys.get(), m_values.get() }, OccupiedSlots(m_used.get(), this->m_data_size, this->m_count) };
+		}
+
+		/// <summary>
+		/// 'Entries()' of a const map, as ConstEntryProxy{ first, second }, read only.
+		/// </summary>
+		[[nodiscard]] SlotView<EntryAccess<const V>> Entries() const
+		{
+			return { EntryAccess<const V>{ m_keys.get(), m_values.get() }, OccupiedSlots(m_used.get(), this->m_data_size, this->m_count) };
+		}
+
+		/// <summary>
+		/// Random access view of the entries like 'Entries()', in ascending key order. The order is kept until the
+		/// next insert, erase or resize, calls in between don't sort again. Integer keys are radix sorted, and
+		/// 'executor' runs the passes. Other keys are compared with 'operator<'. Values may be changed through it,
+		/// which keeps the order. Invalidated like 'Slots()'.
+		/// </summary>
+		template <class Executor = SerialExecutor>
+		[[nodiscard]] SlotView<EntryAccess<V>> SortedView(Executor&& executor = {})
+		{
+			if (!m_sorted)
+				m_sorted = std::make_shared<const std::vector<size_t>>(SortedSlots(m_keys.get(), m_used.get(), this->m_data_size, this->m_count, executor));
+
+			return { EntryAccess<V>{ m_keys.get(), m_values.get() }, m_sorted };
+		}
+
+		/// <summary>
+		/// Replaces the contents of 'out' with copies of the entries, in the order of 'SortedView'.
+		/// </summary>
+		template <class Executor = SerialExecutor>
+		void ExtractSorted(std::vector<std::pair<K, V>>& out, Executor&& executor = {})
+		{
+			const auto sorted = SortedView(executor);
+			out.clear();
+			out.reserve(sorted.size());
+			for (const auto [key, value] : sorted)
+				out.emplace_back(key, value);
+		}
+
+		/// <summary>
+		/// Copies the keys and values into the dense columns 'keys' and 'values', in table order, and returns how many.
+		/// An empty span skips its column, any other needs room for 'Size()' entries. 'executor' copies slot ranges
+		/// in parallel, each range counts its entries first to find its place in the columns.
+		/// </summary>
+		template <class Executor = SerialExecutor>
+		size_t ExportTo(const std::span<K> keys, const std::span<V> values, Executor&& executor = {}) const
+		{
+			if ((!keys.empty() && keys.size() < this->m_count) || (!values.empty() && values.size() < this->m_count))
+				throw std::out_of_range("Export columns are smaller than the map");
+
+			if (!keys.empty() && !values.empty())
+			{
+				CompactSlots(m_used.get(), this->m_data_size, executor, [&](const size_t slot, const size_t position)
+					{
+						keys[position] = m_keys[slot];
+						values[position] = m_values[slot];
+					});
+			}
+			else if (!keys.empty())
+			{
+				CompactSlots(m_used.get(), this->m_data_size, executor, [&](const size_t slot, const size_t position) { keys[position] = m_keys[slot]; });
+			}
+			else if (!values.empty())
+			{
+				CompactSlots(m_used.get(), this->m_data_size, executor, [&](const size_t slot, const size_t position) { values[position] = m_values[slot]; });
+			}
+
+			return this->m_count;
+		}
+
+	private:
+
+		void InitDefaults() noexcept
+		{
+			if constexpr (std::is_trivially_copyable_v<V>)
+			{
+				// make both defaults to guarantee equality
+				// if structs/classes don't set the fields, they will be random
+				std::memset(&m_default_value, 0, sizeof(V));
+				std::memset(&m_default_value_ref, 0, sizeof(V));
+			}
+			else
+			{
+				m_default_value = V{};
+				m_default_value_ref = V{};
+			}
+
+			LM_ASSERT_INTEGRITY();
+		}
+
+		void Init(const size_t capacity = 64, const bool overwrite_hash = false) final
+		{
+			InitDefaults();
+			Reserve(capacity);
+
+			if (overwrite_hash)
+				return;
+
+			if constexpr (!std::is_arithmetic_v<K>)
+			{
+				this->SetDefaultHash(); // non integers use std hash
+			}
+		}
+
+		void Resize(const size_t new_size) noexcept override
+		{
+			m_keys_new = std::make_unique<K[]>(new_size);
+			m_values_new = std::make_unique<V[]>(new_size);
+			m_used_new = std::make_unique<uint8_t[]>(new_size);
+
+			for (size_t i = 0; i < this->m_data_size; ++i)
+			{
+				if (m_used[i] != slot_full)
+					continue;
+
+				EmplaceNewSize(std::move(m_keys[i]), std::move(m_values[i]), new_size);
+			}
+
+			m_keys = std::move(m_keys_new);
+			m_values = std::move(m_values_new);
+			m_used = std::move(m_used_new);
+
+			this->m_deleted = 0;
+			this->m_data_size = new_size;
+			m_hot.Invalidate();
+			m_sorted.reset();
+		}
+
+		template <class Executor>
+		void ResizeOn(const size_t new_size, Executor& executor)
+		{
+			if constexpr (policy.probing != ProbingPolicy::Linear)
+			{
+				Resize(new_size);
+			}
+			else
+			{
+				const auto full = OccupiedSlots(m_used.get(), this->m_data_size, this->m_count); // in the old table
+
+				m_keys_new = std::make_unique<K[]>(new_size);
+				m_values_new = std::make_unique<V[]>(new_size);
+				m_used_new = std::make_unique<uint8_t[]>(new_size);
+
+				std::vector<size_t> deferred;
+				(void)this->PlaceByRegion(full.size(), [&](const size_t item) -> const K& { return m_keys[full[item]]; },
+					m_keys_new.get(), m_used_new.get(), new_size, [&](const size_t item, const size_t slot, bool)
+					{
+						m_keys_new[slot] = std::move(m_keys[full[item]]);
+						m_values_new[slot] = std::move(m_values[full[item]]);
+					}, executor, deferred);
+
+				for (const auto item : deferred)
+					EmplaceNewSize(std::move(m_keys[full[item]]), std::move(m_values[full[item]]), new_size);
+
+				m_keys = std::move(m_keys_new);
+				m_values = std::move(m_values_new);
+				m_used = std::move(m_used_new);
+
+				this->m_deleted = 0;
+				this->m_data_size = new_size;
+				m_hot.Invalidate();
+				m_sorted.reset();
+			}
+		}
+
+		/// <summary>
+		/// Slot of 'key' or 'npos', through the hot key cache if the policy has one.
+		/// </summary>
+		[[nodiscard]] size_t Find(const K& key) noexcept
+		{
+			if constexpr (use_hot_keys)
+			{
+				const auto [home, last_index] = this->GetSlot(key, this->m_data_size);
+
+				auto i = m_hot.Find(key, home);
+				if (i != npos)
+					return i;
+
+				i = this->FindIndexFrom(key, home, m_keys.get(), m_used.get());
+				if (i != npos)
+					m_hot.Store(key, home, i);
+
+				return i;
+			}
+			else
+			{
+				return this->FindIndex(key, m_keys.get(), m_used.get());
+			}
+		}
+
+		/// <summary>
+		/// Swaps the entry in slot 'i' with the one before it (HitReordering::Transpose), 'i' isn't its home slot.
+		/// That slot lies on the probe path of the key, and the entry coming back to 'i' stays behind its own home.
+		/// A tombstone may be swapped the same way.
+		/// </summary>
+		/// <returns>The new slot of the entry</returns>
+		size_t MoveForward(const size_t i) noexcept
+		{
+			const auto target = (i - 1) & (this->m_data_size - 1);
+			m_sorted.reset();
+
+			std::swap(m_keys[i], m_keys[target]);
+			std::swap(m_values[i], m_values[target]);
+			std::swap(m_used[i], m_used[target]);
+			return target;
+		}
+
+		template <typename KeyVal, typename ValueCreator>
+		V& GetOrCreateImpl(KeyVal&& key, ValueCreator&& make_value) noexcept
+		{
+			const auto [i, found] = this->FindInsertSlot(key, m_keys.get(), m_used.get());
+			if (found)
+				return m_values[i];
+
+			const bool will_resize = this->IsOverloaded(m_used[i] == slot_empty); // a reused tombstone adds no load
+			if (unlikely(will_resize))
+			{
+				auto copy = key;
+				InsertAndGrow(std::forward<KeyVal>(key), std::invoke(std::forward<ValueCreator>(make_value)), i);
+				return m_values[this->FindIndex(copy, m_keys.get(), m_used.get())]; // moved by the resize
+			}
+
+			InsertNoGrow(std::forward<KeyVal>(key), std::invoke(std::forward<ValueCreator>(make_value)), i);
+			return m_values[i];
+		}
+
+		template <typename KeyVal, typename ValueCreator>
+		bool TryEmplaceImpl(KeyVal&& key, ValueCreator&& make_value) noexcept
+		{
+			const auto [i, found] = this->FindInsertSlot(key, m_keys.get(), m_used.get());
+			if (found)
+				return false;
+
+			Insert(std::forward<KeyVal>(key), std::invoke(std::forward<ValueCreator>(make_value)), i);
+			return true;
+		}
+
+		template <typename A, typename B>
+		void EmplaceNoGrow(A&& key, B&& value) noexcept
+		{
+			const auto [i, found] = this->FindInsertSlot(key, m_keys.get(), m_used.get());
+			if (found)
+				m_values[i] = std::forward<B>(value);
+			else
+				InsertNoGrow(std::forward<A>(key), std::forward<B>(value), i);
+		}
+
+		template <typename A, typename B>
+		void Insert(A&& key, B&& new_value, size_t i) noexcept
+		{
+			LM_ASSERT_INTEGRITY();
+			this->Occupy(m_used.get(), i);
+			m_keys[i] = std::forward<A>(key);
+			m_values[i] = std::forward<B>(new_value);
+			m_sorted.reset();
+
+			if (unlikely(this->IsOverloaded(0)))
+				this->Resize(this->GrownSize());
+		}
+
+		template <typename A, typename B>
+		void InsertAndGrow(A&& key, B&& new_value, size_t i) noexcept
+		{
+			LM_ASSERT_INTEGRITY();
+			this->Occupy(m_used.get(), i);
+			m_keys[i] = std::forward<A>(key);
+			m_values[i] = std::forward<B>(new_value);
+			this->Resize(this->GrownSize());
+		}
+
+		template <typename A, typename B>
+		void InsertNoGrow(A&& key, B&& new_value, size_t i) noexcept
+		{
+			LM_ASSERT_INTEGRITY();
+			this->Occupy(m_used.get(), i);
+			m_keys[i] = std::forward<A>(key);
+			m_values[i] = std::forward<B>(new_value);
+			m_sorted.reset();
+		}
+
+		template<typename A, typename B>
+		void EmplaceNewSize(A&& key, B&& value, const size_t new_size) noexcept
+		{
+			const auto i = this->FindEmptySlot(key, m_used_new.get(), new_size);
+			m_used_new[i] = slot_full;
+			m_keys_new[i] = std::forward<A>(key);
+			m_values_new[i] = std::forward<B>(value);
+		}
+	};
+
+	}
+
+	template <class K, MapPolicy policy = MapPolicy{}>
+	class LinearSet : public Internal::LinearHash<K, policy> // linear probing hash set
+	{
+		static_assert(!Internal::IsBoundedProbing(policy.probing), "use HopscotchLinearMap or LinearCuckooMap");
+		static_assert(policy.hot_keys == 0, "the hot key cache is only implemented for maps");
+
+	protected:
+
+		std::unique_ptr<K[]> m_keys;
+		std::unique_ptr<uint8_t[]>   m_used;
+		std::unique_ptr<K[]> m_keys_new;
+		std::unique_ptr<uint8_t[]>   m_used_new;
+
+	private:
+
+		K m_default_key{}; // never modify this
+		std::shared_ptr<const std::vector<size_t>> m_sorted; // slots in key order, reset by every insert, erase and move
+
+	public:
+
+		explicit LinearSet(const size_t capacity)
+		{
+			LinearSet::Init(capacity);
+		}
+
+		explicit LinearSet(Internal::HashFunction<K> hash_func)
+		{
+			LinearSet::Init(64, true);
+			this->m_hash = hash_func;
+		}
+
+		explicit LinearSet(const size_t capacity, Internal::HashFunction<K> hash_func)
+		{
+			LinearSet::Init(capacity, true);
+			this->m_hash = hash_func;
+		}
+
+		template <std::ranges::input_range KeyRange>
+			requires std::convertible_to<std::ranges::range_value_t<KeyRange>, K>
+		explicit LinearSet(KeyRange& keys)
+		{
+			LinearSet::Init();
+			EmplaceAll(keys);
+		}
+
+		explicit LinearSet(K* keys, const size_t count)
+		{
+			LinearSet::Init();
+			EmplaceAll(keys, count);
+		}
+
+		explicit LinearSet()
+		{
+			LinearSet::Init();
+		}
+
+		~LinearSet() override = default;
+
+		LinearSet(const LinearSet& other) // Copy constructor (deep copy)
+			: m_keys(std::make_unique<K[]>(other.m_data_size)),
+			m_used(std::make_unique<uint8_t[]>(other.m_data_size)),
+			m_sorted(other.m_sorted) // same slots
+		{
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
+			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+		}
+
+		LinearSet& operator=(const LinearSet& other) // Copy assignment (deep copy)
+		{
+			if (this == &other)
+				return *this;
+
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			m_keys = std::make_unique<K[]>(other.m_data_size);
+			m_used = std::make_unique<uint8_t[]>(other.m_data_size);
+
+			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
+			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+			m_sorted = other.m_sorted;
+
+			return *this;
+		}
+
+		LinearSet(LinearSet&& other) noexcept // Move constructor
+			: m_keys(std::move(other.m_keys)),
+			m_used(std::move(other.m_used)),
+			m_keys_new(std::move(other.m_keys_new)),
+			m_used_new(std::move(other.m_used_new)),
+			m_sorted(std::move(other.m_sorted))
+		{
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			other.m_count = 0;
+			other.m_deleted = 0;
+			other.m_data_size = 0;
+		}
+
+		LinearSet& operator=(LinearSet&& other) noexcept // Move assignment
+		{
+			if (this == &other)
+				return *this;
+
+			m_keys = std::move(other.m_keys);
+			m_used = std::move(other.m_used);
+			m_keys_new = std::move(other.m_keys_new);
+			m_used_new = std::move(other.m_used_new);
+			m_sorted = std::move(other.m_sorted);
+			this->m_count = other.m_count;
+			this->m_deleted = other.m_deleted;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+			other.m_count = 0;
+			other.m_deleted = 0;
+			other.m_data_size = 0;
+			return *this;
+		}
+
+		/// <summary>
+		/// Clear all data from the map, while keeping the allocated memory.
+		/// </summary>
+		void Clear() noexcept final
+		{
+			std::fill_n(m_used.get(), this->m_data_size, false);
+			std::fill_n(m_keys.get(), this->m_data_size, m_default_key);
+			this->m_count = 0;
+			this->m_deleted = 0;
+			m_sorted.reset();
+		}
+
+		/// <summary>
+		/// Will allocate memory for at least 'capacity' elements. Existing data will be lost.
+		/// Should only be used on an empty map, or to clear this map.
+		/// Don't use this before using 'EmplaceAll'. Because, it will ensure capacity internally.
+		/// </summary>
+		/// <param name="capacity">Desired map size</param>
+		void Reserve(const size_t capacity) noexcept final
+		{
+			auto new_size = this->FormatCapacity(capacity);
+			m_keys = std::make_unique<K[]>(new_size);
+			m_used = std::make_unique<uint8_t[]>(new_size);
+			this->m_count = 0;
+			this->m_deleted = 0;
+			this->m_data_size = new_size;
+			m_sorted.reset();
+		}
+
+		[[nodiscard]] bool Contains(const K& key) noexcept
+		{
+			return this->FindIndex(key, m_keys.get(), m_used.get()) != Internal::npos;
+		}
+
+		template <typename KeyType>
+		void Emplace(KeyType&& key) noexcept
+		{
+			const auto [i, found] = this->FindInsertSlot(key, m_keys.get(), m_used.get());
+			if (!found)
+				Insert(std::forward<KeyType>(key), i);
+		}
+		template <std::ranges::input_range KeyRange>
+			requires std::convertible_to<std::ranges::range_value_t<KeyRange>, K>
+		void EmplaceAll(KeyRange& keys) noexcept
+		{
+			auto key_it = std::begin(keys);
+			auto key_end = std::end(keys);
+			this->EnsureCapacity(std::distance(key_it, key_end));
+
+			while (key_it != key_end)
+			{
+				EmplaceNoGrow(std::ranges::iter_move(key_it));
+				++key_it;
+			}
+		}
+
+		void EmplaceAll(K* keys, const size_t count) noexcept
+		{
+			if (!keys || count == 0)
+				return;
+
+			this->EnsureCapacity(count);
+
+			for (size_t idx = 0; idx < count; ++idx)
+			{
+				K& key = keys[idx];
+				EmplaceNoGrow(std::move(key));
+			}
+		}
+
+		/// <summary>
+		/// 'EmplaceAll' on the threads of 'executor', see LinearCoreMapImpl::EmplaceAll.
+		/// </summary>
+		template <class Executor>
+		void EmplaceAll(K* keys, const size_t count, Executor&& executor)
+		{
+			if constexpr (policy.probing != ProbingPolicy::Linear)
+			{
+				EmplaceAll(keys, count);
+			}
+			else
+			{
+				if (!keys || count == 0)
+					return;
+
+				if (const auto new_size = this->CapacityFor(count))
+					ResizeOn(new_size, executor);
+
+				std::vector<size_t> deferred;
+				const auto [slots, tombstones] = this->PlaceByRegion(count, [&](const size_t item) -> const K& { return keys[item]; },
+					m_keys.get(), m_used.get(), this->m_data_size, [&](const size_t item, const size_t slot, const bool found)
+					{
+						if (!found)
+							m_keys[slot] = std::move(keys[item]);
+					}, executor, deferred);
+
+				this->m_count += slots;
+				this->m_deleted -= tombstones;
+				m_sorted.reset();
+
+				for (const auto item : deferred)
+					EmplaceNoGrow(std::move(keys[item]));
+			}
+		}
+
+		using Internal::LinearHash<K, policy>::Rehash;
+
+		/// <summary>
+		/// 'Rehash' on the threads of 'executor'.
+		/// </summary>
+		template <class Executor>
+		void Rehash(const size_t new_capacity, Executor&& executor)
+		{
+			ResizeOn(this->RehashSize(new_capacity), executor);
+		}
+
+		/// <summary>
+		/// Calls 'f(key)' for the keys in the slots [first, last) of the table, 'last' at most 'Capacity()'.
+		/// </summary>
+		template <typename F>
+		void ForEachInSlots(const size_t first, const size_t last, F&& f) const
+		{
+			for (auto i = first; i < last; ++i)
+			{
+				if (m_used[i] == Internal::slot_full)
+					f(std::as_const(m_keys[i]));
+			}
+		}
+
+		/// <summary>
+		/// Calls 'f(key)' for every key, on the threads of 'executor'.
+		/// </summary>
+		template <typename F, class Executor = Internal::SerialExecutor>
+		void ForEach(F&& f, Executor&& executor = {}) const
+		{
+			executor(this->m_data_size, [&](const size_t first, const size_t last) { ForEachInSlots(first, last, f); });
+		}
+
+		/// <summary>
+		/// Erases every key for which 'pred(key)' is true, and returns how many. 'executor' only runs 'pred'.
+		/// </summary>
+		template <typename Pred, class Executor = Internal::SerialExecutor>
+		size_t EraseIf(Pred&& pred, Executor&& executor = {})
+		{
+			std::vector<uint8_t> erase(this->m_data_size);
+			executor(this->m_data_size, [&](const size_t first, const size_t last)
+				{
+					for (auto i = first; i < last; ++i)
+						erase[i] = m_used[i] == Internal::slot_full && pred(std::as_const(m_keys[i]));
+				});
+
+			std::vector<K> keys;
+			for (size_t i = 0; i < this->m_data_size; ++i)
+			{
+				if (erase[i])
+					keys.push_back(m_keys[i]);
+			}
+
+			for (const auto& key : keys)
+				Erase(key);
+
+			return keys.size();
+		}
+
+		template <typename KeyVal>
+		bool TryEmplace(KeyVal&& key) noexcept
+		{
+			const auto [i, found] = this->FindInsertSlot(key, m_keys.get(), m_used.get());
+			if (found)
+				return false; // key already present
+
+			Insert(std::forward<KeyVal>(key), i);
+			return true;
+		}
+
+		bool Erase(const K& key) noexcept
+		{
+			auto hole = this->FindIndex(key, m_keys.get(), m_used.get());
+			if (hole == Internal::npos)
+				return false;
+
+			m_sorted.reset();
+
+			Internal::EraseTrace trace;
+			trace.slot = hole;
+			if constexpr (Internal::trace_enabled)
+				trace.probes = this->ProbeLength(key, hole);
+
+			if constexpr (Internal::UsesTombstones(policy))
+			{
+				m_keys[hole] = m_default_key;
+				this->MarkDeleted(m_used.get(), hole);
+				this->Trace(trace);
+				return true;
+			}
+
+			// Backward shift, same as the map
+			constexpr bool blind_moves = std::is_trivially_copyable_v<K> && sizeof(K) <= 32;
+
+			hole = this->template ShiftBackward<blind_moves>(m_keys.get(), m_used.get(), hole, [this](const size_t from, const size_t to)
+				{
+					m_keys[to] = std::move(m_keys[from]);
+				}, trace);
+
+			m_used[hole] = Internal::slot_empty;
+			m_keys[hole] = m_default_key;
+
+			--this->m_count;
+			this->Trace(trace);
+			return true;
+		}
+
+		class Iterator {
+		public:
+			Iterator(K* keys, uint8_t* used, const size_t index, const size_t size) noexcept
+				: m_keys(keys), m_used(used), m_index(index), m_size(size)
+			{
+				advance();
+			}
+
+			Iterator& operator++() noexcept {
+				++m_index;
+				advance();
+				return *this;
+			}
+
+			bool operator!=(const Iterator& other) const noexcept {
+				return m_index != other.m_index;
+			}
+
+			const K& operator*() const noexcept {
+				return m_keys[m_index];
+			}
+
+		private:
+			K* m_keys;
+			uint8_t* m_used;
+			size_t m_index;
+			size_t m_size;
+
+			void advance() {
+				while (m_index < m_size && m_used[m_index] != Internal::slot_full)
+				{
+					++m_index;
+				}
+			}
+		};
+
+		Iterator begin() {
+			return Iterator(m_keys.get(), m_used.get(), 0, this->m_data_size);
+		}
+
+		Iterator end() {
+			return Iterator(m_keys.get(), m_used.get(), this->m_data_size, this->m_data_size);
+		}
+
+		/// <summary>
+		/// Element of 'Slots()'. An empty slot has 'used' false and the default key.
+		/// </summary>
+		struct SlotProxy
+		{
+			const K& key;
+			bool used;
+		};
+
+	private:
+
+		struct SlotAccess
+		{
+			const K* keys;
+			const uint8_t* used;
+
+			SlotProxy operator()(const size_t i) const noexcept { return { keys[i], used[i] == Internal::slot_full }; }
+		};
+
+		struct KeyAccess
+		{
+			const K* keys;
+
+			const K& operator()(const size_t i) const noexcept { return keys[i]; }
+		};
+
+	public:
+
+		/// <summary>
+		/// Random access view of all 'Capacity()' slots of the table, see LinearCoreMapImpl::Slots.
+		/// </summary>
+		[[nodiscard]] Internal::SlotView<SlotAccess> Slots() const noexcept
+		{
+			return { SlotAccess{ m_keys.get(), m_used.get() }, this->m_data_size };
+		}
+
+		/// <summary>
+		/// Random access view of the keys, in table order, see LinearCoreMapImpl::Keys.
+		/// </summary>
+		[[nodiscard]] Internal::SlotView<KeyAccess> Keys() const
+		{
+			return { KeyAccess{ m_keys.get() }, Internal::OccupiedSlots(m_used.get(), this->m_data_size, this->m_count) };
+		}
+
+		/// <summary>
+		/// Random access view of the keys in ascending order, see LinearCoreMapImpl::SortedView.
+		/// </summary>
+		template <class Executor = Internal::SerialExecutor>
+		[[nodiscard]] Internal::SlotView<KeyAccess> SortedView(Executor&& executor = {})
+		{
+			if (!m_sorted)
+			{
+				m_sorted = std::make_shared<const std::vector<size_t>>(
+					Internal::SortedSlots(m_keys.get(), m_used.get(), this->m_data_size, this->m_count, executor));
+			}
+
+			return { KeyAccess{ m_keys.get() }, m_sorted };
+		}
+
+		/// <summary>
+		/// Replaces the contents of 'out' with the keys in ascending order.
+		/// </summary>
+		template <class Executor = Internal::SerialExecutor>
+		void ExtractSorted(std::vector<K>& out, Executor&& executor = {})
+		{
+			const auto sorted = SortedView(executor);
+			out.assign(sorted.begin(), sorted.end());
+		}
+
+		/// <summary>
+		/// Copies the keys into the dense column 'keys', see LinearCoreMapImpl::ExportTo.
+		/// </summary>
+		template <class Executor = Internal::SerialExecutor>
+		size_t ExportTo(const std::span<K> keys, Executor&& executor = {}) const
+		{
+			if (keys.size() < this->m_count)
+				throw std::out_of_range("Export column is smaller than the set");
+
+			Internal::CompactSlots(m_used.get(), this->m_data_size, executor, [&](const size_t slot, const size_t position) { keys[position] = m_keys[slot]; });
+			return this->m_count;
+		}
+
+	private:
+
+		void Init(const size_t capacity = 64, const bool overwrite_hash = false) final
+		{
+			Reserve(capacity);
+
+			if (overwrite_hash)
+				return;
+
+			if constexpr (!std::is_arithmetic_v<K>)
+			{
+				this->SetDefaultHash(); // non integers use std hash
+			}
+		}
+
+		void Resize(const size_t new_size) noexcept override
+		{
+			m_keys_new = std::make_unique<K[]>(new_size);
+			m_used_new = std::make_unique<uint8_t[]>(new_size);
+
+			for (size_t i = 0; i < this->m_data_size; ++i)
+			{
+				if (m_used[i] != Internal::slot_full)
+					continue;
+
+				EmplaceNewSize(std::move(m_keys[i]), new_size);
+			}
+
+			m_keys = std::move(m_keys_new);
+			m_used = std::move(m_used_new);
+
+			this->m_deleted = 0;
+			this->m_data_size = new_size;
+			m_sorted.reset();
+		}
+
+		template <class Executor>
+		void ResizeOn(const size_t new_size, Executor& executor)
+		{
+			if constexpr (policy.probing != ProbingPolicy::Linear)
+			{
+				Resize(new_size);
+			}
+			else
+			{
+				const auto full = Internal::OccupiedSlots(m_used.get(), this->m_data_size, this->m_count); // in the old table
+
+				m_keys_new = std::make_unique<K[]>(new_size);
+				m_used_new = std::make_unique<uint8_t[]>(new_size);
+
+				std::vector<size_t> deferred;
+				(void)this->PlaceByRegion(full.size(), [&](const size_t item) -> const K& { return m_keys[full[item]]; },
+					m_keys_new.get(), m_used_new.get(), new_size, [&](const size_t item, const size_t slot, bool)
+					{
+						m_keys_new[slot] = std::move(m_keys[full[item]]);
+					}, executor, deferred);
+
+				for (const auto item : deferred)
+					EmplaceNewSize(std::move(m_keys[full[item]]), new_size);
+
+				m_keys = std::move(m_keys_new);
+				m_used = std::move(m_used_new);
+
+				this->m_deleted = 0;
+				this->m_data_size = new_size;
+				m_sorted.reset();
+			}
+		}
+
+		template <typename A>
+		void EmplaceNoGrow(A&& key) noexcept
+		{
+			const auto [i, found] = this->FindInsertSlot(key, m_keys.get(), m_used.get());
+			if (!found)
+				InsertNoGrow(std::forward<A>(key), i);
+		}
+
+		template <typename A>
+		void Insert(A&& key, size_t i) noexcept
+		{
+			this->Occupy(m_used.get(), i);
+			m_keys[i] = std::forward<A>(key);
+			m_sorted.reset();
+
+			if (unlikely(this->IsOverloaded(0)))
+				this->Resize(this->GrownSize());
+		}
+
+		template <typename A>
+		void InsertNoGrow(A&& key, size_t i) noexcept
+		{ 
+			this->Occupy(m_used.get(), i);
+			m_keys[i] = std::forward<A>(key);
+			m_sorted.reset();
+		}
+
+		template <typename A>
+		void EmplaceNewSize(A&& key, const size_t new_size) noexcept
+		{
+			const auto i = this->FindEmptySlot(key, m_used_new.get(), new_size);
+			m_used_new[i] = Internal::slot_full;
+			m_keys_new[i] = std::forward<A>(key);
+		}
+	};
+
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	class LinearCoreMap final : public Internal::LinearCoreMapImpl<K, V, policy> // linear probing hash map
+	{
+	public:
+		explicit LinearCoreMap() : Internal::LinearCoreMapImpl<K, V, policy>()
+		{
+
+		}
+
+		explicit LinearCoreMap(size_t capacity) : Internal::LinearCoreMapImpl<K, V, policy>(capacity)
+		{
+			
+		}
+
+		explicit LinearCoreMap(Internal::HashFunction<K> hash_func) : Internal::LinearCoreMapImpl<K, V, policy>(hash_func)
+		{
+
+		}
+
+		explicit LinearCoreMap(size_t capacity, Internal::HashFunction<K> hash_func) : Internal::LinearCoreMapImpl<K, V, policy>(capacity, hash_func)
+		{
+			
+		}
+
+		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
+			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, K>&&
+		std::convertible_to<std::ranges::range_reference_t<ValueRange>, V>
+			explicit LinearCoreMap(KeyRange& keys, ValueRange& values) : Internal::LinearCoreMapImpl<K, V, policy>(keys, values)
+		{
+
+		}
+
+		template <std::ranges::input_range PairRange>
+			requires requires(const std::ranges::range_value_t<PairRange>& p) {
+				{ std::get<0>(p) } -> std::convertible_to<K>;
+				{ std::get<1>(p) } -> std::convertible_to<V>;
+		}
+		explicit LinearCoreMap(PairRange& pairs) : Internal::LinearCoreMapImpl<K, V, policy>(pairs)
+		{
+
+		}
+
+		explicit LinearCoreMap(K* keys, V* values, const size_t count) : Internal::LinearCoreMapImpl<K, V, policy>(keys, values, count)
+		{
+
+		}
+	};
+
+	template <class T, MapPolicy policy = MapPolicy{}>
+	class LinearMap final : public Internal::LinearCoreMapImpl<size_t, T, policy>
+	{
+	public:
+
+		explicit LinearMap() : Internal::LinearCoreMapImpl<size_t, T, policy>()
+		{
+
+		}
+
+		explicit LinearMap(size_t capacity) : Internal::LinearCoreMapImpl<size_t, T, policy>(capacity)
+		{
+
+		}
+
+		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
+			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, size_t>&&
+		std::convertible_to<std::ranges::range_reference_t<ValueRange>, T>
+			explicit LinearMap(KeyRange& keys, ValueRange& values) : Internal::LinearCoreMapImpl<size_t, T, policy>(keys, values)
+		{
+
+		}
+
+		template <std::ranges::input_range PairRange>
+			requires requires(const std::ranges::range_value_t<PairRange>& p) {
+				{ std::get<0>(p) } -> std::convertible_to<size_t>;
+				{ std::get<1>(p) } -> std::convertible_to<T>;
+		}
+		explicit LinearMap(PairRange& pairs) : Internal::LinearCoreMapImpl<size_t, T, policy>(pairs)
+		{
+
+		}
+
+		explicit LinearMap(size_t* keys, T* values, const size_t count) : Internal::LinearCoreMapImpl<size_t, T, policy>(keys, values, count)
+		{
+
+		}
+	};
+
+	/// <summary>
+	/// Hopscotch hash map with K keys and V values.
+	/// Same flat arrays as LinearCoreMap, plus a neighborhood bitmap per slot: bit j of slot h is set,
+	/// if slot h + j holds a key whose home is h. Every key stays within 'neighborhood' slots of its home,
+	/// so a lookup compares at most the keys of one bitmap, and the table can fill up to 0.9.
+	/// An insert takes the next empty slot, and while it is too far away, swaps it with an entry closer
+	/// to the key's home that may move there. If none may, the table grows.
+	/// Needs a hash with fewer than 'neighborhood' keys per value, the integer hash is Splitmix64.
+	/// Smaller neighborhoods (8, 16, 32) save bitmap memory, but overflow and grow the table at lower loads.
+	/// 64 reaches 0.9 with random keys, 32 only about 0.8 on large tables.
+	/// </summary>
+	template <class K, class V, size_t neighborhood_size = 64>
+	class HopscotchLinearMap final : public Internal::LinearHash<K, MapPolicy{ .probing = ProbingPolicy::Hopscotch }>
+	{
+	public:
+
+		static constexpr size_t neighborhood = neighborhood_size;
+
+		using Iterator = typename Internal::LinearCoreMapImpl<K, V>::Iterator; // same arrays
+
+	private:
+
+		static_assert(neighborhood == 8 || neighborhood == 16 || neighborhood == 32 || neighborhood == 64);
+
+		using Hops = std::conditional_t<neighborhood == 8, uint8_t,
+			std::conditional_t<neighborhood == 16, uint16_t,
+			std::conditional_t<neighborhood == 32, uint32_t, uint64_t>>>;
+
+		std::unique_ptr<K[]> m_keys;
+		std::unique_ptr<V[]> m_values;
+		std::unique_ptr<uint8_t[]> m_used;
+		std::unique_ptr<Hops[]> m_hops; // neighborhood bitmap of every home slot
+
+		K m_default_key{}; // never modify this
+		V m_default_value{}; // never modify this
+
+	public:
+
+		explicit HopscotchLinearMap()
+		{
+			HopscotchLinearMap::Init();
+		}
+
+		explicit HopscotchLinearMap(const size_t capacity)
+		{
+			HopscotchLinearMap::Init(capacity);
+		}
+
+		explicit HopscotchLinearMap(Internal::HashFunction<K> hash_func)
+		{
+			HopscotchLinearMap::Init(64, true);
+			this->m_hash = hash_func;
+		}
+
+		explicit HopscotchLinearMap(const size_t capacity, Internal::HashFunction<K> hash_func)
+		{
+			HopscotchLinearMap::Init(capacity, true);
+			this->m_hash = hash_func;
+		}
+
+		~HopscotchLinearMap() override = default;
+
+		HopscotchLinearMap(const HopscotchLinearMap& other) // Copy constructor (deep copy)
+		{
+			*this = other;
+		}
+
+		HopscotchLinearMap& operator=(const HopscotchLinearMap& other) // Copy assignment (deep copy)
+		{
+			if (this == &other)
+				return *this;
+
+			Allocate(other.m_data_size);
+			this->m_count = other.m_count;
+			this->m_hash = other.m_hash;
+
+			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
+			std::copy_n(other.m_values.get(), other.m_data_size, m_values.get());
+			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+			std::copy_n(other.m_hops.get(), other.m_data_size, m_hops.get());
+
+			return *this;
+		}
+
+		HopscotchLinearMap(HopscotchLinearMap&& other) noexcept // Move constructor
+		{
+			*this = std::move(other);
+		}
+
+		HopscotchLinearMap& operator=(HopscotchLinearMap&& other) noexcept // Move assignment
+		{
+			if (this == &other)
+				return *this;
+
+			m_keys = std::move(other.m_keys);
+			m_values = std::move(other.m_values);
+			m_used = std::move(other.m_used);
+			m_hops = std::move(other.m_hops);
+
+			this->m_count = other.m_count;
+			this->m_data_size = other.m_data_size;
+			this->m_hash = other.m_hash;
+
+			other.m_count = 0;
+			other.m_data_size = 0;
+
+			return *this;
+		}
+
+		V& operator[](const K& key) noexcept
+		{
+			return GetOrCreate(key);
+		}
+
+		/// <summary>
+		/// True, if 'value' isn't the default value that 'Get' returns for missing keys.
+		/// </summary>
+		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		{
+			return &value != &m_default_value;
+		}
+
+		/// <summary>
+		/// Clear all data from the map, while keeping the allocated memory.
+		/// </summary>
+		void Clear() noexcept final
+		{
+			std::fill_n(m_used.get(), this->m_data_size, Internal::slot_empty);
+			std::fill_n(m_hops.get(), this->m_data_size, (Hops)0);
+			std::fill_n(m_keys.get(), this->m_data_size, m_default_key);
+			std::fill_n(m_values.get(), this->m_data_size, m_default_value);
+			this->m_count = 0;
+		}
+
+		/// <summary>
+		/// Will allocate memory for at least 'capacity' elements. Existing data will be lost.
+		/// </summary>
+		void Reserve(const size_t capacity) noexcept final
+		{
+			Allocate(this->FormatCapacity(capacity));
+		}
+
+		[[nodiscard]] bool Contains(const K& key) noexcept
+		{
+			return Find(key) != Internal::npos;
+		}
+
+		[[nodiscard]] V& Get(const K& key) noexcept
+		{
+			const auto i = Find(key);
+			return i != Internal::npos ? m_values[i] : m_default_value;
+		}
+
+		template <typename KeyVal, typename... Args>
+		V& GetOrCreate(KeyVal&& key, Args&&... args) noexcept
+		{
+			const auto i = Find(key);
+			if (i != Internal::npos)
+				return m_values[i];
+
+			return m_values[InsertNew(std::forward<KeyVal>(key), V(std::forward<Args>(args)...))];
+		}
+
+		template <typename KeyVal, typename... Args>
+		bool TryEmplace(KeyVal&& key, Args&&... args) noexcept
+		{
+			if (Find(key) != Internal::npos)
+				return false;
+
+			InsertNew(std::forward<KeyVal>(key), V(std::forward<Args>(args)...));
+			return true;
+		}
+
+		template <typename KeyType, typename ValType>
+		void Emplace(KeyType&& key, ValType&& value) noexcept
+		{
+			const auto i = Find(key);
+			if (i != Internal::npos)
+				m_values[i] = std::forward<ValType>(value); // update
+			else
+				InsertNew(std::forward<KeyType>(key), std::forward<ValType>(value));
+		}
+
+		void EmplaceAll(K* keys, V* values, const size_t count) noexcept
+		{
+			this->EnsureCapacity(count);
+
+			for (size_t i = 0; i < count; ++i)
+				Emplace(std::move(keys[i]), std::move(values[i]));
+		}
+
+		/// <summary>
+		/// Erase only clears the slot and its bit, hopscotch tables need neither shifts nor tombstones.
+		/// </summary>
+		bool Erase(const K& key) noexcept
+		{
+			auto [home, last_index] = this->GetSlot(key, this->m_data_size);
+			Internal::EraseTrace trace;
+
+			for (auto hops = m_hops[home]; hops; hops &= hops - 1)
+			{
+				const auto offset = (size_t)std::countr_zero(hops);
+				const auto i = (home + offset) & last_index;
+				++trace.probes;
+
+				if (!(m_keys[i] == key))
+					continue;
+
+				m_hops[home] &= ~((Hops)1 << offset);
+				m_used[i] = Internal::slot_empty;
+				m_keys[i] = m_default_key;
+				m_values[i] = m_default_value;
+				--this->m_count;
+
+				trace.slot = i;
+				this->Trace(trace);
+				return true;
+			}
+
+			return false;
+		}
+
+		Iterator begin() const noexcept {
+			return Iterator(m_keys.get(), m_values.get(), m_used.get(), 0, this->m_data_size);
+		}
+
+		Iterator end() const noexcept {
+			return Iterator(m_keys.get(), m_values.get(), m_used.get(), this->m_data_size, this->m_data_size);
+		}
+
+	private:
+
+		void Init(const size_t capacity = 64, const bool overwrite_hash = false) final
+		{
+			Reserve(capacity);
+
+			if (overwrite_hash)
+				return;
+
+			if constexpr (!std::is_arithmetic_v<K>)
+			{
+				this->SetDefaultHash(); // non integers use std hash
+			}
+		}
+
+		/// <summary>
+		/// New empty arrays, at least one neighborhood large, so neighborhoods don't overlap themselves.
+		/// </summary>
+		void Allocate(size_t size)
+		{
+			size = (std::max)(size, neighborhood);
+			m_keys = std::make_unique<K[]>(size);
+			m_values = std::make_unique<V[]>(size);
+			m_used = std::make_unique<uint8_t[]>(size);
+			m_hops = std::make_unique<Hops[]>(size);
+			this->m_count = 0;
+			this->m_data_size = size;
+		}
 
-		explicit LinearCoreMapImpl(const size_t capacity, HashFunction<K> hash_func)
+		[[nodiscard]] size_t Find(const K& key) noexcept
 		{
-			LinearCoreMapImpl::Init(capacity, true);
-			this->m_hash = hash_func;
+			auto [home, last_index] = this->GetSlot(key, this->m_data_size);
+
+			for (auto hops = m_hops[home]; hops; hops &= hops - 1)
+			{
+				const auto i = (home + (size_t)std::countr_zero(hops)) & last_index;
+				if (m_keys[i] == key)
+					return i;
+			}
+
+			return Internal::npos;
 		}
 
-		explicit LinearCoreMapImpl()
+		/// <summary>
+		/// Frees a slot within the neighborhood of 'home', or returns 'npos' if the entries in the way can't move.
+		/// </summary>
+		[[nodiscard]] size_t MakeRoom(const size_t home) noexcept
 		{
-			LinearCoreMapImpl::Init();
+			const auto last_index = this->m_data_size - 1;
+
+			auto free = home;
+			while (m_used[free])
+				free = (free + 1) & last_index; // the load factor keeps empty slots around
+
+			// Hop the free slot back. An entry before it may move into it, if the free slot is still
+			// in the neighborhood of the entry's home. Farthest homes first, they free the earliest slots.
+			//
+			// neighborhood 4, the new key has home 1, the first free slot is 5
+			// slot: 1 2 3 4 5
+			// home: 1 2 1 4 _
+			//
+			// The entry in slot 2 (home 2) moves to 5, 3 slots from its home. Slot 2 is 1 slot from home 1, done.
+			while (((free - home) & last_index) >= neighborhood)
+			{
+				bool moved = false;
+
+				for (size_t distance = neighborhood - 1; distance > 0; --distance)
+				{
+					const auto candidate = (free - distance) & last_index;
+					const auto before_free = (Hops)(m_hops[candidate] & (((Hops)1 << distance) - 1));
+					if (!before_free)
+						continue;
+
+					const auto offset = (size_t)std::countr_zero(before_free);
+					const auto from = (candidate + offset) & last_index;
+
+					m_keys[free] = std::move(m_keys[from]);
+					m_values[free] = std::move(m_values[from]);
+					m_used[free] = Internal::slot_full;
+					m_used[from] = Internal::slot_empty;
+					m_hops[candidate] ^= ((Hops)1 << offset) | ((Hops)1 << distance);
+
+					free = from;
+					moved = true;
+					break;
+				}
+
+				if (!moved)
+					return Internal::npos;
+			}
+
+			return free;
 		}
 
-		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
-			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, K>&&
-		std::convertible_to<std::ranges::range_reference_t<ValueRange>, V>
-			explicit LinearCoreMapImpl(KeyRange& keys, ValueRange& values)
+		/// <summary>
+		/// Inserts a key that isn't in the map yet, grows the table until it fits.
+		/// </summary>
+		/// <returns>Slot of the new entry</returns>
+		template <typename A, typename B>
+		size_t InsertNew(A&& key, B&& value) noexcept
 		{
-			LinearCoreMapImpl::Init();
-			EmplaceAll(keys, values);
+			if (unlikely(this->IsOverloaded(1)))
+				Resize(this->m_data_size * 2);
+
+			for (;;)
+			{
+				auto [home, last_index] = this->GetSlot(key, this->m_data_size);
+				const auto i = MakeRoom(home);
+
+				if (likely(i != Internal::npos))
+				{
+					m_hops[home] |= (Hops)1 << ((i - home) & last_index);
+					m_used[i] = Internal::slot_full;
+					m_keys[i] = std::forward<A>(key);
+					m_values[i] = std::forward<B>(value);
+					++this->m_count;
+					return i;
+				}
+
+				Resize(this->m_data_size * 2); // neighborhood full
+			}
 		}
 
-		template <std::ranges::input_range PairRange>
-			requires requires(const std::ranges::range_value_t<PairRange>& p) {
-				{ std::get<0>(p) } -> std::convertible_to<K>;
-				{ std::get<1>(p) } -> std::convertible_to<V>;
+		/// <summary>
+		/// Reinserts all entries into a table of 'new_size'. If one doesn't fit, 'InsertNew' grows the new table.
+		/// </summary>
+		void Resize(const size_t new_size) noexcept override
+		{
+			auto keys = std::move(m_keys);
+			auto values = std::move(m_values);
+			auto used = std::move(m_used);
+			const auto old_size = this->m_data_size;
+
+			Allocate(new_size);
+
+			for (size_t i = 0; i < old_size; ++i)
+			{
+				if (used[i] == Internal::slot_full)
+					InsertNew(std::move(keys[i]), std::move(values[i]));
+			}
 		}
-		explicit LinearCoreMapImpl(PairRange& pairs)
+	};
+
+	/// <summary>
+	/// Bucketized cuckoo hash map with K keys and V values, for lookups with a hard worst case.
+	/// Every key lives in one of two buckets, picked by two mixers of the 'MixHash' family (Splitmix64, Wyhash Final).
+	/// A bucket holds 'bucket_slots' (4 or 8) keys, values and control bytes, aligned to its size up to a cache line.
+	/// So a lookup reads at most two buckets, one cache line each for <uint64_t, int> with 4 slots.
+	/// If both buckets are full, an insert searches breadth first for the shortest chain of keys that can move
+	/// to their other bucket, and frees a slot at its start. The table grows at a load of 0.95, or earlier when there is none.
+	/// Needs a hash with fewer than 2 * 'bucket_slots' keys per value.
+	/// </summary>
+	template <class K, class V, size_t bucket_slots = 4>
+	class LinearCuckooMap final : public Internal::LinearHash<K, MapPolicy{ .probing = ProbingPolicy::Cuckoo }>
+	{
+		static_assert(bucket_slots == 4 || bucket_slots == 8);
+
+		static constexpr size_t cache_line = 64;
+		static constexpr size_t bucket_bytes = (sizeof(K) + sizeof(V) + 1) * bucket_slots;
+
+		struct alignas((std::min)(cache_line, std::bit_ceil(bucket_bytes))) Bucket
 		{
-			LinearCoreMapImpl::Init();
-			EmplaceAll(pairs);
+			uint8_t used[bucket_slots] = {};
+			K keys[bucket_slots] = {};
+			V values[bucket_slots] = {};
+		};
+
+		// Breadth first search of a displacement chain. Keys that can move to their other bucket are
+		// nodes, at most 'max_chain' moves from a bucket of the new key. Depth 4 visits up to
+		// 2 + 8 + 32 + 128 buckets with 4 slots.
+		static constexpr size_t max_chain = 4;
+		static constexpr size_t max_search = 256;
+
+		struct SearchNode
+		{
+			size_t bucket;
+			size_t parent; // node of the bucket whose key leads here, npos for the two start buckets
+			size_t slot;   // slot of that key in the parent bucket
+			size_t depth;
+		};
+
+		std::unique_ptr<Bucket[]> m_buckets;
+
+		K m_default_key{}; // never modify this
+		V m_default_value{}; // never modify this
+
+	public:
+
+		explicit LinearCuckooMap()
+		{
+			LinearCuckooMap::Init();
 		}
 
-		explicit LinearCoreMapImpl(K* keys, V* values, const size_t count)
+		explicit LinearCuckooMap(const size_t capacity)
 		{
-			LinearCoreMapImpl::Init();
-			EmplaceAll(keys, values, count);
+			LinearCuckooMap::Init(capacity);
 		}
 
-		~LinearCoreMapImpl() override = default;
+		explicit LinearCuckooMap(Internal::HashFunction<K> hash_func)
+		{
+			LinearCuckooMap::Init(64, true);
+			this->m_hash = hash_func;
+		}
 
-		LinearCoreMapImpl(const LinearCoreMapImpl& other) // Copy constructor (deep copy)
-			: m_keys(std::make_unique<K[]>(other.m_data_size)),
-			m_values(std::make_unique<V[]>(other.m_data_size)),
-			m_used(std::make_unique<uint8_t[]>(other.m_data_size))
+		explicit LinearCuckooMap(const size_t capacity, Internal::HashFunction<K> hash_func)
 		{
-			this->m_count = other.m_count;
-			this->m_data_size = other.m_data_size;
-			this->m_hash = other.m_hash;
+			LinearCuckooMap::Init(capacity, true);
+			this->m_hash = hash_func;
+		}
 
-			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
-			std::copy_n(other.m_values.get(), other.m_data_size, m_values.get());
-			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+		~LinearCuckooMap() override = default;
+
+		LinearCuckooMap(const LinearCuckooMap& other) // Copy constructor (deep copy)
+		{
+			*this = other;
 		}
 
-		LinearCoreMapImpl& operator=(const LinearCoreMapImpl& other) // Copy assignment (deep copy)
+		LinearCuckooMap& operator=(const LinearCuckooMap& other) // Copy assignment (deep copy)
 		{
 			if (this == &other)
 				return *this;
 
+			Allocate(other.m_data_size);
 			this->m_count = other.m_count;
-			this->m_data_size = other.m_data_size;
 			this->m_hash = other.m_hash;
-
-			m_keys = std::make_unique<K[]>(other.m_data_size);
-			m_values = std::make_unique<V[]>(other.m_data_size);
-			m_used = std::make_unique<uint8_t[]>(other.m_data_size);
-
-			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
-			std::copy_n(other.m_values.get(), other.m_data_size, m_values.get());
-			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+			std::copy_n(other.m_buckets.get(), other.m_data_size / bucket_slots, m_buckets.get());
 
 			return *this;
 		}
 
-		LinearCoreMapImpl(LinearCoreMapImpl&& other) noexcept // Move constructor
-			: m_keys(std::move(other.m_keys)),
-			m_values(std::move(other.m_values)),
-			m_used(std::move(other.m_used)),
-			m_keys_new(std::move(other.m_keys_new)),
-			m_values_new(std::move(other.m_values_new)),
-			m_used_new(std::move(other.m_used_new))
+		LinearCuckooMap(LinearCuckooMap&& other) noexcept // Move constructor
+		{
+			*this = std::move(other);
+		}
+
+		LinearCuckooMap& operator=(LinearCuckooMap&& other) noexcept // Move assignment
 		{
+			if (this == &other)
+				return *this;
+
+			m_buckets = std::move(other.m_buckets);
 			this->m_count = other.m_count;
 			this->m_data_size = other.m_data_size;
 			this->m_hash = other.m_hash;
 
 			other.m_count = 0;
 			other.m_data_size = 0;
+
+			return *this;
+		}
+
+		V& operator[](const K& key) noexcept
+		{
+			return GetOrCreate(key);
+		}
+
+		/// <summary>
+		/// True, if 'value' isn't the default value that 'Get' returns for missing keys.
+		/// </summary>
+		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		{
+			return &value != &m_default_value;
+		}
+
+		/// <summary>
+		/// Clear all data from the map, while keeping the allocated memory.
+		/// </summary>
+		void Clear() noexcept final
+		{
+			std::fill_n(m_buckets.get(), this->m_data_size / bucket_slots, Bucket{});
+			this->m_count = 0;
+		}
+
+		/// <summary>
+		/// Will allocate memory for at least 'capacity' elements. Existing data will be lost.
+		/// </summary>
+		void Reserve(const size_t capacity) noexcept final
+		{
+			Allocate(this->FormatCapacity(capacity));
+		}
+
+		[[nodiscard]] bool Contains(const K& key) noexcept
+		{
+			return Find(key) != Internal::npos;
+		}
+
+		[[nodiscard]] V& Get(const K& key) noexcept
+		{
+			const auto i = Find(key);
+			return i != Internal::npos ? ValueAt(i) : m_default_value;
+		}
+
+		template <typename KeyVal, typename... Args>
+		V& GetOrCreate(KeyVal&& key, Args&&... args) noexcept
+		{
+			const auto i = Find(key);
+			if (i != Internal::npos)
+				return ValueAt(i);
+
+			return ValueAt(InsertNew(std::forward<KeyVal>(key), V(std::forward<Args>(args)...)));
+		}
+
+		template <typename KeyVal, typename... Args>
+		bool TryEmplace(KeyVal&& key, Args&&... args) noexcept
+		{
+			if (Find(key) != Internal::npos)
+				return false;
+
+			InsertNew(std::forward<KeyVal>(key), V(std::forward<Args>(args)...));
+			return true;
+		}
+
+		template <typename KeyType, typename ValType>
+		void Emplace(KeyType&& key, ValType&& value) noexcept
+		{
+			const auto i = Find(key);
+			if (i != Internal::npos)
+				ValueAt(i) = std::forward<ValType>(value); // update
+			else
+				InsertNew(std::forward<KeyType>(key), std::forward<ValType>(value));
+		}
+
+		void EmplaceAll(K* keys, V* values, const size_t count) noexcept
+		{
+			this->EnsureCapacity(count);
+
+			for (size_t i = 0; i < count; ++i)
+				Emplace(std::move(keys[i]), std::move(values[i]));
+		}
+
+		bool Erase(const K& key) noexcept
+		{
+			const auto i = Find(key);
+			if (i == Internal::npos)
+				return false;
+
+			auto& bucket = m_buckets[i / bucket_slots];
+			const auto slot = i % bucket_slots;
+			bucket.used[slot] = Internal::slot_empty;
+			bucket.keys[slot] = m_default_key;
+			bucket.values[slot] = m_default_value;
+			--this->m_count;
+
+			Internal::EraseTrace trace;
+			trace.slot = i;
+			if constexpr (Internal::trace_enabled)
+				trace.probes = i / bucket_slots == FirstBucket(this->InvokeHash(key)) ? 1 : 2; // buckets
+			this->Trace(trace);
+			return true;
+		}
+
+		class Iterator {
+		public:
+			using value_type = std::pair<const K, V>;
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+
+		private:
+			Bucket* m_buckets;
+			size_t m_index;
+			size_t m_size;
+
+			void advance() noexcept
+			{
+				while (m_index < m_size && m_buckets[m_index / bucket_slots].used[m_index % bucket_slots] != Internal::slot_full)
+					++m_index;
+			}
+
+		public:
+			Iterator(Bucket* buckets, const size_t index, const size_t size) noexcept
+				: m_buckets(buckets), m_index(index), m_size(size)
+			{
+				advance();
+			}
+
+			struct Proxy {
+
+				const K& first;
+				V& second;
+
+				operator value_type() const noexcept {
+					return { first, second };
+				}
+			};
+
+			Proxy operator*() noexcept {
+				auto& bucket = m_buckets[m_index / bucket_slots];
+				return Proxy{ bucket.keys[m_index % bucket_slots], bucket.values[m_index % bucket_slots] };
+			}
+
+			Iterator& operator++() noexcept {
+				++m_index;
+				advance();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const noexcept {
+				return m_index == other.m_index;
+			}
+			bool operator!=(const Iterator& other) const noexcept {
+				return !(*this == other);
+			}
+		};
+
+		Iterator begin() const noexcept {
+			return Iterator(m_buckets.get(), 0, this->m_data_size);
+		}
+
+		Iterator end() const noexcept {
+			return Iterator(m_buckets.get(), this->m_data_size, this->m_data_size);
+		}
+
+	private:
+
+		void Init(const size_t capacity = 64, const bool overwrite_hash = false) final
+		{
+			Reserve(capacity);
+
+			if (overwrite_hash)
+				return;
+
+			if constexpr (!std::is_arithmetic_v<K>)
+			{
+				this->SetDefaultHash(); // non integers use std hash
+			}
+		}
+
+		/// <summary>
+		/// New empty buckets for 'size' slots, at least two buckets.
+		/// </summary>
+		void Allocate(size_t size)
+		{
+			size = (std::max)(size, 2 * bucket_slots);
+			m_buckets = std::make_unique<Bucket[]>(size / bucket_slots);
+			this->m_count = 0;
+			this->m_data_size = size;
 		}
 
-		LinearCoreMapImpl& operator=(LinearCoreMapImpl&& other) noexcept // Move assignment
+		V& ValueAt(const size_t i) noexcept
 		{
-			if (this == &other)
-				return *this;
-
-			m_keys = std::move(other.m_keys);
-			m_values = std::move(other.m_values);
-			m_used = std::move(other.m_used);
+			return m_buckets[i / bucket_slots].values[i % bucket_slots];
+		}
 
-			m_keys_new = std::move(other.m_keys_new);
-			m_values_new = std::move(other.m_values_new);
-			m_used_new = std::move(other.m_used_new);
+		[[nodiscard]] size_t BucketMask() const noexcept
+		{
+			return this->m_data_size / bucket_slots - 1;
+		}
 
-			this->m_count = other.m_count;
-			this->m_data_size = other.m_data_size;
-			this->m_hash = other.m_hash;
+		[[nodiscard]] size_t FirstBucket(const size_t hash) const noexcept
+		{
+			return Internal::MixHash<Internal::HashMixer::Splitmix64>(hash, BucketMask() + 1) & BucketMask();
+		}
 
-			other.m_count = 0;
-			other.m_data_size = 0;
+		/// <summary>
+		/// The bucket of 'hash' that isn't 'bucket'. Never the same bucket, so every key has two choices.
+		/// </summary>
+		[[nodiscard]] size_t OtherBucket(const size_t hash, const size_t bucket) const noexcept
+		{
+			const auto first = FirstBucket(hash);
+			auto second = Internal::MixHash<Internal::HashMixer::WyhashFinal>(hash, BucketMask() + 1) & BucketMask();
+			if (second == first)
+				second = first ^ 1;
 
-			return *this;
+			return bucket == first ? second : first;
 		}
 
-		void DbgIntegrityCheck() const
+		/// <summary>
+		/// Slot of 'key' in 'bucket', or 'npos'.
+		/// </summary>
+		[[nodiscard]] size_t FindInBucket(const K& key, const size_t bucket) const noexcept
 		{
-			/*
-			 * Check if m_default_value has been modified at some point.
-			 */
-
-#ifndef NDEBUG
-			bool ok;
-			if constexpr (Internal::HasEqual<V>::value)
-			{
-				ok = (m_default_value == m_default_value_ref);
-			}
-			else if constexpr (Internal::is_safe_compare_v<V> && sizeof(V) > 0)
-			{
-				ok = std::memcmp(&m_default_value, &m_default_value_ref, sizeof(V)) == 0;
-			}
-			else
+			const auto& b = m_buckets[bucket];
+			for (size_t slot = 0; slot < bucket_slots; ++slot)
 			{
-				ok = true;
+				if (b.used[slot] && b.keys[slot] == key)
+					return bucket * bucket_slots + slot;
 			}
 
-			if (!ok)
-			{
-				std::fprintf(stderr, "LinearMap integrity check failed: m_default_value modified!\n");
-#if defined(_MSC_VER)
-				__debugbreak();
-#elif defined(__GNUC__)
-				__builtin_trap();
-#else
-				std::abort();
-#endif
-			}
-#endif
+			return Internal::npos;
 		}
 
-		V& operator[](const K& key) noexcept
+		[[nodiscard]] size_t FreeSlot(const size_t bucket) const noexcept
 		{
-			return GetOrCreate(key, [this] {return m_default_value; });
+			const auto& b = m_buckets[bucket];
+			for (size_t slot = 0; slot < bucket_slots; ++slot)
+			{
+				if (!b.used[slot])
+					return slot;
+			}
+
+			return Internal::npos;
 		}
 
-		const V& operator[](const K& key) const noexcept
+		[[nodiscard]] size_t Find(const K& key) noexcept
 		{
-			return Get(key);
+			if constexpr (!std::is_arithmetic_v<K>)
+			{
+				if (!this->m_hash)
+					UNREACHABLE(); // arithmetic keys don't use m_hash, so it may be null
+			}
+
+			const auto hash = this->InvokeHash(key);
+			const auto first = FirstBucket(hash);
+
+			const auto i = FindInBucket(key, first);
+			if (i != Internal::npos)
+				return i;
+
+			return FindInBucket(key, OtherBucket(hash, first));
 		}
 
 		/// <summary>
-		/// Checks if a reference (V&) differs from the map's default.
-		/// Works for both comparable and trivially copyable types.
+		/// Moves the entry of 'from' into the empty slot 'to', 'from' is empty afterwards.
 		/// </summary>
-		/// <param name="value"></param>
-		/// <returns>True, V& value is not the map default</returns>
-		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		void MoveEntry(const size_t from_bucket, const size_t from_slot, const size_t to_bucket, const size_t to_slot) noexcept
 		{
-			LM_ASSERT_INTEGRITY();
-			auto origin = &m_default_value;
-			auto sample = &value;
-			return origin != sample;
+			auto& from = m_buckets[from_bucket];
+			auto& to = m_buckets[to_bucket];
+			to.keys[to_slot] = std::move(from.keys[from_slot]);
+			to.values[to_slot] = std::move(from.values[from_slot]);
+			to.used[to_slot] = Internal::slot_full;
+			from.used[from_slot] = Internal::slot_empty;
 		}
 
 		/// <summary>
-		/// Clear all data from the map, while keeping the allocated memory.
+		/// True, if 'bucket' is 'node' or one of its parents. A chain must not pass a bucket twice,
+		/// or a later move would take the slot an earlier one filled.
 		/// </summary>
-		void Clear() noexcept final
+		[[nodiscard]] static bool OnChain(const SearchNode* nodes, size_t node, const size_t bucket) noexcept
 		{
-			std::fill_n(m_used.get(), this->m_data_size, false);
-			std::fill_n(m_keys.get(), this->m_data_size, 0);
-			this->m_count = 0;
+			for (; node != Internal::npos; node = nodes[node].parent)
+			{
+				if (nodes[node].bucket == bucket)
+					return true;
+			}
+
+			return false;
 		}
 
 		/// <summary>
-		/// Will allocate memory for at least 'capacity' elements. Existing data will be lost.
-		/// Should only be used on an empty map, or to clear this map.
-		/// Don't use this before using 'EmplaceAll'. Because, it will ensure capacity internally.
+		/// Frees a slot in one of the buckets 'first' and 'second', by moving a chain of keys to their other buckets.
 		/// </summary>
-		/// <param name="capacity">Desired map size</param>
-		void Reserve(const size_t capacity) noexcept final
+		/// <returns>The free slot, or 'npos' if no chain of up to 'max_chain' moves ends in a bucket with space</returns>
+		[[nodiscard]] size_t MakeRoom(const size_t first, const size_t second) noexcept
 		{
-			auto size = this->FormatCapacity(capacity);
-			m_keys = std::make_unique<K[]>(size);
-			m_values = std::make_unique<V[]>(size);
-			m_used = std::make_unique<uint8_t[]>(size);
-			this->m_count = 0;
-			this->m_data_size = size;
-		}
+			SearchNode nodes[max_search];
+			size_t count = 0;
+			nodes[count++] = { first, Internal::npos, 0, 0 };
+			nodes[count++] = { second, Internal::npos, 0, 0 };
 
-		[[nodiscard]] bool Contains(const K& key) noexcept
-		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
+			for (size_t node = 0; node < count; ++node)
 			{
-				if (!m_used[i])
-					return false;
+				const auto current = nodes[node];
+				const auto& bucket = m_buckets[current.bucket];
 
-				if (m_keys[i] == key)
-					return true;
+				for (size_t slot = 0; slot < bucket_slots; ++slot)
+				{
+					const auto other = OtherBucket(this->InvokeHash(bucket.keys[slot]), current.bucket);
+					const auto free = FreeSlot(other);
+
+					if (free != Internal::npos)
+					{
+						// end of the chain found, move the keys back to front, each into the slot the next one left
+						auto to_bucket = other, to_slot = free;
+						auto from_bucket = current.bucket, from_slot = slot;
+
+						for (auto at = node; ; at = nodes[at].parent)
+						{
+							MoveEntry(from_bucket, from_slot, to_bucket, to_slot);
+							to_bucket = from_bucket;
+							to_slot = from_slot;
+
+							if (nodes[at].parent == Internal::npos)
+								return to_bucket * bucket_slots + to_slot;
+
+							from_bucket = nodes[nodes[at].parent].bucket;
+							from_slot = nodes[at].slot;
+						}
+					}
+
+					if (current.depth + 1 < max_chain && count < max_search && !OnChain(nodes, node, other))
+						nodes[count++] = { other, node, slot, current.depth + 1 };
+				}
 			}
+
+			return Internal::npos;
 		}
 
-		[[nodiscard]] V& Get(const K& key) noexcept
+		/// <summary>
+		/// Inserts a key that isn't in the map yet, grows the table until it fits.
+		/// </summary>
+		/// <returns>Slot of the new entry</returns>
+		template <typename A, typename B>
+		size_t InsertNew(A&& key, B&& value) noexcept
 		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start;; i = (i + 1) & last_index)
+			if (unlikely(this->IsOverloaded(1)))
+				Resize(this->m_data_size * 2);
+
+			for (;;)
 			{
-				if (!m_used[i])
-					return m_default_value;
+				const auto hash = this->InvokeHash(key);
+				const auto first = FirstBucket(hash);
+				const auto second = OtherBucket(hash, first);
 
-				if (m_keys[i] == key)
-					return m_values[i];
+				auto bucket = first;
+				auto slot = FreeSlot(first);
+				if (slot == Internal::npos)
+				{
+					bucket = second;
+					slot = FreeSlot(second);
+				}
+
+				auto i = slot != Internal::npos ? bucket * bucket_slots + slot : MakeRoom(first, second);
+				if (likely(i != Internal::npos))
+				{
+					auto& b = m_buckets[i / bucket_slots];
+					b.used[i % bucket_slots] = Internal::slot_full;
+					b.keys[i % bucket_slots] = std::forward<A>(key);
+					b.values[i % bucket_slots] = std::forward<B>(value);
+					++this->m_count;
+					return i;
+				}
+
+				Resize(this->m_data_size * 2); // no chain found
 			}
 		}
 
 		/// <summary>
-		/// Will return the value for 'key', if found.
-		/// Or emplace a new value created by 'create_func'.
+		/// Reinserts all entries into a table of 'new_size'. If one doesn't fit, 'InsertNew' grows the new table.
 		/// </summary>
-		/// <typeparam name="F"></typeparam>
-		/// <param name="key"></param>
-		/// <param name="create_func"></param>
-		/// <returns></returns>
-		template <typename KeyVal, typename F> requires std::is_invocable_v<F>
-		V& GetOrCreate(KeyVal&& key, F&& create_func) noexcept
+		void Resize(const size_t new_size) noexcept override
 		{
-			return GetOrCreateImpl(
-				std::forward<KeyVal>(key),
-				[&]() -> V { return std::invoke(std::forward<F>(create_func)); }
-			);
+			auto buckets = std::move(m_buckets);
+			const auto old_buckets = this->m_data_size / bucket_slots;
+
+			Allocate(new_size);
+
+			for (size_t bucket = 0; bucket < old_buckets; ++bucket)
+			{
+				for (size_t slot = 0; slot < bucket_slots; ++slot)
+				{
+					if (buckets[bucket].used[slot] == Internal::slot_full)
+						InsertNew(std::move(buckets[bucket].keys[slot]), std::move(buckets[bucket].values[slot]));
+				}
+			}
 		}
+	};
 
-		template <typename KeyVal, typename... Args>
-		V& GetOrCreate(KeyVal&& key, Args&&... args) noexcept
+	/// <summary>
+	/// Linear probing hash map with K keys and V values, split into many LinearCoreMap partitions.
+	/// The top bits of a Splitmix64 mix of the hash pick the partition, the partition hashes the key as usual.
+	/// The partition count is set at construction, so that 'expected_count' keys fit into partitions of
+	/// 'partition_bytes' (default 256 KiB, about half an L2). Partitions still grow on their own, when more keys arrive.
+	/// Single key operations cost one more hash. The batch operations (EmplaceAll, GetAll, EraseAll) sort their keys
+	/// by partition first and then run one partition after the other, so each table stays in cache while its
+	/// keys are processed. That pays off once the whole map is far larger than the last level cache.
+	/// </summary>
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	class PartitionedLinearMap final
+	{
+	public:
+
+		using Partition = LinearCoreMap<K, V, policy>;
+
+		static constexpr size_t default_partition_bytes = 256 * 1024;
+
+	private:
+
+		std::vector<Partition> m_partitions;
+		Internal::HashFunction<K> m_hash = Internal::DefaultHash<K>();
+		size_t m_count = 0;
+
+		V m_default_value{}; // never modify this
+
+		// scratch space of the batch operations, kept to avoid allocations per batch
+		std::vector<uint32_t> m_batch_partition; // partition of every key, in input order
+		std::vector<size_t> m_batch_start;       // first sorted position of every partition, plus the end
+		std::vector<size_t> m_batch_cursor;
+		std::vector<K> m_batch_keys;             // keys sorted by partition
+		std::vector<V> m_batch_values;
+		std::vector<uint8_t> m_batch_found;
+
+	public:
+
+		explicit PartitionedLinearMap(const size_t expected_count = 0, const size_t partition_bytes = default_partition_bytes)
 		{
-			return GetOrCreateImpl(
-				std::forward<KeyVal>(key),
-				[&]() -> V { return V(std::forward<Args>(args)...); }
-			);
+			Init(expected_count, partition_bytes);
 		}
 
-		template <typename KeyVal, typename... Args>
-		bool TryEmplace(KeyVal&& key, Args&&... args) noexcept
+		explicit PartitionedLinearMap(const size_t expected_count, Internal::HashFunction<K> hash_func, const size_t partition_bytes = default_partition_bytes)
+			: m_hash(hash_func)
 		{
-			return TryEmplaceImpl(
-				std::forward<KeyVal>(key),
-				[&]() -> V { return V(std::forward<Args>(args)...); }
-			);
+			Init(expected_count, partition_bytes);
 		}
 
-		template <typename KeyVal, typename F> requires std::is_invocable_v<F>
-		bool TryEmplace(KeyVal&& key, F&& create_func) noexcept
+		[[nodiscard]] size_t Size() const noexcept
 		{
-			return TryEmplaceImpl(
-				std::forward<KeyVal>(key),
-				[&]() -> V { return std::invoke(std::forward<F>(create_func)); }
-			);
+			return m_count;
 		}
 
-		template <typename KeyType, typename ValType>
-		void Emplace(KeyType&& key, ValType&& value) noexcept
+		/// <summary>
+		/// Slots of all partitions together.
+		/// </summary>
+		[[nodiscard]] size_t Capacity() const noexcept
 		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
-			{
-				if (!m_used[i])
-				{
-					Insert(std::forward<KeyType>(key), std::forward<ValType>(value), i);
-					return;
-				}
+			size_t capacity = 0;
+			for (const auto& partition : m_partitions)
+				capacity += partition.Capacity();
+			return capacity;
+		}
 
-				if (m_keys[i] == key)
-				{
-					m_values[i] = std::forward<ValType>(value); // update
-					return;
-				}
-			}
+		[[nodiscard]] size_t PartitionCount() const noexcept
+		{
+			return m_partitions.size();
 		}
 
-		template <typename Tuple>
-		void Emplace(Tuple&& tuple) noexcept requires (std::tuple_size_v<std::remove_cvref_t<Tuple>> == 2)
+		[[nodiscard]] Partition& GetPartition(const size_t i) noexcept
 		{
-			std::apply([this]<typename T0, typename T1>(T0 && key, T1 && value) {
-				this->Emplace(std::forward<T0>(key), std::forward<T1>(value));
-			}, std::forward<Tuple>(tuple));
+			return m_partitions[i];
 		}
 
-		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
-			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, K>&&
-		std::convertible_to<std::ranges::range_reference_t<ValueRange>, V>
-			void EmplaceAll(KeyRange& keys, ValueRange& values) noexcept
+		/// <summary>
+		/// Index of the partition that holds 'key'.
+		/// </summary>
+		[[nodiscard]] size_t PartitionOf(const K& key) const noexcept
 		{
-			auto key_it = std::begin(keys);
-			auto key_end = std::end(keys);
-			auto val_it = std::begin(values);
+			const auto mixed = Internal::MixHash<Internal::HashMixer::Splitmix64>(Internal::KeyHash(key, m_hash), 0);
+			return (size_t)(((mixed >> 32) * m_partitions.size()) >> 32); // top 32 bits, scaled to the partition count
+		}
 
-			this->EnsureCapacity(std::distance(key_it, key_end));
+		V& operator[](const K& key) noexcept
+		{
+			return GetOrCreate(key);
+		}
 
-			while (key_it != key_end)
-			{
-				EmplaceNoGrow(std::ranges::iter_move(key_it), std::ranges::iter_move(val_it));
+		/// <summary>
+		/// True, if 'value' isn't the default value that 'Get' returns for missing keys.
+		/// </summary>
+		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		{
+			return &value != &m_default_value;
+		}
 
-				++key_it;
-				++val_it;
-			}
+		/// <summary>
+		/// Clear all data from the map, while keeping the allocated memory.
+		/// </summary>
+		void Clear() noexcept
+		{
+			for (auto& partition : m_partitions)
+				partition.Clear();
+			m_count = 0;
 		}
 
-		template <std::ranges::input_range PairRange>
-			requires requires(const std::ranges::range_value_t<PairRange>& p) {
-				{ std::get<0>(p) } -> std::convertible_to<K>;
-				{ std::get<1>(p) } -> std::convertible_to<V>;
+		[[nodiscard]] bool Contains(const K& key) noexcept
+		{
+			return m_partitions[PartitionOf(key)].Contains(key);
 		}
-		void EmplaceAll(PairRange& pairs) noexcept
+
+		[[nodiscard]] V& Get(const K& key) noexcept
 		{
-			this->EnsureCapacity(std::ranges::distance(pairs));
+			auto& partition = m_partitions[PartitionOf(key)];
+			auto& value = partition.Get(key);
+			return partition.IsValid(value) ? value : m_default_value;
+		}
 
-			for (auto&& p : pairs)
-			{
-				K&& key = std::get<0>(std::move(p));
-				V&& value = std::get<1>(std::move(p));
-				EmplaceNoGrow(std::move(key), std::move(value));
-			}
+		template <typename KeyVal, typename... Args>
+		V& GetOrCreate(KeyVal&& key, Args&&... args) noexcept
+		{
+			auto& partition = m_partitions[PartitionOf(key)];
+			const auto size = partition.Size();
+			auto& value = partition.GetOrCreate(std::forward<KeyVal>(key), std::forward<Args>(args)...);
+			m_count += partition.Size() - size;
+			return value;
+		}
+
+		template <typename KeyVal, typename... Args>
+		bool TryEmplace(KeyVal&& key, Args&&... args) noexcept
+		{
+			auto& partition = m_partitions[PartitionOf(key)];
+			const bool inserted = partition.TryEmplace(std::forward<KeyVal>(key), std::forward<Args>(args)...);
+			m_count += inserted;
+			return inserted;
+		}
+
+		template <typename KeyType, typename ValType>
+		void Emplace(KeyType&& key, ValType&& value) noexcept
+		{
+			auto& partition = m_partitions[PartitionOf(key)];
+			const auto size = partition.Size();
+			partition.Emplace(std::forward<KeyType>(key), std::forward<ValType>(value));
+			m_count += partition.Size() - size;
+		}
+
+		bool Erase(const K& key) noexcept
+		{
+			const bool erased = m_partitions[PartitionOf(key)].Erase(key);
+			m_count -= erased;
+			return erased;
 		}
 
+		/// <summary>
+		/// Emplaces 'count' keys and values, moved out of the arrays, one partition after the other.
+		/// </summary>
 		void EmplaceAll(K* keys, V* values, const size_t count) noexcept
 		{
 			if (!keys || !values || count == 0)
 				return;
 
-			this->EnsureCapacity(count);
+			m_batch_keys.resize(count);
+			m_batch_values.resize(count);
+			SortByPartition(keys, count, [&](const size_t i, const size_t pos)
+				{
+					m_batch_keys[pos] = std::move(keys[i]);
+					m_batch_values[pos] = std::move(values[i]);
+				});
 
-			for (size_t idx = 0; idx < count; ++idx)
+			for (size_t p = 0; p < m_partitions.size(); ++p)
 			{
-				K& key = keys[idx];
-				V& value = values[idx];
-				EmplaceNoGrow(std::move(key), std::move(value));
+				auto& partition = m_partitions[p];
+				for (auto pos = m_batch_start[p]; pos < m_batch_start[p + 1]; ++pos)
+					partition.Emplace(std::move(m_batch_keys[pos]), std::move(m_batch_values[pos]));
 			}
+
+			CountAll();
 		}
 
-		bool Erase(const K& key) noexcept
+		/// <summary>
+		/// Copies the value of each of the 'count' keys into 'values', one partition after the other.
+		/// Missing keys get the default value and false in 'found', if given.
+		/// </summary>
+		/// <returns>Number of keys found</returns>
+		size_t GetAll(const K* keys, V* values, const size_t count, bool* found = nullptr) noexcept
 		{
-			auto print_array = [this]<typename T>(const bool before, std::unique_ptr<T>&arr) -> void
-			{
-				std::cout << (before ? "Before: " : "After:  ");
-				for (size_t i = 0; i < this->m_data_size; i++)
-					std::cout << std::setfill('0') << std::setw(2) << arr[i] << ' ';
+			size_t hits = 0;
 
-				std::cout << "\n";
-			};
-			auto print_arrays = [this, print_array](const bool before) -> void
+			m_batch_keys.resize(count);
+			m_batch_values.resize(count);
+			m_batch_found.resize(count);
+			SortByPartition(keys, count, [&](const size_t i, const size_t pos) { m_batch_keys[pos] = keys[i]; });
+
+			for (size_t p = 0; p < m_partitions.size(); ++p)
+			{
+				auto& partition = m_partitions[p];
+				for (auto pos = m_batch_start[p]; pos < m_batch_start[p + 1]; ++pos)
 				{
-					print_array(before, m_used);
-					print_array(before, m_keys);
-					//print_array(before, m_values);
+					const auto& value = partition.Get(m_batch_keys[pos]);
+					const bool hit = partition.IsValid(value);
+					m_batch_values[pos] = hit ? value : m_default_value;
+					m_batch_found[pos] = hit;
+					hits += hit;
+				}
+			}
 
-				// [0,0,0,0,0,0,0,0,0,0]
-				// [0,0,0,4,5,6,7,8,9,0]
-				// [0,0,0,D,E,F,G,H,I,J]
+			Unsort(count, [&](const size_t i, const size_t pos)
+				{
+					values[i] = std::move(m_batch_values[pos]);
+					if (found)
+						found[i] = m_batch_found[pos];
+				});
 
-				};
+			return hits;
+		}
 
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			auto inc = 0; // offset to start index
-			for (auto i = start;; i = (i + 1) & last_index)
-			{
-				if (!m_used[i])
-					return false; // key not found
+		/// <summary>
+		/// Erases 'count' keys, one partition after the other.
+		/// </summary>
+		/// <returns>Number of keys erased</returns>
+		size_t EraseAll(const K* keys, const size_t count) noexcept
+		{
+			size_t erased = 0;
 
-				if (m_keys[i] == key)
-					break;
-				++inc;
-			}
+			m_batch_keys.resize(count);
+			SortByPartition(keys, count, [&](const size_t i, const size_t pos) { m_batch_keys[pos] = keys[i]; });
 
-			start += inc; // adjust start index
-			auto keys_above = 0; // number of keys above start index, with same start index (same bucket)
-			for (auto i = (start + 1);; i = (i + 1) & last_index)
+			for (size_t p = 0; p < m_partitions.size(); ++p)
 			{
-				const auto used = m_used[i];
-				auto [start_other, _] = this->GetSlot(m_keys[i], this->m_data_size);
-				start_other += (0xFFFFFFFFFFFFFFFF - this->m_data_size) * (1 - used); // if not used, break loop
-				if (start_other != start)
-					break;
-
-				++keys_above;
+				auto& partition = m_partitions[p];
+				for (auto pos = m_batch_start[p]; pos < m_batch_start[p + 1]; ++pos)
+					erased += partition.Erase(m_batch_keys[pos]);
 			}
 
-			if (keys_above == 0)
-			{
-				// Example with index 4 as home
-				// Case: 0 keys above
-				//
-				// [0,0,0,1,0,0,0,0,0,0]
-				// [0,0,0,4,5,6,7,8,9,0]
-				// [0,0,0,D,E,F,G,H,I,J]
-				//
-				//        v
-				// [0,0,0,0,0,0,0,0,0,0] just empty out index 4
-				// [0,0,0,0,5,6,7,8,9,0]
-				// [0,0,0,0,E,F,G,H,I,J]
+			m_count -= erased;
+			return erased;
+		}
 
-				m_used[start] = 0;
-				m_keys[start] = m_default_key;
-				m_values[start] = m_default_value;
-				--this->m_count;
-				return true;
+		/// <summary>
+		/// Calls 'f(key, value)' for every entry, partition by partition.
+		/// </summary>
+		template <typename F>
+		void ForEach(F&& f)
+		{
+			for (auto& partition : m_partitions)
+			{
+				for (auto [key, value] : partition)
+					f(key, value);
 			}
+		}
 
-			// Example with index 4 as origin
-			// Case: 2 keys above
-			//
-			// [0,0,0,1,1,1,0,0,0,0]
-			// [0,0,0,4,5,6,7,8,9,0]
-			// [0,0,0,D,E,F,G,H,I,J]
-			//
-			//        v v < 
-			// [0,0,0,1,1,1,0,0,0,0] // move index 5 and 6, one to the left 
-			// [0,0,0,5,6,6,7,8,9,0]
-			// [0,0,0,E,F,F,G,H,I,J]
+	private:
 
-			int count = 0;
+		void Init(const size_t expected_count, const size_t partition_bytes)
+		{
+			constexpr auto slot_bytes = sizeof(K) + sizeof(V) + 1;
+			const auto slots = std::bit_floor((std::max)(partition_bytes / slot_bytes, (size_t)8));
+			// keys spread binomially over the partitions, the headroom keeps the fuller ones from growing
+			const auto entries = (size_t)((double)slots * Partition::MaxLoadFactor() * 0.9);
+			const auto count = (std::max)((expected_count + entries - 1) / entries, (size_t)1);
+
+			m_partitions.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+				m_partitions.emplace_back(slots, m_hash);
+		}
 
-			//print_arrays(true);
+		void CountAll() noexcept
+		{
+			m_count = 0;
+			for (const auto& partition : m_partitions)
+				m_count += partition.Size();
+		}
 
-			for (auto i = start;; i = (i + 1) & last_index)
-			{
-				auto next = (i + 1) & last_index;
-				m_used[i] = m_used[next];
-				m_keys[i] = std::move(m_keys[next]);
-				m_values[i] = std::move(m_values[next]);
+		/// <summary>
+		/// Stable counting sort of the 'count' keys by partition. 'place(i, pos)' moves whatever belongs to key 'i'
+		/// to the sorted position 'pos', partition p takes the positions from 'm_batch_start[p]' to 'm_batch_start[p + 1]'.
+		/// Both passes read the input in order and write one sequential stream per partition, so they stay in cache
+		/// where looking up the keys in input order would miss on every one.
+		/// </summary>
+		template <typename Place>
+		void SortByPartition(const K* keys, const size_t count, Place&& place)
+		{
+			m_batch_partition.resize(count);
+			m_batch_start.assign(m_partitions.size() + 1, 0);
 
-				++count;
-				if (count >= keys_above)
-					break;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const auto partition = PartitionOf(keys[i]);
+				m_batch_partition[i] = (uint32_t)partition;
+				++m_batch_start[partition + 1];
 			}
 
-			//            v
-			// [0,0,0,1,1,0,0,0,0,0] // delete last entry
-			// [0,0,0,5,6,0,7,8,9,0]
-			// [0,0,0,E,F,0,G,H,I,J]
+			for (size_t p = 0; p < m_partitions.size(); ++p)
+				m_batch_start[p + 1] += m_batch_start[p];
 
-			const auto last_entry = (start + keys_above) & last_index;
-			m_used[last_entry] = 0;
-			m_keys[last_entry] = m_default_key;
-			m_values[last_entry] = m_default_value;
+			Unsort(count, std::forward<Place>(place));
+		}
 
-			//print_arrays(false);
+		/// <summary>
+		/// Walks the keys of the last 'SortByPartition' in input order, 'put(i, pos)' with the sorted position of key 'i'.
+		/// </summary>
+		template <typename Put>
+		void Unsort(const size_t count, Put&& put)
+		{
+			m_batch_cursor.assign(m_batch_start.begin(), m_batch_start.end() - 1);
 
-			--this->m_count;
-			return true;
+			for (size_t i = 0; i < count; ++i)
+				put(i, m_batch_cursor[m_batch_partition[i]]++);
 		}
+	};
 
+	/// <summary>
+	/// Linear probing hash map with K keys and V values that keeps older versions for snapshots (MVCC).
+	/// Every write stamps its entry with the next version. 'TakeSnapshot' pins the current version, and the
+	/// snapshot reads the map as it was then, while the map keeps taking writes. That replaces deep copies for
+	/// consistent scans. A LinearCoreMap indexes the newest version of every key, the versions themselves sit
+	/// in a side array, each one linked to the version it replaced.
+	/// Versions no snapshot can see anymore are collected a few at a time: by every write, or by 'Collect'.
+	/// Without snapshots, writes overwrite the newest version in place and no old versions pile up.
+	/// Values are read only, writes go through Emplace, TryEmplace and Erase.
+	/// Like the other maps, it isn't thread safe. Snapshots must not outlive their map.
+	/// </summary>
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	class VersionedLinearMap final
+	{
+		static constexpr uint32_t no_version = ~(uint32_t)0;
+		static constexpr uint64_t live = ~(uint64_t)0;
+
+		struct Version
+		{
+			K key;
+			V value;
+			uint64_t created;        // version of the write
+			uint64_t superseded;     // version of the write that replaced or erased it, 'live' for none
+			uint32_t older;          // the version it replaced, 'no_version' for none
+		};
+
+	public:
+
+		class Snapshot
+		{
+			friend class VersionedLinearMap;
+
+			VersionedLinearMap* m_map = nullptr;
+			uint64_t m_version = 0;
+
+			Snapshot(VersionedLinearMap* map, const uint64_t version) : m_map(map), m_version(version) {}
 
-		class Iterator {
 		public:
-			using value_type = std::pair<const K, V>;
-			using reference = std::pair<const K, V>&;
-			using iterator_category = std::forward_iterator_tag;
-			using difference_type = std::ptrdiff_t;
 
-			value_type val;
+			Snapshot() = default;
+			Snapshot(const Snapshot&) = delete;
+			Snapshot& operator=(const Snapshot&) = delete;
 
-		private:
-			K* m_keys;
-			V* m_values;
-			uint8_t* m_used;
-			size_t m_index;
-			size_t m_size;
+			Snapshot(Snapshot&& other) noexcept : m_map(std::exchange(other.m_map, nullptr)), m_version(other.m_version) {}
 
-			void advance() noexcept
+			Snapshot& operator=(Snapshot&& other) noexcept
 			{
-				while (m_index < m_size && !m_used[m_index])
-					++m_index;
+				if (this != &other)
+				{
+					Release();
+					m_map = std::exchange(other.m_map, nullptr);
+					m_version = other.m_version;
+				}
+				return *this;
 			}
 
-		public:
-			Iterator(K* keys, V* values, uint8_t* used, size_t index, size_t size)
-				: m_keys(keys), m_values(values), m_used(used), m_index(index), m_size(size) 
+			~Snapshot()
 			{
-				advance();
+				Release();
 			}
 
-			struct Proxy {
-
-				const K& first;
-				V& second;
-
-				// TODO: Help. No idea how to make "auto&" and "auto" work.
+			/// <summary>
+			/// Lets the map collect the versions only this snapshot could see. The snapshot is empty afterwards.
+			/// </summary>
+			void Release() noexcept
+			{
+				if (m_map)
+					m_map->ReleaseVersion(m_version);
+				m_map = nullptr;
+			}
 
-				operator reference() const noexcept {
-					return { first, second };
-				}
-			};
+			[[nodiscard]] uint64_t Version() const noexcept
+			{
+				return m_version;
+			}
 
-			Proxy operator*() noexcept {
+			/// <summary>
+			/// Value of 'key' at the snapshot, or the map's default value (see IsValid).
+			/// </summary>
+			[[nodiscard]] const V& Get(const K& key) const noexcept
+			{
+				const auto i = m_map->FindVisible(key, m_version);
+				return i != no_version ? m_map->m_versions[i].value : m_map->m_default_value;
+			}
 
-				return Proxy{ m_keys[m_index], m_values[m_index] };
+			[[nodiscard]] bool Contains(const K& key) const noexcept
+			{
+				return m_map->FindVisible(key, m_version) != no_version;
 			}
 
-			Iterator& operator++() noexcept {
-				++m_index;
-				advance();
-				return *this;
+			[[nodiscard]] bool IsValid(const V& value) const noexcept
+			{
+				return m_map->IsValid(value);
 			}
 
-			bool operator==(const Iterator& other) const noexcept {
-				return m_index == other.m_index;
+			/// <summary>
+			/// Calls f(key, value) for every key at the snapshot.
+			/// </summary>
+			template <typename F>
+			void ForEach(F&& f) const
+			{
+				ForEachFrom(0, Internal::npos, std::forward<F>(f));
 			}
-			bool operator!=(const Iterator& other) const noexcept {
-				return !(*this == other);
+
+			/// <summary>
+			/// Scans the next 'versions' versions from 'position' and calls f(key, value) for those the snapshot sees.
+			/// Versions don't move and the snapshot keeps its own alive, so the map may be written between two calls,
+			/// and the pieces together still visit every key at the snapshot once.
+			/// </summary>
+			/// <returns>Position to continue from, or npos after the last version</returns>
+			template <typename F>
+			size_t ForEachFrom(const size_t position, const size_t versions, F&& f) const
+			{
+				const auto& all = m_map->m_versions;
+				const auto end = position + (std::min)(versions, all.size() - (std::min)(position, all.size()));
+
+				for (auto i = position; i < end; ++i)
+				{
+					const auto& version = all[i];
+					if (version.created <= m_version && m_version < version.superseded)
+						f(version.key, version.value);
+				}
+
+				return end < all.size() ? end : Internal::npos;
 			}
 		};
 
-		Iterator begin() const noexcept {
-			return Iterator(m_keys.get(), m_values.get(), m_used.get(), 0, this->m_data_size);
+	private:
+
+		LinearCoreMap<K, uint32_t, policy> m_index; // key to its newest version
+		std::vector<Version> m_versions;
+		std::vector<uint32_t> m_free_versions;
+		std::vector<uint64_t> m_snapshots;          // versions of the live snapshots, unordered
+		std::vector<K> m_pending;                   // keys with versions to collect, each once, a queue from 'm_pending_head'
+		size_t m_pending_head = 0;
+		uint64_t m_version = 0;
+		size_t m_count = 0;
+
+		V m_default_value{}; // never modify this
+
+		static constexpr size_t collect_per_write = 2;
+
+	public:
+
+		explicit VersionedLinearMap() = default;
+
+		explicit VersionedLinearMap(const size_t capacity) : m_index(capacity)
+		{
 		}
 
-		Iterator end() const noexcept {
-			return Iterator(m_keys.get(), m_values.get(), m_used.get(), this->m_data_size, this->m_data_size);
+		explicit VersionedLinearMap(const size_t capacity, Internal::HashFunction<K> hash_func) : m_index(capacity, hash_func)
+		{
 		}
 
-	private:
+		VersionedLinearMap(const VersionedLinearMap&) = delete; // snapshots point to their map
+		VersionedLinearMap& operator=(const VersionedLinearMap&) = delete;
 
-		void Init(const size_t capacity = 64, const bool overwrite_hash = false) final
+		/// <summary>
+		/// Number of keys at the current version.
+		/// </summary>
+		[[nodiscard]] size_t Size() const noexcept
 		{
-			if constexpr (std::is_trivially_copyable_v<V>)
+			return m_count;
+		}
+
+		/// <summary>
+		/// Versions held for the current keys and the snapshots, Size() once nothing is left to collect.
+		/// </summary>
+		[[nodiscard]] size_t VersionCount() const noexcept
+		{
+			return m_versions.size() - m_free_versions.size();
+		}
+
+		[[nodiscard]] size_t SnapshotCount() const noexcept
+		{
+			return m_snapshots.size();
+		}
+
+		/// <summary>
+		/// Version of the last write.
+		/// </summary>
+		[[nodiscard]] uint64_t CurrentVersion() const noexcept
+		{
+			return m_version;
+		}
+
+		/// <summary>
+		/// Pins the current version. Reads of the snapshot don't see later writes.
+		/// </summary>
+		[[nodiscard]] Snapshot TakeSnapshot()
+		{
+			m_snapshots.push_back(m_version);
+			return Snapshot(this, m_version);
+		}
+
+		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		{
+			return &value != &m_default_value;
+		}
+
+		[[nodiscard]] bool Contains(const K& key) noexcept
+		{
+			return FindVisible(key, m_version) != no_version;
+		}
+
+		/// <summary>
+		/// Current value of 'key', or the default value (see IsValid).
+		/// </summary>
+		[[nodiscard]] const V& Get(const K& key) noexcept
+		{
+			const auto i = FindVisible(key, m_version);
+			return i != no_version ? m_versions[i].value : m_default_value;
+		}
+
+		/// <summary>
+		/// Inserts 'key' or writes a new version of it.
+		/// </summary>
+		template <typename KeyType, typename ValType>
+		void Emplace(KeyType&& key, ValType&& value)
+		{
+			Write(std::forward<KeyType>(key), std::forward<ValType>(value), true);
+		}
+
+		/// <summary>
+		/// Inserts 'key', if it isn't in the map at the current version.
+		/// </summary>
+		/// <returns>True, if inserted</returns>
+		template <typename KeyType, typename ValType>
+		bool TryEmplace(KeyType&& key, ValType&& value)
+		{
+			return Write(std::forward<KeyType>(key), std::forward<ValType>(value), false);
+		}
+
+		bool Erase(const K& key)
+		{
+			auto& newest = m_index.Get(key);
+			if (!m_index.IsValid(newest) || m_versions[newest].superseded != live)
+				return false;
+
+			const auto i = newest;
+			++m_version;
+			--m_count;
+
+			if (m_versions[i].older == no_version && !IsSeen(m_versions[i].created))
 			{
-				// make both defaults to guarantee equality
-				// if structs/classes don't set the fields, they will be random
-				std::memset(&m_default_value, 0, sizeof(V));
-				std::memset(&m_default_value_ref, 0, sizeof(V));
+				FreeVersion(i);
+				m_index.Erase(key);
 			}
 			else
 			{
-				m_default_value = V{};
-				m_default_value_ref = V{};
+				if (!IsPending(m_versions[i]))
+					m_pending.push_back(key);
+				m_versions[i].superseded = m_version;
 			}
 
-			LM_ASSERT_INTEGRITY();
-			Reserve(capacity);
+			CollectSome();
+			return true;
+		}
 
-			if (overwrite_hash)
-				return;
+		/// <summary>
+		/// Frees the versions no snapshot can see anymore, of up to 'keys' of the keys written since their last collection.
+		/// Writes do some of this on their own, call it to catch up, e.g. after releasing a long snapshot.
+		/// </summary>
+		/// <returns>Number of versions freed</returns>
+		size_t Collect(size_t keys = Internal::npos)
+		{
+			const auto oldest = m_snapshots.empty() ? m_version : *std::min_element(m_snapshots.begin(), m_snapshots.end());
+			const auto versions = VersionCount();
 
-			if constexpr (!std::is_arithmetic_v<K>)
+			keys = (std::min)(keys, m_pending.size() - m_pending_head);
+			for (; keys > 0; --keys)
 			{
-				this->SetDefaultHash(); // non integers use std hash
+				auto key = std::move(m_pending[m_pending_head++]);
+
+				if (!CollectKey(key, oldest))
+					m_pending.push_back(std::move(key)); // a snapshot still sees an older version
 			}
+
+			if (m_pending_head * 2 >= m_pending.size()) // drop the taken keys, amortized O(1) per key
+			{
+				m_pending.erase(m_pending.begin(), m_pending.begin() + m_pending_head);
+				m_pending_head = 0;
+			}
+
+			return versions - VersionCount();
 		}
 
-		void Resize(const size_t new_size) noexcept override
+		/// <summary>
+		/// Calls f(key, value) for every key at the current version.
+		/// </summary>
+		template <typename F>
+		void ForEach(F&& f) const
 		{
-			m_keys_new = std::make_unique<K[]>(new_size);
-			m_values_new = std::make_unique<V[]>(new_size);
-			m_used_new = std::make_unique<uint8_t[]>(new_size);
-
-			for (size_t i = 0; i < this->m_data_size; ++i)
+			for (const auto& version : m_versions)
 			{
-				if (!m_used[i])
-					continue;
+				if (version.superseded == live)
+					f(version.key, version.value);
+			}
+		}
 
-				EmplaceNewSize(std::move(m_keys[i]), std::move(m_values[i]), new_size);
+	private:
+
+		void CollectSome()
+		{
+			if (m_pending_head < m_pending.size())
+				Collect(collect_per_write);
+		}
+
+		/// <summary>
+		/// True, if a snapshot sees the writes up to 'version'.
+		/// </summary>
+		[[nodiscard]] bool IsSeen(const uint64_t version) const noexcept
+		{
+			for (const auto snapshot : m_snapshots)
+			{
+				if (snapshot >= version)
+					return true;
 			}
+			return false;
+		}
 
-			m_keys = std::move(m_keys_new);
-			m_values = std::move(m_values_new);
-			m_used = std::move(m_used_new);
+		/// <summary>
+		/// A key is pending while it has more than its newest version, or that one was erased.
+		/// </summary>
+		[[nodiscard]] static bool IsPending(const Version& newest) noexcept
+		{
+			return newest.older != no_version || newest.superseded != live;
+		}
 
-			this->m_data_size = new_size;
+		/// <summary>
+		/// Version of 'key' that the writes up to 'version' left, or 'no_version'.
+		/// </summary>
+		[[nodiscard]] uint32_t FindVisible(const K& key, const uint64_t version) noexcept
+		{
+			const auto& newest = m_index.Get(key);
+			if (!m_index.IsValid(newest))
+				return no_version;
+
+			auto i = newest;
+			while (i != no_version && m_versions[i].created > version)
+				i = m_versions[i].older;
+
+			return i != no_version && version < m_versions[i].superseded ? i : no_version;
 		}
 
-		template <typename KeyVal, typename ValueCreator>
-		V& GetOrCreateImpl(KeyVal&& key, ValueCreator&& make_value) noexcept
+		template <typename KeyType, typename ValType>
+		bool Write(KeyType&& key, ValType&& value, const bool overwrite)
 		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
+			auto& newest = m_index.GetOrCreate(key, no_version);
+			if (newest == no_version)
 			{
-				if (!m_used[i])
-				{
-					const bool will_resize = this->m_count + 1 >
-						(size_t)((double)this->m_data_size * this->max_load_factor);
-
-					if (unlikely(will_resize))
-					{
-						auto copy = key;
-						InsertAndGrow(std::forward<KeyVal>(key), std::invoke(std::forward<ValueCreator>(make_value)), i);
-						auto [start2, last_index2] = this->GetSlot(copy, this->m_data_size); // now larger size
-						for (auto j = start2; ; j = (j + 1) & last_index2)
-							if (m_keys[j] == copy)
-								return m_values[j];
-					}
+				newest = NewVersion(key, std::forward<ValType>(value), no_version);
+				++m_count;
+				CollectSome();
+				return true;
+			}
 
-					InsertNoGrow(std::forward<KeyVal>(key), std::invoke(std::forward<ValueCreator>(make_value)), i);
-					return m_values[i];
-				}
+			const auto i = newest;
+			auto& current = m_versions[i];
+			const bool erased = current.superseded != live;
+			if (!erased && !overwrite)
+				return false;
 
-				if (m_keys[i] == key)
-					return m_values[i];
+			if (!erased && !IsSeen(current.created))
+			{
+				current.value = std::forward<ValType>(value); // no snapshot sees it, overwrite in place
+				current.created = ++m_version;
 			}
-		}
-
-		template <typename KeyVal, typename ValueCreator>
-		bool TryEmplaceImpl(KeyVal&& key, ValueCreator&& make_value) noexcept
-		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
+			else
 			{
-				if (!m_used[i])
-				{
-					Insert(std::forward<KeyVal>(key), std::invoke(std::forward<ValueCreator>(make_value)), i);
-					return true;
-				}
+				if (!IsPending(current))
+					m_pending.push_back(key);
 
-				if (m_keys[i] == key)
-					return false;
+				if (!erased)
+					current.superseded = m_version + 1;
+				newest = NewVersion(key, std::forward<ValType>(value), i); // 'current' may dangle now
 			}
+
+			m_count += erased;
+			CollectSome();
+			return true;
 		}
 
-		template <typename A, typename B>
-		void EmplaceNoGrow(A&& key, B&& value) noexcept
+		template <typename ValType>
+		uint32_t NewVersion(const K& key, ValType&& value, const uint32_t older)
 		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
+			uint32_t i;
+			if (m_free_versions.empty())
 			{
-				if (!m_used[i])
-				{
-					InsertNoGrow(std::forward<A>(key), std::forward<B>(value), i);
-					break;
-				}
-
-				if (m_keys[i] == key)
-				{
-					m_values[i] = std::forward<B>(value);
-					break;
-				}
+				i = (uint32_t)m_versions.size();
+				m_versions.push_back(Version{ key, std::forward<ValType>(value), ++m_version, live, older });
+			}
+			else
+			{
+				i = m_free_versions.back();
+				m_free_versions.pop_back();
+				m_versions[i] = Version{ key, std::forward<ValType>(value), ++m_version, live, older };
 			}
+			return i;
 		}
 
-		template <typename A, typename B>
-		void Insert(A&& key, B&& new_value, size_t i) noexcept
+		void FreeVersion(const uint32_t i)
 		{
-			LM_ASSERT_INTEGRITY();
-			m_used[i] = 1;
-			m_keys[i] = std::forward<A>(key);
-			m_values[i] = std::forward<B>(new_value);
-			++this->m_count;
-
-			const bool grow = (double)this->m_count / (double)this->m_data_size > this->max_load_factor;
-			if (unlikely(grow))
-				this->Resize(this->m_data_size * 2);
+			m_versions[i] = Version{ K{}, V{}, 0, 0, no_version }; // 'created' 0 and 'superseded' 0, no snapshot sees it
+			m_free_versions.push_back(i);
 		}
 
-		template <typename A, typename B>
-		void InsertAndGrow(A&& key, B&& new_value, size_t i) noexcept
+		/// <summary>
+		/// Frees the versions of 'key' that no snapshot at 'oldest' or later sees. Those are the ones replaced
+		/// at or before 'oldest': anything before the last version created at or before 'oldest', and that one too
+		/// if it was superseded by then.
+		/// </summary>
+		/// <returns>True, if nothing is left to collect for 'key'</returns>
+		bool CollectKey(const K& key, const uint64_t oldest)
 		{
-			LM_ASSERT_INTEGRITY();
-			m_used[i] = 1;
-			m_keys[i] = std::forward<A>(key);
-			m_values[i] = std::forward<B>(new_value);
-			++this->m_count;
-			this->Resize(this->m_data_size * 2);
-		}
+			const auto head = m_index.Get(key);
 
-		template <typename A, typename B>
-		void InsertNoGrow(A&& key, B&& new_value, size_t i) noexcept
-		{
-			LM_ASSERT_INTEGRITY();
-			m_used[i] = 1;
-			m_keys[i] = std::forward<A>(key);
-			m_values[i] = std::forward<B>(new_value);
-			++this->m_count;
-		}
+			auto newer = no_version;
+			auto i = head;
+			while (i != no_version && m_versions[i].created > oldest)
+			{
+				newer = i;
+				i = m_versions[i].older;
+			}
 
-		template<typename A, typename B>
-		void EmplaceNewSize(A&& key, B&& value, const size_t new_size) noexcept
-		{
-			auto [start, last_index] = this->GetSlot(key, new_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
+			if (i == no_version)
+				return !IsPending(m_versions[head]); // every version is newer than the oldest snapshot
+
+			const bool drop_visible = m_versions[i].superseded <= oldest;
+			auto cut = drop_visible ? i : m_versions[i].older;
+			if (!drop_visible)
+				m_versions[i].older = no_version;
+			else if (newer != no_version)
+				m_versions[newer].older = no_version;
+
+			while (cut != no_version)
 			{
-				if (!m_used_new[i])
-				{
-					m_used_new[i] = 1;
-					m_keys_new[i] = std::forward<A>(key);
-					m_values_new[i] = std::forward<B>(value);
-					return;
-				}
+				const auto older = m_versions[cut].older;
+				FreeVersion(cut);
+				cut = older;
+			}
 
-				if (m_keys_new[i] == key)
-				{
-					m_values_new[i] = std::forward<B>(value);
-					return;
-				}
+			if (drop_visible && i == head)
+			{
+				m_index.Erase(key); // erased before every snapshot
+				return true;
 			}
+
+			return !IsPending(m_versions[head]);
 		}
-	};
 
-	}
+		void ReleaseVersion(const uint64_t version) noexcept
+		{
+			const auto it = std::find(m_snapshots.begin(), m_snapshots.end(), version);
+			*it = m_snapshots.back();
+			m_snapshots.pop_back();
+		}
+	};
 
-	template <class K>
-	class LinearSet : public Internal::LinearHash<K> // linear probing hash set
+	/// <summary>
+	/// Copy on write handle to a map or set. Copies share one map, so copying is a reference count increment,
+	/// and the first write to a shared copy clones the map (the deep copy of its copy constructor).
+	/// Reads go through 'Read' or the forwarding functions and never clone, so read only copies stay free.
+	/// Use it for maps that get copied often and written rarely, e.g. a snapshot of a configuration per request.
+	/// The sharing is whole map: a single write to a shared copy pays for the full clone.
+	/// Copies may be read from several threads, as long as none of them writes the same handle meanwhile.
+	/// </summary>
+	template <class Map>
+	class CopyOnWrite final
 	{
-	protected:
-
-		std::unique_ptr<K[]> m_keys;
-		std::unique_ptr<uint8_t[]>   m_used;
-		std::unique_ptr<K[]> m_keys_new;
-		std::unique_ptr<uint8_t[]>   m_used_new;
-
-	private:
+		// reads of a shared map must not modify it
+		static_assert(Map::map_policy.hot_keys == 0 && Map::map_policy.reordering == HitReordering::None,
+			"the hot key cache and hit reordering modify the map on reads");
 
-		K m_default_key{}; // never modify this
+		std::shared_ptr<Map> m_map;
 
 	public:
 
-		explicit LinearSet(const size_t capacity)
+		template <typename... Args> requires std::is_constructible_v<Map, Args...>
+		explicit CopyOnWrite(Args&&... args) : m_map(std::make_shared<Map>(std::forward<Args>(args)...))
 		{
-			LinearSet::Init(capacity);
 		}
 
-		explicit LinearSet(Internal::HashFunction<K> hash_func)
+		/// <summary>
+		/// True, if other copies share the map, so the next write clones it.
+		/// </summary>
+		[[nodiscard]] bool IsShared() const noexcept
 		{
-			LinearSet::Init(64, true);
-			this->m_hash = hash_func;
+			return m_map.use_count() > 1;
 		}
 
-		explicit LinearSet(const size_t capacity, Internal::HashFunction<K> hash_func)
+		/// <summary>
+		/// The shared map, for reads only. Don't write through its iterators.
+		/// </summary>
+		[[nodiscard]] const Map& Read() const noexcept
 		{
-			LinearSet::Init(capacity, true);
-			this->m_hash = hash_func;
+			return *m_map;
 		}
 
-		template <std::ranges::input_range KeyRange>
-			requires std::convertible_to<std::ranges::range_value_t<KeyRange>, K>
-		explicit LinearSet(KeyRange& keys)
+		/// <summary>
+		/// The map of this copy, cloned first if it is shared. The reference is only valid until the handle is copied.
+		/// </summary>
+		[[nodiscard]] Map& Write()
 		{
-			LinearSet::Init();
-			EmplaceAll(keys);
+			if (IsShared())
+				m_map = std::make_shared<Map>(*m_map);
+			return *m_map;
 		}
 
-		explicit LinearSet(K* keys, const size_t count)
+		[[nodiscard]] size_t Size() const noexcept
 		{
-			LinearSet::Init();
-			EmplaceAll(keys, count);
+			return m_map->Size();
 		}
 
-		explicit LinearSet()
+		template <typename KeyType>
+		[[nodiscard]] bool Contains(const KeyType& key) const noexcept
 		{
-			LinearSet::Init();
+			return const_cast<Map&>(*m_map).Contains(key); // Contains doesn't modify the map
 		}
 
-		~LinearSet() override = default;
-
-		LinearSet(const LinearSet& other) // Copy constructor (deep copy)
-			: m_keys(std::make_unique<K[]>(other.m_data_size)),
-			m_used(std::make_unique<uint8_t[]>(other.m_data_size))
+		template <typename KeyType>
+		[[nodiscard]] const auto& Get(const KeyType& key) const noexcept
 		{
-			this->m_count = other.m_count;
-			this->m_data_size = other.m_data_size;
-			this->m_hash = other.m_hash;
-
-			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
-			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
+			return std::as_const(*m_map)[key];
 		}
 
-		LinearSet& operator=(const LinearSet& other) // Copy assignment (deep copy)
+		template <typename ValType>
+		[[nodiscard]] bool IsValid(const ValType& value) const noexcept
 		{
-			if (this == &other)
-				return *this;
-
-			this->m_count = other.m_count;
-			this->m_data_size = other.m_data_size;
-			this->m_hash = other.m_hash;
-
-			m_keys = std::make_unique<K[]>(other.m_data_size);
-			m_used = std::make_unique<uint8_t[]>(other.m_data_size);
-
-			std::copy_n(other.m_keys.get(), other.m_data_size, m_keys.get());
-			std::copy_n(other.m_used.get(), other.m_data_size, m_used.get());
-
-			return *this;
+			return m_map->IsValid(value);
 		}
 
-		LinearSet(LinearSet&& other) noexcept // Move constructor
-			: m_keys(std::move(other.m_keys)),
-			m_used(std::move(other.m_used)),
-			m_keys_new(std::move(other.m_keys_new)),
-			m_used_new(std::move(other.m_used_new))
+		template <typename... Args>
+		void Emplace(Args&&... args)
 		{
-			this->m_count = other.m_count;
-			this->m_data_size = other.m_data_size;
-			this->m_hash = other.m_hash;
-
-			other.m_count = 0;
-			other.m_data_size = 0;
+			Write().Emplace(std::forward<Args>(args)...);
 		}
 
-		LinearSet& operator=(LinearSet&& other) noexcept // Move assignment
+		/// <summary>
+		/// Clones a shared map only if 'key' is missing.
+		/// </summary>
+		template <typename KeyType, typename... Args>
+		bool TryEmplace(KeyType&& key, Args&&... args)
 		{
-			if (this == &other)
-				return *this;
-
-			m_keys = std::move(other.m_keys);
-			m_used = std::move(other.m_used);
-			m_keys_new = std::move(other.m_keys_new);
-			m_used_new = std::move(other.m_used_new);
-			this->m_count = other.m_count;
-			this->m_data_size = other.m_data_size;
-			this->m_hash = other.m_hash;
-			other.m_count = 0;
-			other.m_data_size = 0;
-			return *this;
+			if (Contains(key))
+				return false;
+			return Write().TryEmplace(std::forward<KeyType>(key), std::forward<Args>(args)...);
 		}
 
 		/// <summary>
-		/// Clear all data from the map, while keeping the allocated memory.
+		/// Clones a shared map only if 'key' is there.
 		/// </summary>
-		void Clear() noexcept final
+		template <typename KeyType>
+		bool Erase(const KeyType& key)
 		{
-			std::fill_n(m_used.get(), this->m_data_size, false);
-			std::fill_n(m_keys.get(), this->m_data_size, 0);
-			this->m_count = 0;
+			if (!Contains(key))
+				return false;
+			return Write().Erase(key);
 		}
 
 		/// <summary>
-		/// Will allocate memory for at least 'capacity' elements. Existing data will be lost.
-		/// Should only be used on an empty map, or to clear this map.
-		/// Don't use this before using 'EmplaceAll'. Because, it will ensure capacity internally.
+		/// Drops this copy's share of the map, instead of cloning it to clear it.
+		/// The new map keeps the capacity and the hash function of the shared one.
 		/// </summary>
-		/// <param name="capacity">Desired map size</param>
-		void Reserve(const size_t capacity) noexcept final
+		void Clear()
 		{
-			auto new_size = this->FormatCapacity(capacity);
-			m_keys = std::make_unique<K[]>(new_size);
-			m_used = std::make_unique<uint8_t[]>(new_size);
-			this->m_count = 0;
-			this->m_data_size = new_size;
+			if (IsShared())
+				m_map = std::make_shared<Map>(m_map->Capacity(), m_map->GetHashFunction());
+			else
+				m_map->Clear();
 		}
+	};
 
-		[[nodiscard]] bool Contains(const K& key) noexcept
-		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
-			{
-				if (!m_used[i])
-					return false;
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	using SharedLinearMap = CopyOnWrite<LinearCoreMap<K, V, policy>>;
 
-				if (m_keys[i] == key)
-					return true;
-			}
-		}
+	template <class K, MapPolicy policy = MapPolicy{}>
+	using SharedLinearSet = CopyOnWrite<LinearSet<K, policy>>;
 
-		template <typename KeyType>
-		void Emplace(KeyType&& key) noexcept
+	namespace Internal
+	{
+		/// <summary>
+		/// Start of a MappedLinearMap or MappedLinearSet image. The arrays follow at offsets from the start of
+		/// the image, so every process can map the image at its own address. A set image has value_size 0 and
+		/// no value array.
+		/// </summary>
+		struct MappedImageHeader
 		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
-			{
-				if (!m_used[i])
-				{
-					Insert(std::forward<KeyType>(key), i);
-					return;
-				}
-			}
-		}
-		template <std::ranges::input_range KeyRange>
-			requires std::convertible_to<std::ranges::range_value_t<KeyRange>, K>
-		void EmplaceAll(KeyRange& keys) noexcept
+			static constexpr uint64_t image_magic = 0x31474D4950414D4Cull; // "LMAPIMG1"
+
+			uint64_t magic;
+			uint32_t key_size;
+			uint32_t value_size;
+			uint32_t probing;
+			uint32_t deletion;
+			uint64_t capacity;
+			uint64_t count;
+			uint64_t keys_offset;
+			uint64_t values_offset;
+			uint64_t used_offset;
+			uint64_t bytes;
+		};
+
+		/// <summary>
+		/// Layout, checks and key lookups of an image, shared by MappedLinearMap and MappedLinearSet.
+		/// 'V' is void for a set image.
+		/// </summary>
+		template <class K, class V, MapPolicy policy>
+		class MappedImage : public LinearHash<K, policy>
 		{
-			auto key_it = std::begin(keys);
-			auto key_end = std::end(keys);
-			this->EnsureCapacity(std::distance(key_it, key_end));
+			static_assert(std::is_trivially_copyable_v<K>, "the image is shared as raw bytes");
+			static_assert(!IsBoundedProbing(policy.probing), "the image holds a linear probing table");
 
-			while (key_it != key_end)
-			{
-				EmplaceNoGrow(std::ranges::iter_move(key_it));
-				++key_it;
-			}
-		}
+		protected:
 
-		void EmplaceAll(K* keys, const size_t count) noexcept
-		{
-			if (!keys || count == 0)
-				return;
+			using Header = MappedImageHeader;
 
-			this->EnsureCapacity(count);
+			static constexpr size_t value_size = [] { if constexpr (std::is_void_v<V>) return size_t{ 0 }; else return sizeof(V); }();
+			static constexpr size_t array_alignment = 64; // each array starts on a cache line
 
-			for (size_t idx = 0; idx < count; ++idx)
+			const K* m_keys = nullptr;
+			const uint8_t* m_used = nullptr;
+
+		public:
+
+			/// <summary>
+			/// Bytes of an image for 'count' keys.
+			/// </summary>
+			[[nodiscard]] static size_t ImageBytes(const size_t count) noexcept
 			{
-				K& key = keys[idx];
-				EmplaceNoGrow(std::move(key));
+				return Layout(CapacityFor(count)).bytes;
 			}
-		}
 
-		template <typename KeyVal>
-		bool TryEmplace(KeyVal&& key) noexcept
-		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start;; i = (i + 1) & last_index)
+			[[nodiscard]] bool Contains(const K& key) const noexcept
 			{
-				if (!m_used[i])
-				{
-					Insert(std::forward<KeyVal>(key), i);
-					return true; // inserted successfully
-				}
-
-				if (m_keys[i] == key)
-					return false; // key already present
+				return this->FindIndex(key, m_keys, m_used) != npos;
 			}
-		}
 
-		bool Erase(const K& key) noexcept
-		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			auto inc = 0; // offset to start index
-			for (auto i = start;; i = (i + 1) & last_index)
+			void Reserve(size_t) final
 			{
-				if (!m_used[i])
-					return false; // key not found
+				throw std::logic_error("a mapped image is read only");
+			}
 
-				if (m_keys[i] == key)
-					break;
-				++inc;
+			void Clear() final
+			{
+				throw std::logic_error("a mapped image is read only");
 			}
 
-			start += inc; // adjust start index
-			auto keys_above = 0; // number of keys above start index, with same start index (same bucket)
-			for (auto i = (start + 1);; i = (i + 1) & last_index)
+		protected:
+
+			/// <summary>
+			/// Writes the header of an empty image for 'count' keys into 'region', with default keys and values
+			/// and every slot empty.
+			/// </summary>
+			static Header Format(void* region, const size_t bytes, const size_t count)
 			{
-				const auto used = m_used[i];
-				auto [start_other, _] = this->GetSlot(m_keys[i], this->m_data_size);
-				start_other += (0xFFFFFFFFFFFFFFFF - this->m_data_size) * (1 - used); // if not used, break loop
-				if (start_other != start)
-					break;
+				const auto header = Layout(CapacityFor(count));
+				CheckRegion(region, bytes, header.bytes);
+
+				auto base = static_cast<std::byte*>(region);
+				std::memcpy(base, &header, sizeof(Header));
 
-				++keys_above;
+				std::uninitialized_value_construct_n(reinterpret_cast<K*>(base + header.keys_offset), header.capacity);
+				if constexpr (!std::is_void_v<V>)
+					std::uninitialized_value_construct_n(reinterpret_cast<V*>(base + header.values_offset), header.capacity);
+				std::fill_n(reinterpret_cast<uint8_t*>(base + header.used_offset), header.capacity, slot_empty);
+				return header;
 			}
 
-			if (keys_above == 0)
+			/// <summary>
+			/// Checks the image in 'region' and attaches the keys and control bytes.
+			/// Throws std::invalid_argument, if the region doesn't hold an image of this type.
+			/// </summary>
+			Header Attach(const void* region, const size_t bytes, HashFunction<K> hash_func)
 			{
-				// Example with index 4 as home
-				// Case: 0 keys above
-				//
-				// [0,0,0,1,0,0,0,0,0,0]
-				// [0,0,0,4,5,6,7,8,9,0]
-				// [0,0,0,D,E,F,G,H,I,J]
-				//
-				//        v
-				// [0,0,0,0,0,0,0,0,0,0] just empty out index 4
-				// [0,0,0,0,5,6,7,8,9,0]
-				// [0,0,0,0,E,F,G,H,I,J]
+				if (!region || bytes < sizeof(Header))
+					throw std::invalid_argument("region too small for an image");
 
-				m_used[start] = 0;
-				m_keys[start] = m_default_key;
+				Header header;
+				std::memcpy(&header, region, sizeof(Header));
 
-				--this->m_count;
-				return true;
-			}
+				if (header.magic != Header::image_magic)
+					throw std::invalid_argument("region doesn't start with an image");
+				if (header.key_size != sizeof(K) || header.value_size != value_size
+					|| header.probing != (uint32_t)policy.probing || header.deletion != (uint32_t)policy.deletion)
+					throw std::invalid_argument("image of another key, value or policy");
 
-			// Example with index 4 as origin
-			// Case: 2 keys above
-			//
-			// [0,0,0,1,1,1,0,0,0,0]
-			// [0,0,0,4,5,6,7,8,9,0]
-			// [0,0,0,D,E,F,G,H,I,J]
-			//
-			//        v v < 
-			// [0,0,0,1,1,1,0,0,0,0] // move index 5 and 6, one to the left 
-			// [0,0,0,5,6,6,7,8,9,0]
-			// [0,0,0,E,F,F,G,H,I,J]
+				if (header.capacity > bytes)
+					throw std::invalid_argument("region too small for the image");
 
-			int count = 0;
+				const auto expected = Layout(header.capacity);
+				if (!std::has_single_bit(header.capacity) || header.keys_offset != expected.keys_offset
+					|| header.values_offset != expected.values_offset || header.used_offset != expected.used_offset)
+					throw std::invalid_argument("corrupt image");
 
-			for (auto i = start;; i = (i + 1) & last_index)
-			{
-				auto next = (i + 1) & last_index;
-				m_used[i] = m_used[next];
-				m_keys[i] = std::move(m_keys[next]);
+				CheckRegion(region, bytes, expected.bytes);
 
-				++count;
-				if (count >= keys_above)
-					break;
-			}
+				if constexpr (!std::is_arithmetic_v<K>)
+				{
+					if (!hash_func)
+						throw std::invalid_argument("keys without std::hash need a hash function");
+				}
 
-			//            v
-			// [0,0,0,1,1,0,0,0,0,0] // delete last entry
-			// [0,0,0,5,6,0,7,8,9,0]
-			// [0,0,0,E,F,0,G,H,I,J]
+				const auto base = static_cast<const std::byte*>(region);
+				m_keys = reinterpret_cast<const K*>(base + header.keys_offset);
+				m_used = reinterpret_cast<const uint8_t*>(base + header.used_offset);
 
-			const auto last_entry = (start + keys_above) & last_index;
-			m_used[last_entry] = 0;
-			m_keys[last_entry] = m_default_key;
+				this->m_data_size = header.capacity;
+				this->m_count = header.count;
+				this->m_hash = hash_func;
+				return header;
+			}
 
-			--this->m_count;
-			return true;
-		}
+		private:
 
-		class Iterator {
-		public:
-			Iterator(K* keys, uint8_t* used, const size_t index, const size_t size) noexcept
-				: m_keys(keys), m_used(used), m_index(index), m_size(size)
+			[[nodiscard]] static size_t CapacityFor(const size_t count) noexcept
 			{
-				advance();
+				return MappedImage::FormatCapacity((size_t)((double)count / MappedImage::max_load_factor) + 1);
 			}
 
-			Iterator& operator++() noexcept {
-				++m_index;
-				advance();
-				return *this;
+			[[nodiscard]] static size_t AlignArray(const size_t offset) noexcept
+			{
+				return (offset + array_alignment - 1) & ~(array_alignment - 1);
 			}
 
-			bool operator!=(const Iterator& other) const noexcept {
-				return m_index != other.m_index;
+			[[nodiscard]] static Header Layout(const size_t capacity) noexcept
+			{
+				Header header{};
+				header.magic = Header::image_magic;
+				header.key_size = (uint32_t)sizeof(K);
+				header.value_size = (uint32_t)value_size;
+				header.probing = (uint32_t)policy.probing;
+				header.deletion = (uint32_t)policy.deletion;
+				header.capacity = capacity;
+				header.keys_offset = AlignArray(sizeof(Header));
+				header.values_offset = AlignArray(header.keys_offset + capacity * sizeof(K));
+				header.used_offset = AlignArray(header.values_offset + capacity * value_size);
+				header.bytes = header.used_offset + capacity;
+				return header;
 			}
 
-			const K& operator*() const noexcept {
-				return m_keys[m_index];
-			}
+			static void CheckRegion(const void* region, const size_t bytes, const size_t required)
+			{
+				static_assert(alignof(K) <= array_alignment);
 
-		private:
-			K* m_keys;
-			uint8_t* m_used;
-			size_t m_index;
-			size_t m_size;
+				if (!region || bytes < required)
+					throw std::invalid_argument("region too small for the image");
+				if (reinterpret_cast<uintptr_t>(region) % array_alignment != 0)
+					throw std::invalid_argument("image region must be aligned to 64 bytes");
+			}
 
-			void advance() {
-				while (m_index < m_size && !m_used[m_index])
-				{
-					++m_index;
-				}
+			void Resize(size_t) final
+			{
+				throw std::logic_error("a mapped image is read only");
 			}
 		};
+	}
 
-		Iterator begin() {
-			return Iterator(m_keys.get(), m_used.get(), 0, this->m_data_size);
-		}
+	/// <summary>
+	/// Read only linear probing hash map with K keys and V values, in a memory region the caller provides,
+	/// e.g. a shared memory mapping (shm_open, memfd_create, CreateFileMapping) or a memory mapped file.
+	/// 'Build' writes an image of a map into the region: a header and the three arrays, located by offsets.
+	/// Any process that maps the region can attach to it with the constructor, at any address, and look up
+	/// keys without a copy of its own. Lookups run the same probe as a LinearCoreMap with the same policy.
+	/// Keys and values must be trivially copyable, pointers wouldn't mean anything in another process.
+	/// Keys without a bit hash (not integers or floats) need the same hash function in every process.
+	/// </summary>
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	class MappedLinearMap final : public Internal::MappedImage<K, V, policy>
+	{
+		static_assert(std::is_trivially_copyable_v<V>, "the image is shared as raw bytes");
+		static_assert(alignof(V) <= MappedLinearMap::array_alignment);
 
-		Iterator end() {
-			return Iterator(m_keys.get(), m_used.get(), this->m_data_size, this->m_data_size);
-		}
+		const V* m_values = nullptr;
 
-	private:
+		V m_default_value{}; // never modify this
 
-		void Init(const size_t capacity = 64, const bool overwrite_hash = false) final
+	public:
+
+		/// <summary>
+		/// Writes an image of every key and value of 'map' (any map with Size and a key, value iteration) into 'region',
+		/// which must hold ImageBytes(map.Size()) bytes, aligned to 64 bytes. Tombstones of the map aren't copied.
+		/// </summary>
+		/// <returns>A map attached to the new image</returns>
+		template <class Map>
+		static MappedLinearMap Build(const Map& map, void* region, const size_t bytes, Internal::HashFunction<K> hash_func = Internal::DefaultHash<K>())
 		{
-			Reserve(capacity);
+			const auto header = MappedLinearMap::Format(region, bytes, map.Size());
 
-			if (overwrite_hash)
-				return;
+			auto base = static_cast<std::byte*>(region);
+			auto keys = reinterpret_cast<K*>(base + header.keys_offset);
+			auto values = reinterpret_cast<V*>(base + header.values_offset);
+			auto used = reinterpret_cast<uint8_t*>(base + header.used_offset);
 
-			if constexpr (!std::is_arithmetic_v<K>)
+			MappedLinearMap image(region, bytes, hash_func);
+			for (const auto& [key, value] : map)
 			{
-				this->SetDefaultHash(); // non integers use std hash
+				const auto slot = image.FindInsertSlot(key, keys, used);
+				keys[slot.index] = key;
+				values[slot.index] = value;
+				used[slot.index] = Internal::slot_full;
+				image.m_count += !slot.found;
 			}
+
+			reinterpret_cast<typename MappedLinearMap::Header*>(base)->count = image.m_count;
+			return image;
 		}
 
-		void Resize(const size_t new_size) noexcept override
+		/// <summary>
+		/// Attaches to an image that 'Build' wrote into 'region', in this or any other process.
+		/// Throws std::invalid_argument, if the region doesn't hold an image of this map type.
+		/// </summary>
+		explicit MappedLinearMap(const void* region, const size_t bytes, Internal::HashFunction<K> hash_func = Internal::DefaultHash<K>())
 		{
-			m_keys_new = std::make_unique<K[]>(new_size);
-			m_used_new = std::make_unique<uint8_t[]>(new_size);
-
-			for (size_t i = 0; i < this->m_data_size; ++i)
-			{
-				if (!m_used[i])
-					continue;
+			const auto header = this->Attach(region, bytes, hash_func);
+			m_values = reinterpret_cast<const V*>(static_cast<const std::byte*>(region) + header.values_offset);
+		}
 
-				EmplaceNewSize(std::move(m_keys[i]), new_size);
-			}
+		[[nodiscard]] const V& Get(const K& key) const noexcept
+		{
+			const auto i = this->FindIndex(key, this->m_keys, this->m_used);
+			return i != Internal::npos ? m_values[i] : m_default_value;
+		}
 
-			m_keys = std::move(m_keys_new);
-			m_used = std::move(m_used_new);
+		const V& operator[](const K& key) const noexcept
+		{
+			return Get(key);
+		}
 
-			this->m_data_size = new_size;
+		/// <summary>
+		/// True, if 'value' isn't the default value that 'Get' returns for missing keys.
+		/// </summary>
+		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		{
+			return &value != &m_default_value;
 		}
 
-		template <typename A>
-		void EmplaceNoGrow(A&& key) noexcept
+		/// <summary>
+		/// Calls f(key, value) for every key, in slot order.
+		/// </summary>
+		template <typename F>
+		void ForEach(F&& f) const
 		{
-			auto [start, last_index] = this->GetSlot(key, this->m_data_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
+			for (size_t i = 0; i < this->m_data_size; ++i)
 			{
-				if (!m_used[i])
-				{
-					InsertNoGrow(std::forward<A>(key), i);
-					break;
-				}
+				if (this->m_used[i] == Internal::slot_full)
+					f(this->m_keys[i], m_values[i]);
 			}
 		}
+	};
 
-		template <typename A>
-		void Insert(A&& key, size_t i) noexcept
+	/// <summary>
+	/// Read only linear probing hash set with K keys, in a memory region the caller provides, like MappedLinearMap.
+	/// The image holds the keys and control bytes only.
+	/// </summary>
+	template <class K, MapPolicy policy = MapPolicy{}>
+	class MappedLinearSet final : public Internal::MappedImage<K, void, policy>
+	{
+	public:
+
+		/// <summary>
+		/// Writes an image of every key of 'set' (any set with Size and ForEach(f(key))) into 'region',
+		/// which must hold ImageBytes(set.Size()) bytes, aligned to 64 bytes.
+		/// </summary>
+		/// <returns>A set attached to the new image</returns>
+		template <class Set>
+		static MappedLinearSet Build(const Set& set, void* region, const size_t bytes, Internal::HashFunction<K> hash_func = Internal::DefaultHash<K>())
 		{
-			m_used[i] = 1;
-			m_keys[i] = std::forward<A>(key);
-			++this->m_count;
+			const auto header = MappedLinearSet::Format(region, bytes, set.Size());
+
+			auto base = static_cast<std::byte*>(region);
+			auto keys = reinterpret_cast<K*>(base + header.keys_offset);
+			auto used = reinterpret_cast<uint8_t*>(base + header.used_offset);
 
-			const bool grow = (double)this->m_count / (double)this->m_data_size > this->max_load_factor;
-			if (unlikely(grow))
-				this->Resize(this->m_data_size * 2);
+			MappedLinearSet image(region, bytes, hash_func);
+			set.ForEach([&](const K& key)
+				{
+					const auto slot = image.FindInsertSlot(key, keys, used);
+					keys[slot.index] = key;
+					used[slot.index] = Internal::slot_full;
+					image.m_count += !slot.found;
+				});
+
+			reinterpret_cast<typename MappedLinearSet::Header*>(base)->count = image.m_count;
+			return image;
 		}
 
-		template <typename A>
-		void InsertNoGrow(A&& key, size_t i) noexcept
-		{ 
-			m_used[i] = 1;
-			m_keys[i] = std::forward<A>(key);
-			++this->m_count;
+		/// <summary>
+		/// Attaches to an image that 'Build' wrote into 'region', in this or any other process.
+		/// Throws std::invalid_argument, if the region doesn't hold an image of this set type.
+		/// </summary>
+		explicit MappedLinearSet(const void* region, const size_t bytes, Internal::HashFunction<K> hash_func = Internal::DefaultHash<K>())
+		{
+			this->Attach(region, bytes, hash_func);
 		}
 
-		template <typename A>
-		void EmplaceNewSize(A&& key, const size_t new_size) noexcept
+		/// <summary>
+		/// Calls f(key) for every key, in slot order.
+		/// </summary>
+		template <typename F>
+		void ForEach(F&& f) const
 		{
-			auto [start, last_index] = this->GetSlot(key, new_size);
-			for (auto i = start; ; i = (i + 1) & last_index)
+			for (size_t i = 0; i < this->m_data_size; ++i)
 			{
-				if (!m_used_new[i])
-				{
-					m_used_new[i] = 1;
-					m_keys_new[i] = std::forward<A>(key);
-					return;
-				}
+				if (this->m_used[i] == Internal::slot_full)
+					f(this->m_keys[i]);
 			}
 		}
 	};
 
-	template <class K, class V>
-	class LinearCoreMap final : public Internal::LinearCoreMapImpl<K, V> // linear probing hash map
+	/// <summary>
+	/// Linear probing hash map with K keys and dictionary encoded V values, for large values that repeat.
+	/// Every distinct value is stored once, the table holds a 4 byte id per key. Values are reference counted,
+	/// the last key that drops a value frees it. Get reads the value through its id, nothing to decode.
+	/// The dictionary finds existing values by their hash, so a value hash is needed (std::hash by default).
+	/// Values are read only, writes go through Emplace, TryEmplace and Erase.
+	/// </summary>
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	class DictionaryLinearMap final
 	{
+		static constexpr uint32_t no_value = ~(uint32_t)0;
+
+		LinearCoreMap<K, uint32_t, policy> m_index; // key to value id
+		LinearCoreMap<size_t, uint32_t> m_ids;      // value hash to the first id with that hash
+		std::vector<V> m_values;                    // id to value
+		std::vector<uint32_t> m_refs;               // keys per id, 0 for free ids
+		std::vector<uint32_t> m_next;               // next id with the same hash
+		std::vector<uint32_t> m_free_ids;
+		Internal::HashFunction<V> m_value_hash = Internal::DefaultHash<V>();
+
+		V m_default_value{}; // never modify this
+
 	public:
-		explicit LinearCoreMap() : Internal::LinearCoreMapImpl<K,V>()
+
+		explicit DictionaryLinearMap() = default;
+
+		explicit DictionaryLinearMap(const size_t capacity) : m_index(capacity)
+		{
+		}
+
+		explicit DictionaryLinearMap(const size_t capacity, Internal::HashFunction<K> key_hash, Internal::HashFunction<V> value_hash)
+			: m_index(capacity, key_hash), m_value_hash(value_hash)
 		{
+		}
 
+		[[nodiscard]] size_t Size() const noexcept
+		{
+			return m_index.Size();
 		}
 
-		explicit LinearCoreMap(size_t capacity) : Internal::LinearCoreMapImpl<K, V>(capacity)
+		[[nodiscard]] size_t Capacity() const noexcept
 		{
-			
+			return m_index.Capacity();
 		}
 
-		explicit LinearCoreMap(Internal::HashFunction<K> hash_func) : Internal::LinearCoreMapImpl<K, V>(hash_func)
+		/// <summary>
+		/// Number of distinct values stored.
+		/// </summary>
+		[[nodiscard]] size_t DistinctValues() const noexcept
 		{
+			return m_values.size() - m_free_ids.size();
+		}
 
+		[[nodiscard]] bool Contains(const K& key) noexcept
+		{
+			return m_index.Contains(key);
 		}
 
-		explicit LinearCoreMap(size_t capacity, Internal::HashFunction<K> hash_func) : Internal::LinearCoreMapImpl<K, V>(capacity, hash_func)
+		/// <summary>
+		/// Value of 'key', or the default value (see IsValid).
+		/// </summary>
+		[[nodiscard]] const V& Get(const K& key) noexcept
 		{
-			
+			const auto& id = m_index.Get(key);
+			return m_index.IsValid(id) ? m_values[id] : m_default_value;
 		}
 
-		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
-			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, K>&&
-		std::convertible_to<std::ranges::range_reference_t<ValueRange>, V>
-			explicit LinearCoreMap(KeyRange& keys, ValueRange& values) : Internal::LinearCoreMapImpl<K, V>(keys, values)
+		[[nodiscard]] bool IsValid(const V& value) const noexcept
+		{
+			return &value != &m_default_value;
+		}
+
+		/// <summary>
+		/// Inserts 'key' or replaces its value.
+		/// </summary>
+		template <typename KeyType>
+		void Emplace(KeyType&& key, const V& value)
 		{
+			const auto id = Intern(value);
+			auto& slot = m_index.GetOrCreate(std::forward<KeyType>(key), no_value);
+			const auto old = slot;
+			slot = id;
 
+			if (old != no_value)
+				Release(old);
 		}
 
-		template <std::ranges::input_range PairRange>
-			requires requires(const std::ranges::range_value_t<PairRange>& p) {
-				{ std::get<0>(p) } -> std::convertible_to<K>;
-				{ std::get<1>(p) } -> std::convertible_to<V>;
+		/// <summary>
+		/// Inserts 'key', if it isn't in the map.
+		/// </summary>
+		/// <returns>True, if inserted</returns>
+		template <typename KeyType>
+		bool TryEmplace(KeyType&& key, const V& value)
+		{
+			if (m_index.Contains(key))
+				return false;
+
+			Emplace(std::forward<KeyType>(key), value);
+			return true;
+		}
+
+		bool Erase(const K& key)
+		{
+			const auto& id = m_index.Get(key);
+			if (!m_index.IsValid(id))
+				return false;
+
+			Release(id);
+			m_index.Erase(key);
+			return true;
+		}
+
+		void Clear()
+		{
+			m_index.Clear();
+			m_ids.Clear();
+			m_values.clear();
+			m_refs.clear();
+			m_next.clear();
+			m_free_ids.clear();
+		}
+
+		/// <summary>
+		/// Calls f(key, value) for every key.
+		/// </summary>
+		template <typename F>
+		void ForEach(F&& f) const
+		{
+			for (const auto& [key, id] : m_index)
+				f(key, std::as_const(m_values[id]));
+		}
+
+	private:
+
+		[[nodiscard]] size_t ValueHash(const V& value) const noexcept
+		{
+			return Internal::KeyHash(value, m_value_hash);
+		}
+
+		/// <summary>
+		/// Id of 'value', stored first if it is new, with one more reference.
+		/// </summary>
+		uint32_t Intern(const V& value)
+		{
+			const auto hash = ValueHash(value);
+			auto& first = m_ids.GetOrCreate(hash, no_value);
+
+			auto id = first;
+			while (id != no_value && !(m_values[id] == value))
+				id = m_next[id];
+
+			if (id == no_value)
+			{
+				id = NewId(value);
+				m_next[id] = first;
+				first = id; // m_ids didn't change since GetOrCreate
+			}
+
+			++m_refs[id];
+			return id;
 		}
-		explicit LinearCoreMap(PairRange& pairs) : Internal::LinearCoreMapImpl<K, V>(pairs)
+
+		uint32_t NewId(const V& value)
 		{
+			if (m_free_ids.empty())
+			{
+				m_values.push_back(value);
+				m_refs.push_back(0);
+				m_next.push_back(no_value);
+				return (uint32_t)(m_values.size() - 1);
+			}
 
+			const auto id = m_free_ids.back();
+			m_free_ids.pop_back();
+			m_values[id] = value;
+			return id;
 		}
 
-		explicit LinearCoreMap(K* keys, V* values, const size_t count) : Internal::LinearCoreMapImpl<K, V>(keys, values, count)
+		/// <summary>
+		/// Drops one reference to 'id', and the value with the last one.
+		/// </summary>
+		void Release(const uint32_t id)
 		{
+			if (--m_refs[id] != 0)
+				return;
+
+			const auto hash = ValueHash(m_values[id]);
+			auto& first = m_ids.Get(hash);
+
+			if (first == id)
+			{
+				if (m_next[id] == no_value)
+					m_ids.Erase(hash);
+				else
+					first = m_next[id];
+			}
+			else
+			{
+				auto previous = first;
+				while (m_next[previous] != id)
+					previous = m_next[previous];
+				m_next[previous] = m_next[id];
+			}
 
+			m_values[id] = V{}; // frees what the value owns
+			m_next[id] = no_value;
+			m_free_ids.push_back(id);
 		}
 	};
 
-	template <class T>
-	class LinearMap final : public Internal::LinearCoreMapImpl<size_t, T>
+	/// <summary>
+	/// Immutable hash set of integer keys, quotiented and bit packed, for large static sets.
+	/// The keys are taken relative to the smallest one, and mixed by a bijection on the bits their range needs
+	/// (the universe), so their mixed values are unique.
+	/// The top bits of a mixed key pick a bucket of about 8 keys, and only the remaining bits (the remainder)
+	/// are stored, sorted per bucket. A lookup reads the bucket offsets and one or two cache lines of remainders.
+	/// A key costs the universe bits minus log2(count / 8), plus 4 bits for the offsets: about 6 bytes for 4M
+	/// 64 bit keys, 2 bytes for 4M keys below 2^32. A LinearSet<uint64_t> needs 13 bytes and more.
+	/// Lookups compare the whole bucket and run several times slower than in a LinearSet.
+	/// </summary>
+	template <class K = uint64_t>
+	class CompactLinearSet final
 	{
+		static_assert(std::is_integral_v<K>, "CompactLinearSet holds integer keys");
+
+		using Bits = std::make_unsigned_t<K>;
+
+		static constexpr size_t keys_per_bucket = 8;
+
+		std::vector<uint32_t> m_offsets;   // first remainder of every bucket, plus the end
+		std::vector<uint64_t> m_remainders; // bit packed, 'm_remainder_bits' each, sorted per bucket
+		size_t m_count = 0;
+		uint64_t m_base = 0; // smallest key
+		uint32_t m_universe_bits = 0;
+		uint32_t m_remainder_bits = 0;
+
 	public:
 
-		explicit LinearMap() : Internal::LinearCoreMapImpl<size_t, T>()
+		explicit CompactLinearSet() = default;
+
+		template <std::ranges::input_range KeyRange>
+			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, K>
+		explicit CompactLinearSet(KeyRange& keys)
 		{
+			std::vector<uint64_t> mixed;
+			for (const K key : keys)
+				mixed.push_back((uint64_t)(Bits)key);
+			Build(mixed);
+		}
 
+		template <MapPolicy policy>
+		explicit CompactLinearSet(LinearSet<K, policy>& set)
+		{
+			std::vector<uint64_t> mixed;
+			mixed.reserve(set.Size());
+			for (const K key : set)
+				mixed.push_back((uint64_t)(Bits)key);
+			Build(mixed);
 		}
 
-		explicit LinearMap(size_t capacity) : Internal::LinearCoreMapImpl<size_t, T>(capacity)
+		explicit CompactLinearSet(const K* keys, const size_t count)
 		{
+			std::vector<uint64_t> mixed(count);
+			for (size_t i = 0; i < count; ++i)
+				mixed[i] = (uint64_t)(Bits)keys[i];
+			Build(mixed);
+		}
 
+		[[nodiscard]] size_t Size() const noexcept
+		{
+			return m_count;
 		}
 
-		template <std::ranges::input_range KeyRange, std::ranges::input_range ValueRange>
-			requires std::convertible_to<std::ranges::range_reference_t<KeyRange>, size_t>&&
-		std::convertible_to<std::ranges::range_reference_t<ValueRange>, T>
-			explicit LinearMap(KeyRange& keys, ValueRange& values) : Internal::LinearCoreMapImpl<size_t, T>(keys, values)
+		/// <summary>
+		/// Bytes of the offsets and remainders.
+		/// </summary>
+		[[nodiscard]] size_t MemoryBytes() const noexcept
 		{
+			return m_offsets.size() * sizeof(uint32_t) + m_remainders.size() * sizeof(uint64_t);
+		}
 
+		[[nodiscard]] bool Contains(const K& key) const noexcept
+		{
+			const auto bits = (uint64_t)(Bits)key - m_base; // keys below the base wrap around to large values
+			if (m_count == 0 || (m_universe_bits < 64 && bits >> m_universe_bits != 0))
+				return false; // outside the universe
+
+			const auto mixed = Mix(bits, m_universe_bits);
+			const auto bucket = m_remainder_bits < 64 ? mixed >> m_remainder_bits : 0;
+			const auto remainder = mixed & RemainderMask();
+
+			// count the smaller remainders without a branch per entry, the first one not smaller is the only candidate
+			const size_t first = m_offsets[bucket];
+			const size_t last = m_offsets[bucket + 1];
+			size_t smaller = 0;
+			for (auto i = first; i < last; ++i)
+				smaller += Remainder(i) < remainder;
+
+			return first + smaller < last && Remainder(first + smaller) == remainder;
 		}
 
-		template <std::ranges::input_range PairRange>
-			requires requires(const std::ranges::range_value_t<PairRange>& p) {
-				{ std::get<0>(p) } -> std::convertible_to<size_t>;
-				{ std::get<1>(p) } -> std::convertible_to<T>;
+	private:
+
+		[[nodiscard]] static uint64_t UniverseMask(const uint32_t universe_bits) noexcept
+		{
+			return universe_bits < 64 ? (1ull << universe_bits) - 1 : ~0ull;
+		}
+
+		[[nodiscard]] uint64_t RemainderMask() const noexcept
+		{
+			return m_remainder_bits < 64 ? (1ull << m_remainder_bits) - 1 : ~0ull;
+		}
+
+		/// <summary>
+		/// Bijection on the numbers below 2^universe_bits. Multiplying by an odd number and xoring with a right
+		/// shift can both be undone, modulo a power of two.
+		/// </summary>
+		[[nodiscard]] static uint64_t Mix(uint64_t x, const uint32_t universe_bits) noexcept
+		{
+			const auto mask = UniverseMask(universe_bits);
+			const auto shift = (universe_bits + 1) / 2;
+
+			x = (x * 0xBF58476D1CE4E5B9ull) & mask;
+			x ^= x >> shift;
+			x = (x * 0x94D049BB133111EBull) & mask;
+			x ^= x >> shift;
+			return x;
 		}
-		explicit LinearMap(PairRange& pairs) : Internal::LinearCoreMapImpl<size_t, T>(pairs)
+
+		[[nodiscard]] uint64_t Remainder(const size_t i) const noexcept
 		{
+			const auto bit = i * m_remainder_bits;
+			if (m_remainder_bits <= 56)
+			{
+				uint64_t bytes; // one unaligned load holds the whole remainder, the spare word keeps it in bounds
+				std::memcpy(&bytes, reinterpret_cast<const std::byte*>(m_remainders.data()) + bit / 8, sizeof(bytes));
+				return (bytes >> (bit % 8)) & RemainderMask();
+			}
+
+			const auto word = bit / 64;
+			const auto offset = bit % 64;
+
+			auto value = m_remainders[word] >> offset;
+			if (offset + m_remainder_bits > 64)
+				value |= m_remainders[word + 1] << (64 - offset);
 
+			return value & RemainderMask();
 		}
 
-		explicit LinearMap(size_t* keys, T* values, const size_t count) : Internal::LinearCoreMapImpl<size_t, T>(keys, values, count)
+		void Build(std::vector<uint64_t>& keys)
 		{
+			std::sort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
 
+			if (keys.size() > UINT32_MAX)
+				throw std::length_error("CompactLinearSet holds at most 2^32 - 1 keys");
+
+			m_count = keys.size();
+			if (m_count == 0)
+				return;
+
+			m_base = keys.front();
+			m_universe_bits = (std::max)((uint32_t)std::bit_width(keys.back() - m_base), 1u);
+			const auto bucket_bits = (std::min)((uint32_t)std::bit_width(m_count / keys_per_bucket), m_universe_bits);
+			m_remainder_bits = m_universe_bits - bucket_bits;
+
+			for (auto& key : keys)
+				key = Mix(key - m_base, m_universe_bits);
+			std::sort(keys.begin(), keys.end()); // by bucket, then remainder
+
+			const auto buckets = (size_t)1 << bucket_bits;
+			m_offsets.assign(buckets + 1, 0);
+			m_remainders.assign((m_count * m_remainder_bits + 63) / 64 + 1, 0); // one spare word for the reads across two
+
+			for (size_t i = 0; i < m_count; ++i)
+			{
+				const auto bucket = m_remainder_bits < 64 ? keys[i] >> m_remainder_bits : 0;
+				++m_offsets[bucket + 1];
+
+				if (m_remainder_bits == 0)
+					continue;
+
+				const auto remainder = keys[i] & RemainderMask();
+				const auto bit = i * m_remainder_bits;
+				m_remainders[bit / 64] |= remainder << (bit % 64);
+				if (bit % 64 + m_remainder_bits > 64)
+					m_remainders[bit / 64 + 1] |= remainder >> (64 - bit % 64);
+			}
+
+			for (size_t b = 0; b < buckets; ++b)
+				m_offsets[b + 1] += m_offsets[b];
 		}
 	};
 }
+
+#if defined(LMAP_INSTANTIATE_TEMPLATES)
+#define LMAP_TEMPLATE_INSTANCE template
+#elif defined(LMAP_EXTERN_TEMPLATES)
+#define LMAP_TEMPLATE_INSTANCE extern template
+#endif
+
+#if defined(LMAP_TEMPLATE_INSTANCE)
+LMAP_TEMPLATE_INSTANCE class LinearProbing::Internal::LinearHash<size_t>;
+LMAP_TEMPLATE_INSTANCE class LinearProbing::Internal::LinearCoreMapImpl<size_t, int>;
+LMAP_TEMPLATE_INSTANCE class LinearProbing::LinearMap<int>;
+LMAP_TEMPLATE_INSTANCE class LinearProbing::LinearSet<uint64_t>;
+#undef LMAP_TEMPLATE_INSTANCE
+#endif
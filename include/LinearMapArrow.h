@@ -0,0 +1,202 @@
+/*
+----------------------------------------------------------------------------------------
+FastLinearMap - Arrow export
+----------------------------------------------------------------------------------------
+Author: [aizu03]
+License: MIT (free to use, modify, and distribute)
+
+Exports a LinearCoreMap or LinearMap with arithmetic keys and values through the Arrow C data interface,
+as a struct array of the columns "key" and "value", the layout of a record batch. Any Arrow implementation
+can import it (pyarrow, arrow-rs, DuckDB, ...) without this library linking against Arrow.
+
+ExportArrow - Compacts the entries into dense columns with 'ExportTo', and fills an ArrowArray and an ArrowSchema
+              that own them. The release callbacks free the columns, and an exported child stays valid when the
+              consumer moves it out of the parent.
+
+The structs are the ones of the specification, so they are the same types as in arrow/c/abi.h.
+
+*/
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+#include "LinearMap.h"
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C"
+{
+	struct ArrowSchema
+	{
+		const char* format;
+		const char* name;
+		const char* metadata;
+		int64_t flags;
+		int64_t n_children;
+		struct ArrowSchema** children;
+		struct ArrowSchema* dictionary;
+		void (*release)(struct ArrowSchema*);
+		void* private_data;
+	};
+
+	struct ArrowArray
+	{
+		int64_t length;
+		int64_t null_count;
+		int64_t offset;
+		int64_t n_buffers;
+		int64_t n_children;
+		const void** buffers;
+		struct ArrowArray** children;
+		struct ArrowArray* dictionary;
+		void (*release)(struct ArrowArray*);
+		void* private_data;
+	};
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace LinearProbing
+{
+	namespace Internal
+	{
+		/// <summary>
+		/// Arrow format string of a primitive column of 'T'.
+		/// </summary>
+		template <class T>
+		constexpr const char* ArrowFormat() noexcept
+		{
+			static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "only arithmetic keys and values, bool is bit packed in Arrow");
+
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				static_assert(sizeof(T) == 4 || sizeof(T) == 8, "no Arrow format for this floating point type");
+				return sizeof(T) == 4 ? "f" : "g";
+			}
+			else
+			{
+				static_assert(sizeof(T) <= 8, "no Arrow format for this integer type");
+				constexpr bool is_signed = std::is_signed_v<T>;
+
+				if constexpr (sizeof(T) == 1)
+					return is_signed ? "c" : "C";
+				else if constexpr (sizeof(T) == 2)
+					return is_signed ? "s" : "S";
+				else if constexpr (sizeof(T) == 4)
+					return is_signed ? "i" : "I";
+				else
+					return is_signed ? "l" : "L";
+			}
+		}
+
+		/// <summary>
+		/// Columns and structs of an exported map. The parent and both children hold a reference each.
+		/// </summary>
+		template <class K, class V>
+		struct ArrowColumns
+		{
+			std::unique_ptr<K[]> keys; // not zeroed, ExportTo writes every element
+			std::unique_ptr<V[]> values;
+
+			const void* struct_buffers[1] = { nullptr }; // no validity bitmap, nothing is null
+			const void* key_buffers[2] = {};
+			const void* value_buffers[2] = {};
+
+			ArrowArray key_array{};
+			ArrowArray value_array{};
+			ArrowArray* array_children[2] = { &key_array, &value_array };
+		};
+
+		struct ArrowSchemas
+		{
+			ArrowSchema key_schema{};
+			ArrowSchema value_schema{};
+			ArrowSchema* schema_children[2] = { &key_schema, &value_schema };
+		};
+
+		template <class Owner>
+		void ReleaseArrow(ArrowArray* array)
+		{
+			delete static_cast<std::shared_ptr<Owner>*>(array->private_data);
+			array->release = nullptr;
+		}
+
+		template <class Owner>
+		void ReleaseArrow(ArrowSchema* schema)
+		{
+			delete static_cast<std::shared_ptr<Owner>*>(schema->private_data);
+			schema->release = nullptr;
+		}
+
+		template <class Owner>
+		void ReleaseArrowParent(ArrowArray* array)
+		{
+			for (int64_t i = 0; i < array->n_children; ++i)
+			{
+				if (array->children[i]->release) // not moved out by the consumer
+					array->children[i]->release(array->children[i]);
+			}
+			ReleaseArrow<Owner>(array);
+		}
+
+		template <class Owner>
+		void ReleaseArrowParent(ArrowSchema* schema)
+		{
+			for (int64_t i = 0; i < schema->n_children; ++i)
+			{
+				if (schema->children[i]->release)
+					schema->children[i]->release(schema->children[i]);
+			}
+			ReleaseArrow<Owner>(schema);
+		}
+	}
+
+	/// <summary>
+	/// Exports the entries of 'map' into 'array' and 'schema', a struct array of the non nullable columns
+	/// "key" and "value" in table order. 'executor' compacts slot ranges in parallel, see 'ExportTo'.
+	/// The caller, or the Arrow library it hands them to, must call their 'release' once.
+	/// </summary>
+	template <class K, class V, MapPolicy policy, class Executor = Internal::SerialExecutor>
+	void ExportArrow(const Internal::LinearCoreMapImpl<K, V, policy>& map, ArrowArray* array, ArrowSchema* schema, Executor&& executor = {})
+	{
+		using Columns = Internal::ArrowColumns<K, V>;
+		using Schemas = Internal::ArrowSchemas;
+
+		const auto columns = std::make_shared<Columns>();
+		columns->keys = std::make_unique_for_overwrite<K[]>(map.Size());
+		columns->values = std::make_unique_for_overwrite<V[]>(map.Size());
+		map.ExportTo(std::span<K>(columns->keys.get(), map.Size()), std::span<V>(columns->values.get(), map.Size()), executor);
+
+		const auto length = (int64_t)map.Size();
+		columns->key_buffers[1] = columns->keys.get();
+		columns->value_buffers[1] = columns->values.get();
+
+		const auto column = [&](ArrowArray& child, const void** buffers)
+			{
+				child = ArrowArray{ length, 0, 0, 2, 0, buffers, nullptr, nullptr,
+					&Internal::ReleaseArrow<Columns>, new std::shared_ptr<Columns>(columns) };
+			};
+		column(columns->key_array, columns->key_buffers);
+		column(columns->value_array, columns->value_buffers);
+
+		*array = ArrowArray{ length, 0, 0, 1, 2, columns->struct_buffers, columns->array_children, nullptr,
+			&Internal::ReleaseArrowParent<Columns>, new std::shared_ptr<Columns>(columns) };
+
+		const auto schemas = std::make_shared<Schemas>();
+		schemas->key_schema = ArrowSchema{ Internal::ArrowFormat<K>(), "key", nullptr, 0, 0, nullptr, nullptr,
+			&Internal::ReleaseArrow<Schemas>, new std::shared_ptr<Schemas>(schemas) };
+		schemas->value_schema = ArrowSchema{ Internal::ArrowFormat<V>(), "value", nullptr, 0, 0, nullptr, nullptr,
+			&Internal::ReleaseArrow<Schemas>, new std::shared_ptr<Schemas>(schemas) };
+
+		*schema = ArrowSchema{ "+s", "", nullptr, 0, 2, schemas->schema_children, nullptr,
+			&Internal::ReleaseArrowParent<Schemas>, new std::shared_ptr<Schemas>(schemas) };
+	}
+}
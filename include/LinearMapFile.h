@@ -0,0 +1,239 @@
+/*
+----------------------------------------------------------------------------------------
+FastLinearMap - Map files
+----------------------------------------------------------------------------------------
+Author: [aizu03]
+License: MIT (free to use, modify, and distribute)
+
+Saves a LinearCoreMap or LinearMap with trivially copyable keys and values to a file, and loads it back.
+
+SaveMap - Writes a header and the entries in chunks, the keys of a chunk then its values.
+LoadMap - Reads the chunks on background threads while the calling thread inserts the chunks that
+          already arrived into the map, presized from the header. Reading and inserting overlap,
+          so a load takes about as long as the slower of the two instead of their sum.
+
+Kept out of LinearMap.h, because it needs <fstream> and <thread>.
+
+*/
+
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LinearMap.h"
+
+namespace LinearProbing
+{
+	namespace Internal
+	{
+		struct MapFileHeader
+		{
+			static constexpr uint64_t file_magic = 0x314C494650414D4Cull; // "LMAPFIL1"
+
+			uint64_t magic;
+			uint32_t key_size;
+			uint32_t value_size;
+			uint64_t count;
+			uint64_t chunk_entries;
+		};
+
+		template <class K, class V>
+		struct MapFileChunk
+		{
+			std::vector<K> keys;
+			std::vector<V> values;
+			size_t count = 0;
+		};
+
+		/// <summary>
+		/// Entries of chunk 'chunk' and where it starts in the file.
+		/// </summary>
+		template <class K, class V>
+		std::pair<size_t, uint64_t> MapFileChunkSpan(const MapFileHeader& header, const size_t chunk) noexcept
+		{
+			const auto first = (uint64_t)chunk * header.chunk_entries;
+			const auto count = (size_t)(std::min)(header.chunk_entries, header.count - first);
+			return { count, sizeof(MapFileHeader) + first * (sizeof(K) + sizeof(V)) };
+		}
+	}
+
+	constexpr size_t default_map_file_chunk = 1 << 16; // entries per chunk, 1 MiB for 8 byte keys and values
+
+	/// <summary>
+	/// Writes every entry of 'map' to 'path'. Keys and values are written as raw bytes, so the file can
+	/// only be read on machines with the same byte order. Throws std::runtime_error if writing fails.
+	/// </summary>
+	template <class K, class V, MapPolicy policy>
+	void SaveMap(const Internal::LinearCoreMapImpl<K, V, policy>& map, const std::string& path, const size_t chunk_entries = default_map_file_chunk)
+	{
+		static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>, "map files hold raw bytes");
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			throw std::runtime_error("can't create map file " + path);
+
+		Internal::MapFileHeader header{};
+		header.magic = Internal::MapFileHeader::file_magic;
+		header.key_size = (uint32_t)sizeof(K);
+		header.value_size = (uint32_t)sizeof(V);
+		header.count = map.Size();
+		header.chunk_entries = (std::max)(chunk_entries, (size_t)1);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		Internal::MapFileChunk<K, V> chunk;
+		chunk.keys.resize(header.chunk_entries);
+		chunk.values.resize(header.chunk_entries);
+
+		const auto flush = [&]
+			{
+				file.write(reinterpret_cast<const char*>(chunk.keys.data()), (std::streamsize)(chunk.count * sizeof(K)));
+				file.write(reinterpret_cast<const char*>(chunk.values.data()), (std::streamsize)(chunk.count * sizeof(V)));
+				chunk.count = 0;
+			};
+
+		for (const auto& [key, value] : map)
+		{
+			chunk.keys[chunk.count] = key;
+			chunk.values[chunk.count] = value;
+			if (++chunk.count == header.chunk_entries)
+				flush();
+		}
+
+		if (chunk.count != 0)
+			flush();
+
+		if (!file.flush())
+			throw std::runtime_error("can't write map file " + path);
+	}
+
+	/// <summary>
+	/// Replaces the content of 'map' with the entries of a file written by SaveMap.
+	/// 'readers' threads read the chunks, the calling thread inserts them as they arrive.
+	/// At most two chunks per reader are in memory at once. Throws std::runtime_error if the file is missing,
+	/// truncated, or holds other key or value types. The map is left empty or partly loaded then.
+	/// </summary>
+	template <class K, class V, MapPolicy policy>
+	void LoadMap(Internal::LinearCoreMapImpl<K, V, policy>& map, const std::string& path, unsigned readers = 2)
+	{
+		static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>, "map files hold raw bytes");
+
+		using Chunk = Internal::MapFileChunk<K, V>;
+
+		Internal::MapFileHeader header{};
+		{
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file)
+				throw std::runtime_error("can't open map file " + path);
+
+			const auto bytes = (uint64_t)file.tellg();
+			file.seekg(0);
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != Internal::MapFileHeader::file_magic)
+				throw std::runtime_error("not a map file " + path);
+			if (header.key_size != sizeof(K) || header.value_size != sizeof(V) || header.chunk_entries == 0)
+				throw std::runtime_error("map file of other key or value types " + path);
+			if (bytes != sizeof(header) + header.count * (sizeof(K) + sizeof(V)))
+				throw std::runtime_error("truncated map file " + path);
+		}
+
+		map.Reserve((size_t)((double)header.count / map.MaxLoadFactor()) + 1); // no inserts will grow the table
+
+		const auto chunks = (size_t)((header.count + header.chunk_entries - 1) / header.chunk_entries);
+		readers = (unsigned)(std::min)((size_t)(std::max)(readers, 1u), (std::max)(chunks, (size_t)1));
+
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::deque<Chunk> filled;
+		std::deque<Chunk> spare(readers * 2);
+		std::exception_ptr error;
+		bool stop = false;
+
+		const auto read_chunks = [&](const unsigned reader)
+			{
+				try
+				{
+					std::ifstream file(path, std::ios::binary);
+					for (auto c = (size_t)reader; c < chunks; c += readers)
+					{
+						Chunk chunk;
+						{
+							std::unique_lock lock(mutex);
+							changed.wait(lock, [&] { return stop || !spare.empty(); });
+							if (stop)
+								return;
+
+							chunk = std::move(spare.front());
+							spare.pop_front();
+						}
+
+						const auto [count, offset] = Internal::MapFileChunkSpan<K, V>(header, c);
+						chunk.keys.resize(count);
+						chunk.values.resize(count);
+						chunk.count = count;
+
+						file.seekg((std::streamoff)offset);
+						file.read(reinterpret_cast<char*>(chunk.keys.data()), (std::streamsize)(count * sizeof(K)));
+						file.read(reinterpret_cast<char*>(chunk.values.data()), (std::streamsize)(count * sizeof(V)));
+						if (!file)
+							throw std::runtime_error("can't read map file " + path);
+
+						{
+							std::lock_guard lock(mutex);
+							filled.push_back(std::move(chunk));
+						}
+						changed.notify_all();
+					}
+				}
+				catch (...)
+				{
+					{
+						std::lock_guard lock(mutex);
+						if (!error)
+							error = std::current_exception();
+						stop = true;
+					}
+					changed.notify_all();
+				}
+			};
+
+		std::vector<std::thread> threads;
+		threads.reserve(readers);
+		for (unsigned reader = 0; reader < readers; ++reader)
+			threads.emplace_back(read_chunks, reader);
+
+		for (size_t inserted = 0; inserted < chunks; ++inserted)
+		{
+			Chunk chunk;
+			{
+				std::unique_lock lock(mutex);
+				changed.wait(lock, [&] { return stop || !filled.empty(); });
+				if (stop)
+					break;
+
+				chunk = std::move(filled.front());
+				filled.pop_front();
+			}
+
+			map.EmplaceAll(chunk.keys.data(), chunk.values.data(), chunk.count);
+
+			{
+				std::lock_guard lock(mutex);
+				spare.push_back(std::move(chunk));
+			}
+			changed.notify_all();
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
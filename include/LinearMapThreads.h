@@ -0,0 +1,604 @@
+/*
+----------------------------------------------------------------------------------------
+FastLinearMap - Maps shared between threads
+----------------------------------------------------------------------------------------
+Author: [aizu03]
+License: MIT (free to use, modify, and distribute)
+
+BufferedLinearMap<K,V> - A LinearCoreMap behind a reader writer lock. Each thread writes through its own
+                         Writer, which buffers the writes and applies them in batches under one lock.
+WorkStealingPool       - Threads that split a range of work adaptively. It is the executor for the parallel
+                         EmplaceAll, Rehash, ForEach and EraseIf of the maps and sets, and for the set algebra
+                         below (Merge, Union, Intersection, Difference).
+
+Kept out of LinearMap.h, because it needs <mutex> and <thread>.
+
+*/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LinearMap.h"
+
+namespace LinearProbing
+{
+	constexpr size_t default_write_buffer = 1024; // writes per lock acquisition
+
+	/// <summary>
+	/// A LinearCoreMap shared between threads. Writes go through a Writer per thread, which collects them
+	/// and flushes them in one batch under the write lock, when 'flush_at' keys are pending, on Flush and
+	/// when the Writer is destroyed. Later writes of a key replace its pending write, so a batch holds
+	/// every key at most once.
+	/// Reads choose their visibility: the map's Find and Contains only see flushed writes (eventual),
+	/// a Writer's Find and Contains also see its own pending writes (read your writes).
+	/// If two Writers write the same key, the one that flushes last wins.
+	/// </summary>
+	template <class K, class V, MapPolicy policy = MapPolicy{}>
+	class BufferedLinearMap final
+	{
+		// readers share the lock, so reads must not modify the map
+		static_assert(policy.hot_keys == 0 && policy.reordering == HitReordering::None,
+			"the hot key cache and hit reordering modify the map on reads");
+
+		using Map = LinearCoreMap<K, V, policy>;
+
+		mutable std::shared_mutex m_mutex;
+		Map m_map;
+
+	public:
+
+		/// <summary>
+		/// Buffers the writes of one thread. Not thread safe itself, keep one per thread.
+		/// It must not outlive its map.
+		/// </summary>
+		class Writer final
+		{
+			BufferedLinearMap* m_owner;
+			size_t m_flush_at;
+
+			LinearCoreMap<K, uint32_t> m_pending; // key -> index into the arrays below
+			std::vector<K> m_keys;
+			std::vector<V> m_values;
+			std::vector<uint8_t> m_erased;
+
+		public:
+
+			explicit Writer(BufferedLinearMap& owner, const size_t flush_at = default_write_buffer)
+				: m_owner(&owner), m_flush_at((std::max)(flush_at, (size_t)1))
+			{
+				m_pending.Reserve((size_t)((double)m_flush_at / m_pending.MaxLoadFactor()) + 1);
+				m_keys.reserve(m_flush_at);
+				m_values.reserve(m_flush_at);
+				m_erased.reserve(m_flush_at);
+			}
+
+			~Writer()
+			{
+				if (m_owner)
+					Flush();
+			}
+
+			Writer(const Writer&) = delete;
+			Writer& operator=(const Writer&) = delete;
+
+			Writer(Writer&& other) noexcept
+				: m_owner(std::exchange(other.m_owner, nullptr)), m_flush_at(other.m_flush_at),
+				m_pending(std::move(other.m_pending)), m_keys(std::move(other.m_keys)),
+				m_values(std::move(other.m_values)), m_erased(std::move(other.m_erased))
+			{
+			}
+
+			Writer& operator=(Writer&&) = delete;
+
+			/// <summary>
+			/// Writes not yet flushed.
+			/// </summary>
+			[[nodiscard]] size_t Pending() const noexcept
+			{
+				return m_keys.size();
+			}
+
+			template <typename ValType>
+			void Emplace(const K& key, ValType&& value)
+			{
+				auto& index = m_pending.Get(key);
+				if (m_pending.IsValid(index))
+				{
+					m_values[index] = std::forward<ValType>(value);
+					m_erased[index] = 0;
+					return;
+				}
+
+				Append(key, std::forward<ValType>(value), 0);
+			}
+
+			/// <summary>
+			/// Erases 'key' with the next flush. Whether it was there is only known then.
+			/// </summary>
+			void Erase(const K& key)
+			{
+				auto& index = m_pending.Get(key);
+				if (m_pending.IsValid(index))
+				{
+					m_erased[index] = 1;
+					return;
+				}
+
+				Append(key, V{}, 1);
+			}
+
+			/// <summary>
+			/// The value of 'key', seeing the pending writes of this Writer.
+			/// </summary>
+			[[nodiscard]] std::optional<V> Find(const K& key) const
+			{
+				const auto& index = std::as_const(m_pending)[key];
+				if (m_pending.IsValid(index))
+				{
+					if (m_erased[index])
+						return std::nullopt;
+					return m_values[index];
+				}
+
+				return m_owner->Find(key);
+			}
+
+			[[nodiscard]] bool Contains(const K& key) const
+			{
+				const auto& index = std::as_const(m_pending)[key];
+				if (m_pending.IsValid(index))
+					return !m_erased[index];
+
+				return m_owner->Contains(key);
+			}
+
+			/// <summary>
+			/// Applies the pending writes under one acquisition of the write lock.
+			/// </summary>
+			void Flush()
+			{
+				if (m_keys.empty())
+					return;
+
+				// emplaced keys to the front for EmplaceAll, erased keys behind them
+				size_t emplaced = 0;
+				for (size_t i = 0; i < m_keys.size(); ++i)
+				{
+					if (m_erased[i])
+						continue;
+
+					if (emplaced != i)
+					{
+						std::swap(m_keys[emplaced], m_keys[i]);
+						std::swap(m_values[emplaced], m_values[i]);
+					}
+					++emplaced;
+				}
+
+				{
+					std::unique_lock lock(m_owner->m_mutex);
+					for (size_t i = emplaced; i < m_keys.size(); ++i)
+						m_owner->m_map.Erase(m_keys[i]);
+					m_owner->m_map.EmplaceAll(m_keys.data(), m_values.data(), emplaced);
+				}
+
+				m_pending.Clear();
+				m_keys.clear();
+				m_values.clear();
+				m_erased.clear();
+			}
+
+		private:
+
+			template <typename ValType>
+			void Append(const K& key, ValType&& value, const uint8_t erased)
+			{
+				m_pending.Emplace(key, (uint32_t)m_keys.size());
+				m_keys.push_back(key);
+				m_values.push_back(std::forward<ValType>(value));
+				m_erased.push_back(erased);
+
+				if (m_keys.size() >= m_flush_at)
+					Flush();
+			}
+		};
+
+		explicit BufferedLinearMap() = default;
+
+		explicit BufferedLinearMap(const size_t capacity) : m_map(capacity)
+		{
+		}
+
+		BufferedLinearMap(const BufferedLinearMap&) = delete;
+		BufferedLinearMap& operator=(const BufferedLinearMap&) = delete;
+
+		/// <summary>
+		/// A new Writer for the calling thread, flushing every 'flush_at' pending keys.
+		/// </summary>
+		[[nodiscard]] Writer MakeWriter(const size_t flush_at = default_write_buffer)
+		{
+			return Writer(*this, flush_at);
+		}
+
+		[[nodiscard]] size_t Size() const
+		{
+			std::shared_lock lock(m_mutex);
+			return m_map.Size();
+		}
+
+		/// <summary>
+		/// The value of 'key', seeing flushed writes only.
+		/// </summary>
+		[[nodiscard]] std::optional<V> Find(const K& key) const
+		{
+			std::shared_lock lock(m_mutex);
+			const auto& value = std::as_const(m_map)[key];
+			if (!m_map.IsValid(value))
+				return std::nullopt;
+			return value;
+		}
+
+		[[nodiscard]] bool Contains(const K& key) const
+		{
+			std::shared_lock lock(m_mutex);
+			return m_map.IsValid(std::as_const(m_map)[key]);
+		}
+
+		/// <summary>
+		/// Calls 'f(const LinearCoreMap&)' under the read lock, for scans and several reads at once.
+		/// </summary>
+		template <typename F>
+		decltype(auto) Read(F&& f) const
+		{
+			std::shared_lock lock(m_mutex);
+			return std::forward<F>(f)(std::as_const(m_map));
+		}
+
+		/// <summary>
+		/// Calls 'f(LinearCoreMap&)' under the write lock.
+		/// </summary>
+		template <typename F>
+		decltype(auto) Write(F&& f)
+		{
+			std::unique_lock lock(m_mutex);
+			return std::forward<F>(f)(m_map);
+		}
+	};
+
+	/// <summary>
+	/// Worker threads that run 'f(first, last)' over a range [0, count) of work, as the executor of
+	/// the parallel map operations: 'map.EmplaceAll(keys, values, count, pool)'.
+	/// Each worker starts with an even share of the range and runs it from the front in small pieces.
+	/// A worker that runs out steals the back half of the largest share left, so a share with slow pieces,
+	/// e.g. the long clusters of a skewed table, is finished by several workers.
+	/// The calling thread works as one of the workers. Not reentrant, 'f' must not use the same pool.
+	/// The first exception thrown by 'f' stops the other pieces and is rethrown to the caller.
+	/// </summary>
+	class WorkStealingPool final
+	{
+		struct alignas(64) Share
+		{
+			std::mutex mutex;
+			size_t first = 0;
+			size_t last = 0;
+		};
+
+		unsigned m_workers;
+		std::unique_ptr<Share[]> m_shares; // worker 0 is the calling thread
+		std::vector<std::thread> m_threads;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		uint64_t m_generation = 0;
+		unsigned m_running = 0;
+		bool m_exit = false;
+
+		void (*m_invoke)(void* f, size_t first, size_t last) = nullptr;
+		void* m_job = nullptr;
+		size_t m_grain = 1;
+		std::atomic<bool> m_stop = false;
+		std::exception_ptr m_error;
+
+	public:
+
+		explicit WorkStealingPool(const unsigned threads = std::thread::hardware_concurrency())
+			: m_workers((std::max)(threads, 1u)), m_shares(std::make_unique<Share[]>(m_workers))
+		{
+			m_threads.reserve(m_workers - 1);
+			for (unsigned worker = 1; worker < m_workers; ++worker)
+				m_threads.emplace_back([this, worker] { WorkerLoop(worker); });
+		}
+
+		~WorkStealingPool()
+		{
+			{
+				std::lock_guard lock(m_mutex);
+				m_exit = true;
+			}
+			m_wake.notify_all();
+
+			for (auto& thread : m_threads)
+				thread.join();
+		}
+
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		[[nodiscard]] unsigned Threads() const noexcept
+		{
+			return m_workers;
+		}
+
+		template <typename F>
+		void operator()(const size_t count, F&& f)
+		{
+			if (count == 0)
+				return;
+
+			if (m_workers == 1 || count == 1)
+			{
+				f((size_t)0, count);
+				return;
+			}
+
+			m_job = (void*)std::addressof(f);
+			m_invoke = [](void* job, const size_t first, const size_t last)
+				{
+					(*static_cast<std::remove_reference_t<F>*>(job))(first, last);
+				};
+			m_grain = (std::max)(count / ((size_t)m_workers * 16), (size_t)1);
+			m_stop = false;
+
+			for (unsigned worker = 0; worker < m_workers; ++worker)
+			{
+				std::lock_guard lock(m_shares[worker].mutex);
+				m_shares[worker].first = count * worker / m_workers;
+				m_shares[worker].last = count * (worker + 1) / m_workers;
+			}
+
+			{
+				std::lock_guard lock(m_mutex);
+				m_running = m_workers - 1;
+				++m_generation;
+			}
+			m_wake.notify_all();
+
+			RunShares(0);
+
+			{
+				std::unique_lock lock(m_mutex);
+				m_done.wait(lock, [&] { return m_running == 0; });
+			}
+
+			if (m_error)
+				std::rethrow_exception(std::exchange(m_error, nullptr));
+		}
+
+	private:
+
+		void WorkerLoop(const unsigned worker)
+		{
+			uint64_t generation = 0;
+			for (;;)
+			{
+				{
+					std::unique_lock lock(m_mutex);
+					m_wake.wait(lock, [&] { return m_exit || m_generation != generation; });
+					if (m_exit)
+						return;
+					generation = m_generation;
+				}
+
+				RunShares(worker);
+
+				bool last;
+				{
+					std::lock_guard lock(m_mutex);
+					last = --m_running == 0;
+				}
+				if (last)
+					m_done.notify_one();
+			}
+		}
+
+		void RunShares(const unsigned worker)
+		{
+			try
+			{
+				auto& share = m_shares[worker];
+				while (!m_stop.load(std::memory_order_relaxed))
+				{
+					size_t first, last;
+					{
+						std::lock_guard lock(share.mutex);
+						first = share.first;
+						last = (std::min)(share.last, first + m_grain);
+						share.first = last;
+					}
+
+					if (first < last)
+						m_invoke(m_job, first, last);
+					else if (!Steal(worker))
+						return;
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard lock(m_mutex);
+				if (!m_error)
+					m_error = std::current_exception();
+				m_stop = true;
+			}
+		}
+
+		/// <summary>
+		/// Moves the back half of the largest share into the empty share of 'thief'. False, if no work is left.
+		/// </summary>
+		bool Steal(const unsigned thief)
+		{
+			for (;;)
+			{
+				unsigned victim = thief;
+				size_t most = 0;
+				for (unsigned worker = 0; worker < m_workers; ++worker)
+				{
+					std::lock_guard lock(m_shares[worker].mutex);
+					const auto left = m_shares[worker].last - (std::min)(m_shares[worker].first, m_shares[worker].last);
+					if (left > most)
+					{
+						most = left;
+						victim = worker;
+					}
+				}
+
+				if (most == 0)
+					return false;
+
+				size_t first, last;
+				{
+					std::lock_guard lock(m_shares[victim].mutex);
+					auto& share = m_shares[victim];
+					if (share.first >= share.last)
+						continue; // finished meanwhile, look again
+
+					last = share.last;
+					first = share.first + (share.last - share.first) / 2;
+					share.last = first;
+				}
+
+				std::lock_guard lock(m_shares[thief].mutex);
+				m_shares[thief].first = first;
+				m_shares[thief].last = last;
+				return true;
+			}
+		}
+	};
+
+	namespace Internal
+	{
+		/// <summary>
+		/// Copies the entries (keys of a set) for which 'keep' is true into dense arrays, the slots of 'map' split
+		/// into blocks for 'executor'. Two passes, one counts per block, the other copies at the block offsets.
+		/// </summary>
+		template <class Map, class Keep, class Executor, class... Out>
+		size_t GatherInto(const Map& map, Keep&& keep, Executor&& executor, std::vector<Out>&... out)
+		{
+			const auto slots = map.Capacity();
+			const auto blocks = (std::min)(parallel_blocks, slots);
+			std::vector<size_t> offsets(blocks + 1);
+
+			const auto block_slots = [&](const size_t block, auto&& f)
+				{
+					map.ForEachInSlots(block * slots / blocks, (block + 1) * slots / blocks, f);
+				};
+
+			executor(blocks, [&](const size_t first, const size_t last)
+				{
+					for (auto block = first; block < last; ++block)
+					{
+						size_t kept = 0;
+						block_slots(block, [&](const auto&... entry) { kept += keep(entry...); });
+						offsets[block + 1] = kept;
+					}
+				});
+
+			for (size_t block = 0; block < blocks; ++block)
+				offsets[block + 1] += offsets[block];
+			(out.resize(offsets[blocks]), ...);
+
+			executor(blocks, [&](const size_t first, const size_t last)
+				{
+					for (auto block = first; block < last; ++block)
+					{
+						auto at = offsets[block];
+						block_slots(block, [&](const auto&... entry)
+							{
+								if (keep(entry...))
+								{
+									((out[at] = entry), ...);
+									++at;
+								}
+							});
+					}
+				});
+
+			return offsets[blocks];
+		}
+	}
+
+	/// <summary>
+	/// Inserts every entry of 'source' into 'target', the values of 'source' win. The entries are gathered
+	/// into arrays and inserted with the parallel EmplaceAll, both on the threads of 'executor'.
+	/// </summary>
+	template <class K, class V, MapPolicy policy, MapPolicy source_policy, class Executor>
+	void Merge(Internal::LinearCoreMapImpl<K, V, policy>& target, const Internal::LinearCoreMapImpl<K, V, source_policy>& source, Executor&& executor)
+	{
+		std::vector<K> keys;
+		std::vector<V> values;
+		const auto count = Internal::GatherInto(source, [](const K&, const V&) { return true; }, executor, keys, values);
+		target.EmplaceAll(keys.data(), values.data(), count, executor);
+	}
+
+	/// <summary>
+	/// Inserts every key of 'source' into 'target'.
+	/// </summary>
+	template <class K, MapPolicy policy, MapPolicy source_policy, class Executor>
+	void Merge(LinearSet<K, policy>& target, const LinearSet<K, source_policy>& source, Executor&& executor)
+	{
+		std::vector<K> keys;
+		const auto count = Internal::GatherInto(source, [](const K&) { return true; }, executor, keys);
+		target.EmplaceAll(keys.data(), count, executor);
+	}
+
+	/// <summary>
+	/// Keys of 'a' or 'b'.
+	/// </summary>
+	template <class K, MapPolicy policy, class Executor>
+	[[nodiscard]] LinearSet<K, policy> Union(const LinearSet<K, policy>& a, const LinearSet<K, policy>& b, Executor&& executor)
+	{
+		auto result = a;
+		Merge(result, b, executor);
+		return result;
+	}
+
+	/// <summary>
+	/// Keys of 'a' that are also in 'b'. The keys of 'a' are tested against 'b' on the threads of 'executor'.
+	/// </summary>
+	template <class K, MapPolicy policy, class Executor>
+	[[nodiscard]] LinearSet<K, policy> Intersection(const LinearSet<K, policy>& a, const LinearSet<K, policy>& b, Executor&& executor)
+	{
+		auto& other = const_cast<LinearSet<K, policy>&>(b); // Contains doesn't modify the set
+		std::vector<K> keys;
+		const auto count = Internal::GatherInto(a, [&](const K& key) { return other.Contains(key); }, executor, keys);
+
+		LinearSet<K, policy> result;
+		result.EmplaceAll(keys.data(), count, executor);
+		return result;
+	}
+
+	/// <summary>
+	/// Keys of 'a' that aren't in 'b'.
+	/// </summary>
+	template <class K, MapPolicy policy, class Executor>
+	[[nodiscard]] LinearSet<K, policy> Difference(const LinearSet<K, policy>& a, const LinearSet<K, policy>& b, Executor&& executor)
+	{
+		auto& other = const_cast<LinearSet<K, policy>&>(b); // Contains doesn't modify the set
+		std::vector<K> keys;
+		const auto count = Internal::GatherInto(a, [&](const K& key) { return !other.Contains(key); }, executor, keys);
+
+		LinearSet<K, policy> result;
+		result.EmplaceAll(keys.data(), count, executor);
+		return result;
+	}
+}
@@ -0,0 +1,80 @@
+#!/usr/bin/env bash
+# Builds FastLinearMap three times and compares them on the map workloads:
+#
+#   plain  - Release
+#   pgo    - Release + LTO, optimized with profiles from a training run of MapWorkload and FastMap
+#
+# Usage: scripts/pgo_build.sh [build-root] [--scale X] [--repeat N]
+#   CXX selects the compiler (g++ or clang++). Clang needs llvm-profdata.
+#
+# Output:
+#   <build-root>/plain      plain binaries
+#   <build-root>/pgo        PGO + LTO binaries (FastMap, MapWorkload, HashAnalysis, FuzzMap)
+#   <build-root>/report.txt workload times of both builds
+
+set -euo pipefail
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+build="${1:-$root/_pgo}"
+[[ $# -gt 0 ]] && shift
+scale=1.0
+repeat=5
+
+while [[ $# -gt 0 ]]; do
+	case "$1" in
+		--scale) scale="$2"; shift 2 ;;
+		--repeat) repeat="$2"; shift 2 ;;
+		*) echo "unknown option $1" >&2; exit 1 ;;
+	esac
+done
+
+profiles="$build/profiles"
+jobs="$(nproc 2>/dev/null || echo 4)"
+mkdir -p "$build"
+
+configure() { cmake -S "$root" -B "$1" -DCMAKE_BUILD_TYPE=Release "${@:2}" > /dev/null; }
+compile() { cmake --build "$1" -j"$jobs" > /dev/null; }
+
+echo "== plain build"
+configure "$build/plain" -DLMAP_PGO=OFF -DLMAP_LTO=OFF
+compile "$build/plain"
+
+# gcc finds the profile of an object by its path, so the instrumented and the
+# optimized build share one build directory
+echo "== instrumented build"
+rm -rf "$profiles"
+configure "$build/pgo" -DLMAP_PGO=GENERATE -DLMAP_LTO=OFF -DLMAP_PGO_DIR="$profiles"
+compile "$build/pgo"
+
+echo "== training run"
+"$build/pgo/MapWorkload" --scale "$scale" --repeat 1 > /dev/null
+"$build/pgo/FastMap" > /dev/null
+
+if ls "$profiles"/*.profraw > /dev/null 2>&1; then
+	llvm-profdata merge -output="$profiles/default.profdata" "$profiles"/*.profraw
+fi
+
+echo "== optimized build (PGO + LTO)"
+configure "$build/pgo" -DLMAP_PGO=USE -DLMAP_LTO=ON -DLMAP_PGO_DIR="$profiles"
+compile "$build/pgo"
+
+echo "== comparing"
+"$build/plain/MapWorkload" --scale "$scale" --repeat "$repeat" --report "$build/plain.tsv" > /dev/null
+"$build/pgo/MapWorkload" --scale "$scale" --repeat "$repeat" --report "$build/pgo.tsv" > /dev/null
+
+{
+	echo "Compiler: $(${CXX:-c++} --version | head -n 1)"
+	echo "Scale $scale, best of $repeat"
+	echo
+	paste "$build/plain.tsv" "$build/pgo.tsv" | awk -F '\t' '
+		BEGIN { printf "%-34s %12s %12s %9s\n", "Workload", "plain(ms)", "pgo+lto(ms)", "Speedup" }
+		{
+			if ($3 != $6) { printf "%s: checksum differs between builds\n", $1; bad = 1 }
+			printf "%-34s %12.2f %12.2f %8.2fx\n", $1, $2, $5, $2 / $5
+			plain += $2; pgo += $5
+		}
+		END {
+			printf "%-34s %12.2f %12.2f %8.2fx\n", "Total", plain, pgo, plain / pgo
+			exit bad
+		}'
+} | tee "$build/report.txt"
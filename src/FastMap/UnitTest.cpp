@@ -3,15 +3,38 @@
 
 // ReSharper disable CppClangTidyMiscUseAnonymousNamespace
 #include "LinearMap.h"
+#include "LinearMapArrow.h"
+#include "LinearMapFile.h"
+#include "LinearMapThreads.h"
 
 #include <cassert>
 #include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <numeric>
 #include <random>
 #include <string>
+#include <thread>
 #include <unordered_set>
 
+#include "buffered_benchmark.h"
+#include "compact_benchmark.h"
+#include "copy_benchmark.h"
+#include "erase_benchmark.h"
 #include "examples.h"
+#include "export_benchmark.h"
+#include "file_benchmark.h"
+#include "hot_key_benchmark.h"
+#include "key_benchmark.h"
+#include "latency_benchmark.h"
+#include "memory_benchmark.h"
+#include "parallel_benchmark.h"
+#include "partitioned_benchmark.h"
+#include "probing_benchmark.h"
+#include "sorted_benchmark.h"
+#include "versioned_benchmark.h"
+#include "view_benchmark.h"
 
 #if defined(__clang__)
 #   define NO_OPTIMIZE_BEGIN  __attribute__((optnone))
@@ -20,7 +43,7 @@
 #   define NO_OPTIMIZE_BEGIN  __pragma(optimize("", off))
 #   define NO_OPTIMIZE_END    __pragma(optimize("", on))
 #elif defined(__GNUC__)
-#   define NO_OPTIMIZE_BEGIN  __attribute__((optnone))
+#   define NO_OPTIMIZE_BEGIN  __attribute__((optimize("O0")))
 #   define NO_OPTIMIZE_END
 #else
 #   define NO_OPTIMIZE_BEGIN
@@ -454,6 +477,1364 @@ static void TestErase()
 }
 NO_OPTIMIZE_END
 NO_OPTIMIZE_BEGIN
+static void TestTombstoneErase()
+{
+	constexpr MapPolicy tombstones{ DeletionPolicy::Tombstone };
+
+	LinearMap<int, tombstones> map(64);
+	for (size_t i = 0; i < 40; i++)
+		map.Emplace(i * 64, (int)i); // all keys share one home slot, one long cluster
+
+	for (size_t i = 0; i < 40; i += 2)
+		assert_always(map.Erase(i * 64));
+
+	assert_always(map.Size() == 20);
+	assert_always(map.Tombstones() > 0);
+	assert_always(!map.Contains(0)); // a tombstone holds the default key 0
+
+	for (size_t i = 1; i < 40; i += 2)
+		assert_always(map.Get(i * 64) == (int)i); // probes pass the tombstones
+
+	map.Emplace(2 * 64, 2); // reuses the first tombstone on the way
+	assert_always(map.Get(2 * 64) == 2);
+
+	// churn, tombstones trigger rebuilds instead of growing the table
+	for (size_t i = 0; i < 10'000; i++)
+	{
+		map.Erase(i * 64);
+		map.Emplace((i + 40) * 64, (int)i);
+	}
+
+	assert_always(map.Size() == 40);
+	assert_always(map.Capacity() == 64);
+	assert_always(map.Size() + map.Tombstones() <= (size_t)(map.Capacity() * map.MaxLoadFactor()));
+
+	LinearSet<std::string, tombstones> set;
+	set.Emplace(std::string("a"));
+	set.Emplace(std::string("b"));
+	assert_always(set.Erase("a"));
+	assert_always(!set.Contains("a") && set.Contains("b"));
+
+	size_t iterated = 0;
+	for (const auto& key : set)
+	{
+		assert_always(key == "b");
+		iterated++;
+	}
+	assert_always(iterated == 1);
+
+	std::cout << "TestTombstoneErase passed!\n";
+}
+NO_OPTIMIZE_END
+template <MapPolicy policy>
+NO_OPTIMIZE_BEGIN
+static void TestProbing()
+{
+	LinearMap<int, policy> map;
+	for (size_t i = 0; i < 5'000; i++)
+		map.Emplace(i * 1024, (int)i); // strided keys, few distinct homes
+
+	for (size_t i = 0; i < 5'000; i += 3)
+		assert_always(map.Erase(i * 1024));
+
+	for (size_t i = 0; i < 5'000; i++)
+	{
+		if (i % 3 == 0)
+			assert_always(!map.Contains(i * 1024));
+		else
+			assert_always(map.Get(i * 1024) == (int)i);
+	}
+
+	map.Rehash(map.Capacity() * 2);
+	assert_always(map.Tombstones() == 0);
+	assert_always(map.Get(1024) == 1);
+
+	size_t sum = 0;
+	for (const auto& [key, value] : map)
+		sum += (size_t)value;
+
+	size_t expected = 0;
+	for (size_t i = 0; i < 5'000; i++)
+		expected += i % 3 ? i : 0;
+	assert_always(sum == expected);
+
+	LinearSet<std::string, policy> set;
+	for (int i = 0; i < 100; i++)
+		set.Emplace("key_" + std::to_string(i));
+	for (int i = 0; i < 100; i += 2)
+		assert_always(set.Erase("key_" + std::to_string(i)));
+	for (int i = 0; i < 100; i++)
+		assert_always(set.Contains("key_" + std::to_string(i)) == (i % 2 == 1));
+}
+
+static void TestProbingPolicies()
+{
+	TestProbing<MapPolicy{ .probing = ProbingPolicy::Triangular }>();
+	TestProbing<MapPolicy{ .probing = ProbingPolicy::GroupLinear }>();
+
+	// the group of a slot with an empty neighbour isn't passed by any probe, erase leaves no tombstone
+	LinearMap<int, MapPolicy{ .probing = ProbingPolicy::GroupLinear }> map(64);
+	map.Emplace(5, 5);
+	map.Erase(5);
+	assert_always(map.Tombstones() == 0);
+
+	std::cout << "TestProbingPolicies passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestHopscotch()
+{
+	HopscotchLinearMap<size_t, int> map(1 << 14);
+	const auto count = (size_t)((1 << 14) * 0.89);
+
+	std::mt19937_64 rng(5);
+	std::vector<size_t> keys(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		keys[i] = rng();
+		map.Emplace(keys[i], (int)i);
+	}
+
+	assert_always(map.Capacity() == 1 << 14); // fills up to 0.9 without growing
+	for (size_t i = 0; i < count; i++)
+		assert_always(map.Get(keys[i]) == (int)i);
+
+	for (size_t i = 0; i < count; i += 2)
+		assert_always(map.Erase(keys[i]));
+	assert_always(!map.Erase(keys[0]));
+	assert_always(!map.IsValid(map.Get(keys[0])));
+	assert_always(map.Size() == count / 2);
+
+	size_t iterated = 0;
+	for (const auto& [key, value] : map)
+	{
+		assert_always(keys[(size_t)value] == key && value % 2 == 1);
+		iterated++;
+	}
+	assert_always(iterated == map.Size());
+
+	// strided keys, many share their low bits
+	HopscotchLinearMap<size_t, int> strided;
+	for (size_t i = 0; i < 50'000; i++)
+		strided.Emplace(i * 1024, (int)i);
+	for (size_t i = 0; i < 50'000; i++)
+		assert_always(strided.Get(i * 1024) == (int)i);
+	assert_always(strided.Capacity() <= 1 << 17);
+
+	auto copy = strided;
+	copy.Erase(1024);
+	assert_always(strided.Contains(1024) && !copy.Contains(1024));
+
+	HopscotchLinearMap<std::string, int> strings;
+	strings["a"] = 1;
+	assert_always(strings.TryEmplace(std::string("b"), 2));
+	assert_always(!strings.TryEmplace(std::string("b"), 3));
+	assert_always(strings.GetOrCreate(std::string("c"), 4) == 4);
+	assert_always(strings.Get("a") == 1 && strings.Get("b") == 2 && strings.Size() == 3);
+
+	std::cout << "TestHopscotch passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestCuckoo()
+{
+	LinearCuckooMap<size_t, int> map(1 << 14);
+	const auto count = (size_t)((1 << 14) * 0.95);
+
+	std::mt19937_64 rng(9);
+	std::vector<size_t> keys(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		keys[i] = rng();
+		map.Emplace(keys[i], (int)i);
+	}
+
+	assert_always(map.Capacity() == 1 << 14); // displacements fill 4 slot buckets up to 0.95
+	for (size_t i = 0; i < count; i++)
+		assert_always(map.Get(keys[i]) == (int)i);
+
+	for (size_t i = 0; i < count; i += 2)
+		assert_always(map.Erase(keys[i]));
+	assert_always(!map.Contains(keys[0]) && !map.IsValid(map.Get(keys[0])));
+	assert_always(map.Size() == count / 2);
+
+	size_t iterated = 0;
+	for (const auto& [key, value] : map)
+	{
+		assert_always(keys[(size_t)value] == key && value % 2 == 1);
+		iterated++;
+	}
+	assert_always(iterated == map.Size());
+
+	LinearCuckooMap<size_t, int, 8> strided(8);
+	for (size_t i = 0; i < 50'000; i++)
+		strided.Emplace(i * 1024, (int)i);
+	for (size_t i = 0; i < 50'000; i++)
+		assert_always(strided.Get(i * 1024) == (int)i);
+
+	auto copy = strided;
+	copy.Erase(1024);
+	assert_always(strided.Contains(1024) && !copy.Contains(1024));
+
+	LinearCuckooMap<std::string, int> strings;
+	strings["a"] = 1;
+	assert_always(strings.TryEmplace(std::string("b"), 2));
+	assert_always(!strings.TryEmplace(std::string("b"), 3));
+	assert_always(strings.Get("a") == 1 && strings.Get("b") == 2 && strings.Size() == 2);
+
+	std::cout << "TestCuckoo passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestHotKeys()
+{
+	constexpr MapPolicy hot{ .hot_keys = 4 };
+
+	LinearMap<int, hot> map(64);
+	for (size_t i = 0; i < 30; i++)
+		map.Emplace(i * 64, (int)i); // one cluster, erases shift every key behind
+
+	for (size_t i = 0; i < 30; i++)
+		assert_always(map.Get(i * 64) == (int)i); // fills the cache
+
+	map.Get(5 * 64) = 55; // a hit returns the value in the table
+	assert_always(map.Get(5 * 64) == 55);
+	map.Emplace(5 * 64, 5);
+	assert_always(map.Get(5 * 64) == 5);
+
+	for (size_t i = 0; i < 30; i += 2)
+	{
+		assert_always(map.Erase(i * 64));
+		assert_always(!map.Contains(i * 64));
+		for (size_t j = i + 1; j < 30; j += 2)
+			assert_always(map.Get(j * 64) == (int)j); // cached slots moved by the shift
+	}
+
+	for (size_t i = 30; i < 200; i++)
+		map.Emplace(i * 64, (int)i); // grows, every slot moves
+	for (size_t i = 1; i < 200; i++)
+		assert_always(map.Get(i * 64) == (i < 30 && i % 2 == 0 ? 0 : (int)i));
+
+	auto copy = map;
+	copy.Clear();
+	assert_always(!copy.Contains(64) && map.Contains(64));
+
+	LinearCoreMap<std::string, int, MapPolicy{ DeletionPolicy::Tombstone, ProbingPolicy::Linear, 16 }> strings;
+	strings["a"] = 1;
+	assert_always(strings.Get("a") == 1);
+	assert_always(strings.Erase("a"));
+	assert_always(!strings.Contains("a") && !strings.IsValid(strings.Get("a")));
+	strings["a"] = 2;
+	assert_always(strings.Get("a") == 2);
+
+	// const readers on several threads, they must not write the cache
+	LinearCoreMap<uint64_t, uint64_t, MapPolicy{ .hot_keys = 64 }> shared;
+	for (uint64_t i = 0; i < 10'000; ++i)
+		shared.Emplace(i, i + 1);
+	const auto& reader = shared;
+	std::vector<std::thread> readers;
+	for (uint64_t t = 0; t < 4; ++t)
+	{
+		readers.emplace_back([&reader, t]
+			{
+				for (uint64_t round = 0; round < 10; ++round)
+				{
+					for (uint64_t i = t; i < 10'000; i += 7)
+						assert_always(reader[i] == i + 1);
+				}
+			});
+	}
+	for (auto& thread : readers)
+		thread.join();
+
+	std::cout << "TestHotKeys passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestHitReordering()
+{
+	constexpr MapPolicy transpose{ .reordering = HitReordering::Transpose };
+
+	LinearMap<int, transpose> map(64);
+	for (size_t i = 0; i < 20; i++)
+		map.Emplace(i * 64, (int)i); // all keys share one home slot
+
+	for (size_t i = 0; i < 19; i++)
+		assert_always(map.Get(19 * 64) == 19); // one slot forward per hit
+
+	assert_always((*map.begin()).first == 19 * 64); // now in the home slot
+	for (size_t i = 0; i < 20; i++)
+		assert_always(map.Get(i * 64) == (int)i);
+
+	for (size_t i = 0; i < 20; i += 2)
+		assert_always(map.Erase(i * 64)); // backward shift over the reordered cluster
+	for (size_t i = 0; i < 20; i++)
+	{
+		assert_always(map.Contains(i * 64) == (i % 2 == 1));
+		if (i % 2)
+			assert_always(map.Get(i * 64) == (int)i);
+	}
+
+	// a const lookup doesn't reorder
+	LinearMap<int, transpose> cluster(64);
+	for (size_t i = 0; i < 20; i++)
+		cluster.Emplace(i * 64, (int)i);
+	const auto& reader = cluster;
+	const auto before = reader.Keys();
+	const std::vector<size_t> order(before.begin(), before.end());
+	for (size_t i = 0; i < 19; i++)
+		assert_always(reader[19 * 64] == 19);
+	assert_always(!reader.IsValid(reader[20 * 64]));
+	const auto after = reader.Keys();
+	assert_always(std::ranges::equal(order, after));
+
+	LinearCoreMap<std::string, int, MapPolicy{ DeletionPolicy::Tombstone, ProbingPolicy::Linear, 0, HitReordering::Transpose }> strings;
+	for (int i = 0; i < 50; i++)
+		strings.Emplace("key_" + std::to_string(i), i);
+	for (int i = 0; i < 50; i += 3)
+		strings.Erase("key_" + std::to_string(i));
+	for (int round = 0; round < 3; round++)
+	{
+		for (int i = 0; i < 50; i++)
+			assert_always(strings.Get("key_" + std::to_string(i)) == (i % 3 ? i : 0));
+	}
+
+	std::cout << "TestHitReordering passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestPartitioned()
+{
+	PartitionedLinearMap<size_t, size_t> map(100'000, 4096); // small partitions, many of them
+	assert_always(map.PartitionCount() > 100);
+
+	std::mt19937_64 rng(11);
+	std::unordered_map<size_t, size_t> model;
+	std::vector<size_t> keys(50'000), values(50'000);
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		keys[i] = rng() % 40'000; // duplicates, the later one wins
+		values[i] = i;
+		model[keys[i]] = i;
+	}
+
+	auto moved_keys = keys;
+	map.EmplaceAll(moved_keys.data(), values.data(), keys.size());
+	assert_always(map.Size() == model.size());
+
+	std::vector<size_t> lookups(20'000), found_values(lookups.size());
+	bool found[20'000];
+	for (auto& key : lookups)
+		key = rng() % 80'000;
+
+	const auto hits = map.GetAll(lookups.data(), found_values.data(), lookups.size(), found);
+	size_t expected_hits = 0;
+	for (size_t i = 0; i < lookups.size(); i++)
+	{
+		const auto it = model.find(lookups[i]);
+		expected_hits += it != model.end();
+		assert_always(found[i] == (it != model.end()));
+		assert_always(found_values[i] == (it != model.end() ? it->second : 0));
+		assert_always(map.Get(lookups[i]) == found_values[i]);
+	}
+	assert_always(hits == expected_hits);
+
+	const auto erased = map.EraseAll(lookups.data(), 1'000);
+	size_t expected_erased = 0;
+	for (size_t i = 0; i < 1'000; i++)
+		expected_erased += model.erase(lookups[i]);
+	assert_always(erased == expected_erased && map.Size() == model.size());
+
+	size_t visited = 0;
+	map.ForEach([&](const size_t& key, size_t& value)
+		{
+			assert_always(model.at(key) == value);
+			visited++;
+		});
+	assert_always(visited == model.size());
+
+	assert_always(!map.IsValid(map.Get(100'000)));
+	map[100'000] = 7;
+	assert_always(map.Get(100'000) == 7 && map.Size() == model.size() + 1);
+
+	PartitionedLinearMap<std::string, int> strings;
+	assert_always(strings.PartitionCount() == 1);
+	assert_always(strings.TryEmplace(std::string("a"), 1));
+	assert_always(strings.Get("a") == 1 && strings.Erase("a") && strings.Size() == 0);
+
+	std::cout << "TestPartitioned passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestVersioned()
+{
+	using Map = VersionedLinearMap<size_t, size_t>;
+	using Model = std::unordered_map<size_t, size_t>;
+
+	for (uint64_t seed = 0; seed < 20; ++seed)
+	{
+		std::mt19937_64 rng(seed);
+		Map map;
+		Model model;
+		std::vector<std::pair<Map::Snapshot, Model>> snapshots; // each with a copy of the model at its version
+		const size_t keys = 1 + rng() % 300;
+
+		const auto check_scan = [&](const Map::Snapshot& snapshot, const Model& expected)
+			{
+				size_t visited = 0;
+				size_t position = 0;
+				do
+				{
+					position = snapshot.ForEachFrom(position, 1 + rng() % 50, [&](const size_t& key, const size_t& value)
+						{
+							assert_always(expected.at(key) == value);
+							visited++;
+						});
+
+					const auto key = rng() % keys; // writes between the pieces of a scan
+					map.Emplace(key, position);
+					model[key] = position;
+				} while (position != Internal::npos);
+
+				assert_always(visited == expected.size());
+			};
+
+		for (size_t step = 0; step < 4000; ++step)
+		{
+			const auto op = rng() % 100;
+			const auto key = rng() % keys;
+
+			if (op < 35)
+			{
+				map.Emplace(key, step);
+				model[key] = step;
+			}
+			else if (op < 45)
+			{
+				const bool inserted = map.TryEmplace(key, step);
+				assert_always(inserted == !model.contains(key));
+				if (inserted)
+					model[key] = step;
+			}
+			else if (op < 70)
+			{
+				assert_always(map.Erase(key) == (model.erase(key) == 1));
+			}
+			else if (op < 73)
+			{
+				if (snapshots.size() < 6)
+					snapshots.emplace_back(map.TakeSnapshot(), model);
+			}
+			else if (op < 76)
+			{
+				if (!snapshots.empty())
+					snapshots.erase(snapshots.begin() + (ptrdiff_t)(rng() % snapshots.size()));
+			}
+			else if (op < 78)
+			{
+				map.Collect(rng() % 5);
+			}
+			else if (op < 90)
+			{
+				const auto& value = map.Get(key);
+				assert_always(map.IsValid(value) == model.contains(key) && map.Contains(key) == model.contains(key));
+				assert_always(!model.contains(key) || value == model[key]);
+			}
+			else if (!snapshots.empty())
+			{
+				const auto& [snapshot, expected] = snapshots[rng() % snapshots.size()];
+				const auto& value = snapshot.Get(key);
+				assert_always(snapshot.IsValid(value) == expected.contains(key) && snapshot.Contains(key) == expected.contains(key));
+				assert_always(!expected.contains(key) || value == expected.at(key));
+				check_scan(snapshot, expected);
+			}
+
+			assert_always(map.Size() == model.size());
+		}
+
+		size_t visited = 0;
+		map.ForEach([&](const size_t& key, const size_t& value)
+			{
+				assert_always(model.at(key) == value);
+				visited++;
+			});
+		assert_always(visited == model.size());
+
+		snapshots.clear();
+		map.Collect();
+		assert_always(map.SnapshotCount() == 0 && map.VersionCount() == map.Size());
+	}
+
+	VersionedLinearMap<std::string, std::string> strings;
+	strings.Emplace(std::string("a"), std::string("1"));
+	auto snapshot = strings.TakeSnapshot();
+	strings.Emplace(std::string("a"), std::string("2"));
+	assert_always(strings.Erase("a") && !strings.Contains("a"));
+	assert_always(snapshot.Get("a") == "1" && strings.VersionCount() == 2);
+	snapshot.Release();
+	assert_always(strings.Collect() == 2 && strings.VersionCount() == 0);
+
+	std::cout << "TestVersioned passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestCopyOnWrite()
+{
+	SharedLinearMap<std::string, int> config;
+	config.Emplace(std::string("a"), 1);
+	config.Emplace(std::string("b"), 2);
+	assert_always(!config.IsShared());
+
+	auto copy = config;
+	assert_always(config.IsShared() && copy.IsShared() && &copy.Read() == &config.Read());
+	assert_always(copy.Get("a") == 1 && copy.Contains("b") && !copy.IsValid(copy.Get("c")));
+
+	// writes that change nothing keep sharing
+	assert_always(!copy.Erase("c") && !copy.TryEmplace(std::string("a"), 3));
+	assert_always(copy.IsShared());
+
+	copy.Emplace(std::string("c"), 3);
+	assert_always(!copy.IsShared() && !config.IsShared());
+	assert_always(copy.Size() == 3 && config.Size() == 2 && !config.Contains("c"));
+
+	copy.Write()["a"] = 10;
+	assert_always(copy.Get("a") == 10 && config.Get("a") == 1);
+
+	auto other = config;
+	assert_always(other.Erase("a") && !other.Contains("a") && config.Contains("a"));
+
+	auto cleared = config;
+	cleared.Clear();
+	assert_always(cleared.Size() == 0 && config.Size() == 2 && !config.IsShared());
+
+	// clearing a shared copy keeps the custom hash, a key without std::hash has no default one
+	struct Sku
+	{
+		uint32_t id = 0;
+		bool operator==(const Sku&) const = default;
+	};
+
+	SharedLinearMap<Sku, int> skus(size_t(256), +[](const Sku& sku) -> size_t { return sku.id * 0x9E3779B97F4A7C15ull; });
+	skus.Emplace(Sku{ 1 }, 1);
+	auto skus_copy = skus;
+	skus_copy.Clear();
+	assert_always(!skus_copy.Contains(Sku{ 1 }) && skus_copy.Read().Capacity() == skus.Read().Capacity());
+	skus_copy.Emplace(Sku{ 2 }, 2);
+	assert_always(skus_copy.Get(Sku{ 2 }) == 2 && skus.Get(Sku{ 1 }) == 1 && !skus.Contains(Sku{ 2 }));
+
+	SharedLinearSet<size_t> set(size_t(64));
+	for (size_t i = 0; i < 100; ++i)
+		set.Emplace(i);
+
+	const auto set_copy = set;
+	assert_always(set.Erase(size_t(5)) && !set.Contains(size_t(5)) && set_copy.Contains(size_t(5)));
+	assert_always(set.Size() == 99 && set_copy.Size() == 100);
+
+	std::cout << "TestCopyOnWrite passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestMappedMap()
+{
+	// stands in for a shared memory mapping, aligned like one
+	const auto aligned = [](std::vector<std::byte>& buffer)
+		{
+			return (void*)(((uintptr_t)buffer.data() + 63) & ~(uintptr_t)63);
+		};
+
+	using Map = LinearCoreMap<size_t, Coordinates, MapPolicy{ DeletionPolicy::Tombstone }>;
+	using Image = MappedLinearMap<size_t, Coordinates, MapPolicy{ DeletionPolicy::Tombstone }>;
+
+	Map map;
+	for (size_t i = 0; i < 10'000; ++i)
+		map.Emplace(i * 16, Coordinates{ (float)i, 0, 0 });
+	for (size_t i = 0; i < 10'000; i += 3)
+		map.Erase(i * 16);
+
+	const auto bytes = Image::ImageBytes(map.Size());
+	std::vector<std::byte> first(bytes + 64), second(bytes + 64);
+	const auto built = Image::Build(map, aligned(first), bytes);
+	assert_always(built.Size() == map.Size());
+
+	// another process maps the image at another address
+	std::memcpy(aligned(second), aligned(first), bytes);
+	const Image image(aligned(second), bytes);
+	assert_always(image.Size() == map.Size() && image.Capacity() == built.Capacity());
+
+	for (size_t i = 0; i < 10'000; ++i)
+	{
+		const auto& pos = image.Get(i * 16);
+		assert_always(image.IsValid(pos) == (i % 3 != 0) && image.Contains(i * 16) == (i % 3 != 0));
+		assert_always(i % 3 == 0 || pos.x == (float)i);
+		assert_always(!image.Contains(i * 16 + 1));
+	}
+
+	size_t visited = 0;
+	image.ForEach([&](const size_t& key, const Coordinates& pos)
+		{
+			assert_always(pos.x == (float)(key / 16));
+			visited++;
+		});
+	assert_always(visited == map.Size());
+
+	const auto throws = [](auto&& attach)
+		{
+			try
+			{
+				attach();
+			}
+			catch (const std::invalid_argument&)
+			{
+				return true;
+			}
+			return false;
+		};
+
+	assert_always(throws([&] { Image small(aligned(second), bytes - 1); }));
+	assert_always(throws([&] { MappedLinearMap<size_t, Coordinates> other_policy(aligned(second), bytes); }));
+	assert_always(throws([&] { MappedLinearMap<size_t, int, MapPolicy{ DeletionPolicy::Tombstone }> other_value(aligned(second), bytes); }));
+	assert_always(throws([&] { Image unaligned((std::byte*)aligned(second) + 8, bytes); }));
+
+	LinearCoreMap<uint32_t, uint32_t> none; // an empty map gives an empty image
+	std::vector<std::byte> small(MappedLinearMap<uint32_t, uint32_t>::ImageBytes(0) + 64);
+	const auto nothing = MappedLinearMap<uint32_t, uint32_t>::Build(none, aligned(small), small.size() - 64);
+	assert_always(nothing.Size() == 0 && !nothing.Contains(1));
+
+	// a set image has no value array
+	LinearSet<uint64_t> ids;
+	for (uint64_t i = 0; i < 1000; ++i)
+		ids.Emplace(i * 3);
+	const auto set_bytes = MappedLinearSet<uint64_t>::ImageBytes(ids.Size());
+	using MapImage = MappedLinearMap<uint64_t, uint64_t>;
+	assert_always(set_bytes < MapImage::ImageBytes(ids.Size()));
+	std::vector<std::byte> set_region(set_bytes + 64);
+	(void)MappedLinearSet<uint64_t>::Build(ids, aligned(set_region), set_bytes);
+	const MappedLinearSet<uint64_t> id_image(aligned(set_region), set_bytes);
+	assert_always(id_image.Size() == 1000 && id_image.Contains(2997) && !id_image.Contains(2998));
+	size_t keys_seen = 0;
+	id_image.ForEach([&](const uint64_t& key) { keys_seen += key % 3 == 0; });
+	assert_always(keys_seen == 1000);
+	assert_always(throws([&] { MapImage not_a_map(aligned(set_region), set_bytes); }));
+
+	std::cout << "TestMappedMap passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestDictionaryMap()
+{
+	// a weak value hash, so that distinct values share hash chains
+	const auto length_hash = [](const std::string& value) { return value.size(); };
+
+	DictionaryLinearMap<size_t, std::string> map(64, nullptr, length_hash);
+	std::unordered_map<size_t, std::string> model;
+	std::mt19937_64 rng(13);
+
+	const auto distinct_values = [&model]
+		{
+			std::unordered_set<std::string> values;
+			for (const auto& [key, value] : model)
+				values.insert(value);
+			return values.size();
+		};
+
+	for (size_t step = 0; step < 20'000; ++step)
+	{
+		const auto key = rng() % 500;
+		const auto value = std::string(rng() % 4, 'x') + std::to_string(rng() % 20);
+		const auto op = rng() % 10;
+
+		if (op < 5)
+		{
+			map.Emplace(key, value);
+			model[key] = value;
+		}
+		else if (op < 6)
+		{
+			assert_always(map.TryEmplace(key, value) == model.emplace(key, value).second);
+		}
+		else if (op < 9)
+		{
+			assert_always(map.Erase(key) == (model.erase(key) == 1));
+		}
+		else
+		{
+			const auto& found = map.Get(key);
+			assert_always(map.IsValid(found) == model.contains(key) && map.Contains(key) == model.contains(key));
+			assert_always(!model.contains(key) || found == model[key]);
+		}
+
+		assert_always(map.Size() == model.size());
+		if (step % 1000 == 0)
+			assert_always(map.DistinctValues() == distinct_values());
+	}
+
+	size_t visited = 0;
+	map.ForEach([&](const size_t& key, const std::string& value)
+		{
+			assert_always(model.at(key) == value);
+			visited++;
+		});
+	assert_always(visited == model.size() && map.DistinctValues() == distinct_values());
+
+	for (size_t key = 0; key < 500; ++key)
+		map.Erase(key);
+	assert_always(map.Size() == 0 && map.DistinctValues() == 0);
+
+	std::cout << "TestDictionaryMap passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestCompactSet()
+{
+	std::mt19937_64 rng(17);
+
+	// full 64 bit keys, a small universe, dense ids, keys close to the maximum
+	const std::function<uint64_t()> shapes[] = {
+		[&] { return rng(); },
+		[&] { return rng() >> 40; },
+		[&] { return rng() % 50'000; },
+		[&] { return ~0ull - rng() % 1000; },
+	};
+
+	for (const auto& make_key : shapes)
+	{
+		for (const size_t count : { (size_t)0, (size_t)1, (size_t)100, (size_t)30'000 })
+		{
+			LinearSet<uint64_t> set;
+			for (size_t i = 0; i < count; ++i)
+				set.Emplace(make_key());
+
+			const CompactLinearSet<uint64_t> compact(set);
+			assert_always(compact.Size() == set.Size());
+
+			for (const auto key : set)
+				assert_always(compact.Contains(key));
+
+			for (size_t i = 0; i < 20'000; ++i)
+			{
+				const auto key = (i & 1) ? rng() : make_key();
+				assert_always(compact.Contains(key) == set.Contains(key));
+			}
+		}
+	}
+
+	const int keys[] = { -5, -1, 0, 7, INT32_MIN, INT32_MAX, 7 };
+	const CompactLinearSet<int> signed_keys(keys, std::size(keys));
+	assert_always(signed_keys.Size() == 6);
+	for (const auto key : keys)
+		assert_always(signed_keys.Contains(key));
+	assert_always(!signed_keys.Contains(3) && !signed_keys.Contains(-2));
+
+	std::cout << "TestCompactSet passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestMapFile()
+{
+	const auto path = (std::filesystem::temp_directory_path() / "fastlinearmap-test.bin").string();
+
+	for (const size_t count : { (size_t)0, (size_t)1, (size_t)50'000 })
+	{
+		for (const size_t chunk : { (size_t)1, (size_t)7, default_map_file_chunk })
+		{
+			if (count > 1000 && chunk == 1)
+				continue;
+
+			LinearCoreMap<uint64_t, Coordinates> map;
+			for (size_t i = 0; i < count; ++i)
+				map.Emplace(i * 977, Coordinates{ (float)i, 1, 2 });
+			SaveMap(map, path, chunk);
+
+			for (const unsigned readers : { 1u, 3u })
+			{
+				LinearCoreMap<uint64_t, Coordinates> loaded;
+				loaded.Emplace(5ull, Coordinates{}); // replaced by the file
+
+				LoadMap(loaded, path, readers);
+				assert_always(loaded.Size() == count);
+				assert_always(loaded.LoadFactor() <= loaded.MaxLoadFactor());
+				for (size_t i = 0; i < count; ++i)
+					assert_always(loaded.Get(i * 977).x == (float)i);
+			}
+		}
+	}
+
+	LinearMap<int> small;
+	small.Emplace(3, 4);
+	SaveMap(small, path);
+
+	const auto fails = [&](auto&& load)
+		{
+			try
+			{
+				load();
+			}
+			catch (const std::runtime_error&)
+			{
+				return true;
+			}
+			return false;
+		};
+
+	assert_always(fails([&] { LinearCoreMap<uint64_t, uint64_t> other_value; LoadMap(other_value, path); }));
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+	assert_always(fails([&] { LinearMap<int> truncated; LoadMap(truncated, path); }));
+	std::filesystem::remove(path);
+	assert_always(fails([&] { LinearMap<int> missing; LoadMap(missing, path); }));
+
+	std::cout << "TestMapFile passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestBufferedMap()
+{
+	BufferedLinearMap<uint64_t, std::string> map;
+	map.Write([](auto& shared) { shared.Emplace(1ull, std::string("one")); shared.Emplace(2ull, std::string("two")); });
+
+	{
+		auto writer = map.MakeWriter(4);
+		writer.Emplace(3, std::string("three"));
+		writer.Erase(1);
+		writer.Emplace(2, std::string("deux"));
+
+		// read your writes on the writer, eventual on the map
+		assert_always(writer.Pending() == 3);
+		assert_always(writer.Find(3) == "three");
+		assert_always(!writer.Contains(1));
+		assert_always(writer.Find(2) == "deux");
+		assert_always(!map.Contains(3));
+		assert_always(map.Find(1) == "one");
+		assert_always(map.Find(2) == "two");
+
+		writer.Erase(3); // pending write of the same key is replaced
+		writer.Emplace(1, std::string("uno"));
+		assert_always(writer.Pending() == 3);
+		assert_always(writer.Find(1) == "uno");
+		assert_always(!writer.Find(3));
+
+		writer.Emplace(4, std::string("four")); // fourth pending key flushes
+		assert_always(writer.Pending() == 0);
+		assert_always(map.Size() == 3);
+		assert_always(map.Find(1) == "uno");
+		assert_always(map.Find(2) == "deux");
+		assert_always(!map.Contains(3));
+		assert_always(map.Find(4) == "four");
+
+		writer.Erase(4);
+		writer.Erase(100); // missing keys are ignored
+		assert_always(map.Contains(4));
+		writer.Flush();
+		assert_always(!map.Contains(4));
+
+		writer.Emplace(5, std::string("five"));
+		auto moved = std::move(writer);
+		assert_always(moved.Pending() == 1);
+	}
+	assert_always(map.Find(5) == "five"); // flushed by the destructor
+	assert_always(map.Read([](const auto& shared) { return shared.Size(); }) == 3);
+
+	// threads write their own keys and erase every third of them
+	BufferedLinearMap<uint64_t, uint64_t> shared;
+	constexpr size_t per_thread = 20'000;
+	std::vector<std::thread> threads;
+	for (uint64_t t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([&shared, t]
+			{
+				auto writer = shared.MakeWriter(t * 50 + 1);
+				for (uint64_t i = 0; i < per_thread; ++i)
+				{
+					const auto key = i * 4 + t;
+					writer.Emplace(key, key * 3);
+					if (i % 3 == 0)
+						writer.Erase(key);
+					if (i % 1000 == 0)
+						(void)shared.Contains(key);
+				}
+			});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	assert_always(shared.Size() == 4 * (per_thread - (per_thread + 2) / 3));
+	for (uint64_t key = 0; key < 4 * per_thread; ++key)
+		assert_always(shared.Find(key) == ((key / 4) % 3 == 0 ? std::optional<uint64_t>() : key * 3));
+
+	std::cout << "TestBufferedMap passed!\n";
+}
+NO_OPTIMIZE_END
+template <MapPolicy policy>
+static void TestParallelMap(WorkStealingPool& pool)
+{
+	constexpr size_t count = 200'000;
+	std::vector<uint64_t> keys(count), values(count);
+	std::mt19937_64 rng(17);
+	for (size_t i = 0; i < count; ++i)
+	{
+		keys[i] = rng() % (count / 2); // duplicates, the last value wins
+		values[i] = i;
+	}
+
+	// tombstones and entries the inserts run into, without a resize
+	LinearCoreMap<uint64_t, uint64_t, policy> serial(1 << 20), parallel(1 << 20);
+	for (uint64_t key = 0; key < count; key += 3)
+	{
+		serial.Emplace(key, key);
+		parallel.Emplace(key, key);
+	}
+	for (uint64_t key = 0; key < count; key += 6)
+	{
+		serial.Erase(key);
+		parallel.Erase(key);
+	}
+
+	auto serial_keys = keys, serial_values = values;
+	serial.EmplaceAll(serial_keys.data(), serial_values.data(), count);
+	parallel.EmplaceAll(keys.data(), values.data(), count, pool);
+
+	const auto same = [&]
+		{
+			assert_always(serial.Size() == parallel.Size());
+			for (const auto [key, value] : serial)
+				assert_always(parallel.Get(key) == value);
+		};
+	same();
+	assert_always(parallel.Tombstones() == serial.Tombstones());
+
+	// two regions near the max load, probes cross into the next region and wrap around the end
+	LinearCoreMap<uint64_t, uint64_t, policy> dense_serial(1 << 13), dense(1 << 13);
+	for (size_t i = 0; i < 5000; ++i)
+	{
+		dense_serial.Emplace(keys[i], i);
+		dense.Emplace(keys[i], i);
+	}
+	for (size_t i = 0; i < 5000; i += 5)
+	{
+		dense_serial.Erase(keys[i]);
+		dense.Erase(keys[i]);
+	}
+	auto dense_keys = std::vector<uint64_t>(keys.begin() + 4500, keys.begin() + 5100);
+	auto dense_values = std::vector<uint64_t>(values.begin(), values.begin() + 600);
+
+	LinearCoreMap<uint64_t, uint64_t> find_home(1 << 13);
+	for (uint64_t key = count; dense_keys.size() < 603; ++key) // homes in the last slot, their probes wrap around
+	{
+		find_home.Emplace(key, key);
+		find_home.ForEachInSlots(find_home.Capacity() - 1, find_home.Capacity(), [&](const uint64_t& home_key, const uint64_t&)
+			{
+				dense_keys.push_back(home_key);
+				dense_values.push_back(home_key);
+			});
+		find_home.Erase(key);
+	}
+	auto dense_serial_keys = dense_keys, dense_serial_values = dense_values;
+	dense_serial.EmplaceAll(dense_serial_keys.data(), dense_serial_values.data(), dense_keys.size());
+	dense.EmplaceAll(dense_keys.data(), dense_values.data(), dense_keys.size(), pool);
+	assert_always(dense.Capacity() == 1 << 13 && dense.Size() == dense_serial.Size());
+	assert_always(dense.Tombstones() == dense_serial.Tombstones());
+	for (const auto [key, value] : dense_serial)
+		assert_always(dense.Get(key) == value);
+
+	parallel.Rehash(1 << 22, pool);
+	assert_always(parallel.Capacity() == 1 << 22 && parallel.Tombstones() == 0);
+	same();
+
+	std::vector<uint64_t> more(count), more_values(count, 7);
+	for (size_t i = 0; i < count; ++i)
+		more[i] = count + i * 13;
+	auto serial_more = more, serial_more_values = more_values;
+	serial.EmplaceAll(serial_more.data(), serial_more_values.data(), count);
+	LinearCoreMap<uint64_t, uint64_t, policy> small;
+	small.EmplaceAll(more.data(), more_values.data(), count, pool); // grows on the pool
+	assert_always(small.Size() == count && small.Get(count + 13 * 5) == 7);
+	Merge(parallel, small, pool);
+	same();
+
+	uint64_t sum = 0, expected = 0;
+	std::mutex mutex;
+	parallel.ForEach([&](const uint64_t&, uint64_t& value)
+		{
+			std::lock_guard lock(mutex);
+			sum += value;
+		}, pool);
+	for (const auto [key, value] : serial)
+		expected += value;
+	assert_always(sum == expected);
+
+	const auto odd = [](const uint64_t& key, const uint64_t&) { return key % 2 == 1; };
+	assert_always(parallel.EraseIf(odd, pool) == serial.EraseIf(odd));
+	same();
+}
+
+NO_OPTIMIZE_BEGIN
+static void TestParallel()
+{
+	WorkStealingPool pool(4);
+	assert_always(pool.Threads() == 4);
+
+	// every index once, the slow front is stolen by the other workers
+	std::vector<int> runs(100'003);
+	pool(runs.size(), [&](const size_t first, const size_t last)
+		{
+			for (auto i = first; i < last; ++i)
+			{
+				++runs[i];
+				if (i < 100)
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		});
+	assert_always(std::ranges::all_of(runs, [](const int n) { return n == 1; }));
+
+	bool thrown = false;
+	try
+	{
+		pool(1000, [](const size_t first, size_t) { if (first < 500) throw std::runtime_error("task"); });
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	assert_always(thrown);
+	pool(10, [](size_t, size_t) {}); // usable after an exception
+
+	TestParallelMap<MapPolicy{}>(pool);
+	TestParallelMap<MapPolicy{ .deletion = DeletionPolicy::Tombstone }>(pool);
+	TestParallelMap<MapPolicy{ .probing = ProbingPolicy::Triangular }>(pool); // serial fallback
+
+	WorkStealingPool single(1);
+	TestParallelMap<MapPolicy{}>(single);
+
+	LinearSet<uint64_t> twos, threes;
+	std::vector<uint64_t> keys;
+	for (uint64_t i = 0; i < 100'000; ++i)
+		keys.push_back(i * 2);
+	twos.EmplaceAll(keys.data(), keys.size(), pool);
+	keys.clear();
+	for (uint64_t i = 0; i < 100'000; ++i)
+		keys.push_back(i * 3);
+	threes.EmplaceAll(keys.data(), keys.size(), pool);
+	assert_always(twos.Size() == 100'000 && threes.Contains(299'997) && !threes.Contains(299'998));
+
+	const auto both = Intersection(twos, threes, pool);
+	const auto only_twos = Difference(twos, threes, pool);
+	auto either = Union(twos, threes, pool);
+	assert_always(both.Size() == 33'334 && only_twos.Size() == 66'666 && either.Size() == 166'666);
+	for (uint64_t key = 0; key < 300'000; ++key)
+		assert_always(either.Contains(key) == ((key % 2 == 0 && key < 200'000) || key % 3 == 0));
+
+	either.Rehash(1 << 21, pool);
+	assert_always(either.EraseIf([](const uint64_t& key) { return key % 6 == 0; }, pool) == 50'000);
+	size_t left = 0;
+	either.ForEach([&](const uint64_t& key) { assert_always(key % 6 != 0); ++left; });
+	assert_always(left == 116'666 && either.Size() == left);
+
+	std::cout << "TestParallel passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestViews()
+{
+	LinearCoreMap<uint64_t, uint64_t> map;
+	for (uint64_t i = 0; i < 10'000; ++i)
+		map.Emplace(i * 7, i);
+	map.Erase(7);
+	map.Erase(700);
+
+	auto slots = map.Slots();
+	auto keys = map.Keys();
+	auto values = map.Values();
+	auto entries = map.Entries();
+	static_assert(std::ranges::random_access_range<decltype(slots)> && std::ranges::sized_range<decltype(slots)>);
+	static_assert(std::ranges::random_access_range<decltype(entries)> && std::ranges::view<decltype(keys)>);
+	assert_always(slots.size() == map.Capacity());
+	assert_always(keys.size() == map.Size() && values.size() == map.Size() && entries.size() == map.Size());
+	assert_always(std::ranges::count_if(slots, [](const auto& slot) { return slot.used; }) == 9'998);
+
+	// the same entries in the same order as the Iterator
+	size_t n = 0;
+	for (auto [key, value] : map)
+	{
+		assert_always(keys[n] == key && values[n] == value);
+		assert_always(entries[n].first == key && entries.begin()[n].second == value);
+		++n;
+	}
+	assert_always(std::ranges::max(keys) == 9'999 * 7);
+	assert_always(std::ranges::find(keys, (uint64_t)700) == keys.end());
+	assert_always(keys.end() - keys.begin() == (std::ptrdiff_t)map.Size() && (keys.end() - 1)[0] == keys.back());
+
+	// values can be changed through the views, split by index over a pool
+	WorkStealingPool pool(4);
+	pool(values.size(), [&](const size_t first, const size_t last)
+		{
+			for (auto it = values.begin() + first; it != values.begin() + last; ++it)
+				*it += 1;
+		});
+	std::ranges::for_each(slots, [](const auto& slot) { if (slot.used) slot.value *= 2; });
+	assert_always(std::as_const(map)[14] == 6);
+	for (auto [key, value] : entries)
+		assert_always(value == (key / 7 + 1) * 2);
+
+	// the views of a const map are read only
+	const auto& reader = map;
+	static_assert(std::is_same_v<std::ranges::range_reference_t<decltype(reader.Values())>, const uint64_t&>);
+	static_assert(std::is_same_v<decltype(reader.Slots()[0].value), const uint64_t&>);
+	static_assert(std::is_same_v<decltype(reader.Entries()[0].second), const uint64_t&>);
+	assert_always(reader.Values()[3] == values[3] && reader.Entries()[3].second == entries[3].second);
+	assert_always(std::ranges::count_if(reader.Slots(), [](const auto& slot) { return slot.used; }) == 9'998);
+
+	// copies share the slot list
+	const auto copy = keys;
+	assert_always(copy.begin()[5] == keys[5] && &*copy.begin() == &*keys.begin());
+
+	LinearSet<int> set;
+	for (int i = 0; i < 100; ++i)
+		set.Emplace(i);
+	set.Erase(50);
+	auto set_keys = set.Keys();
+	static_assert(std::ranges::random_access_range<decltype(set.Slots())>);
+	assert_always(set_keys.size() == 99 && std::ranges::count(set_keys, 50) == 0);
+	assert_always(std::accumulate(set_keys.begin(), set_keys.end(), 0) == 4950 - 50);
+	assert_always(std::ranges::count_if(set.Slots(), [](const auto& slot) { return slot.used; }) == 99);
+
+	LinearCoreMap<int, int> empty;
+	assert_always(empty.Keys().empty() && empty.Entries().begin() == empty.Entries().end());
+
+	std::cout << "TestViews passed!\n";
+}
+NO_OPTIMIZE_END
+template <MapPolicy policy>
+static void TestSortedMap(WorkStealingPool& pool)
+{
+	LinearCoreMap<int64_t, int64_t, policy> map;
+	std::mt19937_64 rng(17);
+	for (int64_t i = 0; i < 100'000; ++i) // more than one radix block
+	{
+		const auto key = i % 4 == 0 ? -(int64_t)(rng() >> 40) : (int64_t)(rng() >> 1);
+		map.Emplace(key, key / 2);
+	}
+
+	// against the keys of the table, after every kind of change
+	const auto check = [&](const bool parallel = false)
+		{
+			const auto keys = map.Keys();
+			std::vector<int64_t> expected(keys.begin(), keys.end());
+			std::ranges::sort(expected);
+
+			const auto sorted = parallel ? map.SortedView(pool) : map.SortedView();
+			assert_always(sorted.size() == expected.size());
+			size_t n = 0;
+			for (auto [key, value] : sorted)
+			{
+				assert_always(key == expected[n++] && value == key / 2);
+			}
+		};
+
+	check(true);
+	check(); // kept
+
+	std::vector<std::pair<int64_t, int64_t>> out{ { 1, 1 } };
+	map.ExtractSorted(out, pool);
+	assert_always(out.size() == map.Size() && std::ranges::is_sorted(out) && out.front().first == map.SortedView()[0].first);
+
+	map.Emplace(-1, 0);
+	check();
+	map[-2] = -1;
+	check();
+	const auto keys_now = map.Keys();
+	for (auto it = keys_now.begin(); it != keys_now.begin() + 1000; ++it)
+		(void)map.Get(*it); // moves entries with hit reordering
+	check();
+	map.Erase(map.SortedView()[10].first);
+	check(true);
+	map.Rehash(map.Capacity() * 2);
+	check();
+	map.Rehash(map.Capacity() * 2, pool);
+	check();
+
+	std::vector<int64_t> keys, values;
+	for (int64_t i = 0; i < 1000; ++i)
+	{
+		keys.push_back(i * 1'000'003);
+		values.push_back(i * 1'000'003 / 2);
+	}
+	map.EmplaceAll(keys.data(), values.data(), 500);
+	check();
+	map.EmplaceAll(keys.data() + 500, values.data() + 500, 500, pool);
+	check(true);
+	const auto map_capacity = map.Capacity();
+	for (int64_t key = (int64_t)1 << 62; map.Capacity() == map_capacity; ++key)
+		map.Emplace(key, key / 2); // until it grows
+	check();
+
+	auto copy = map; // same slots, shares the order
+	map.Erase(map.SortedView().back().first);
+	check();
+	assert_always(copy.SortedView().size() == map.Size() + 1);
+
+	map.Clear();
+	assert_always(map.SortedView().empty());
+	map.Emplace(4, 2);
+	assert_always(map.SortedView().size() == 1);
+	map.Reserve(64);
+	assert_always(map.SortedView().empty());
+}
+
+NO_OPTIMIZE_BEGIN
+static void TestSorted()
+{
+	WorkStealingPool pool(4);
+	TestSortedMap<MapPolicy{}>(pool);
+	TestSortedMap<MapPolicy{ .deletion = DeletionPolicy::Tombstone }>(pool);
+	TestSortedMap<MapPolicy{ .reordering = HitReordering::Transpose }>(pool);
+
+	// a digit shared by every key is skipped
+	LinearSet<uint32_t> set;
+	const auto check = [&](const bool parallel = false)
+		{
+			const auto keys = set.Keys();
+			std::vector<uint32_t> expected(keys.begin(), keys.end());
+			std::ranges::sort(expected);
+
+			std::vector<uint32_t> sorted;
+			if (parallel)
+				set.ExtractSorted(sorted, pool);
+			else
+				set.ExtractSorted(sorted);
+			assert_always(sorted == expected);
+		};
+
+	for (uint32_t i = 0; i < 100'000; ++i)
+		set.Emplace(0xab000000u | (i * 7919 % 100'000));
+	check(true);
+	assert_always(set.SortedView().front() == 0xab000000u);
+
+	set.Erase(0xab000000u);
+	check();
+	set.Emplace(5);
+	check();
+	assert_always(set.SortedView()[0] == 5 && set.SortedView()[1] == 0xab000001u);
+	set.Rehash(set.Capacity() * 2);
+	check();
+	set.Rehash(set.Capacity() * 2, pool);
+	check(true);
+
+	std::vector<uint32_t> more;
+	for (uint32_t i = 0; i < 1000; ++i)
+		more.push_back(i * 3);
+	set.EmplaceAll(more.data(), 500);
+	check();
+	set.EmplaceAll(more.data() + 500, 500, pool);
+	check(true);
+	const auto set_capacity = set.Capacity();
+	for (uint32_t key = 1u << 31; set.Capacity() == set_capacity; ++key)
+		set.Emplace(key); // until it grows
+	check();
+
+	set.Clear();
+	assert_always(set.SortedView().empty());
+	set.Emplace(4);
+	assert_always(set.SortedView().size() == 1);
+	set.Reserve(64);
+	assert_always(set.SortedView().empty());
+
+	LinearSet<int8_t> small;
+	for (int i = -128; i < 128; i += 3)
+		small.Emplace((int8_t)i);
+	assert_always(std::ranges::is_sorted(small.SortedView()) && small.SortedView().front() == -128);
+
+	LinearSet<std::string> names;
+	for (const char* name : { "delta", "alpha", "charlie", "bravo" })
+		names.Emplace(name);
+	std::vector<std::string> ordered;
+	names.ExtractSorted(ordered);
+	assert_always((ordered == std::vector<std::string>{ "alpha", "bravo", "charlie", "delta" }));
+
+	std::cout << "TestSorted passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
+static void TestExport()
+{
+	LinearCoreMap<uint64_t, double> map;
+	for (uint64_t i = 0; i < 200'000; ++i)
+		map.Emplace(i * 13, (double)i / 4);
+	map.Erase(13);
+
+	// the same order as the Iterator, in one block and in parallel blocks
+	WorkStealingPool pool(4);
+	std::vector<uint64_t> keys(map.Size()), parallel_keys(map.Size() + 5, 7);
+	std::vector<double> values(map.Size()), parallel_values(map.Size());
+	assert_always(map.ExportTo(keys, values) == map.Size());
+	assert_always(map.ExportTo(parallel_keys, parallel_values, pool) == map.Size());
+	size_t n = 0;
+	for (auto [key, value] : map)
+	{
+		assert_always(keys[n] == key && values[n] == value);
+		assert_always(parallel_keys[n] == key && parallel_values[n] == value);
+		++n;
+	}
+	assert_always(parallel_keys.back() == 7); // past the entries
+
+	std::vector<double> only_values(map.Size());
+	map.ExportTo({}, only_values, pool);
+	assert_always(only_values == values);
+
+	bool thrown = false;
+	try
+	{
+		std::vector<uint64_t> small(map.Size() - 1);
+		map.ExportTo(small, {});
+	}
+	catch (const std::out_of_range&)
+	{
+		thrown = true;
+	}
+	assert_always(thrown);
+
+	LinearSet<int16_t> set;
+	for (int16_t i = -100; i < 100; ++i)
+		set.Emplace(i);
+	std::vector<int16_t> set_keys(set.Size());
+	assert_always(set.ExportTo(set_keys) == 200);
+	std::ranges::sort(set_keys);
+	assert_always(set_keys.front() == -100 && set_keys.back() == 99);
+
+	// Arrow C data interface
+	ArrowArray array;
+	ArrowSchema schema;
+	ExportArrow(map, &array, &schema, pool);
+	assert_always(std::string(schema.format) == "+s" && schema.n_children == 2);
+	assert_always(std::string(schema.children[0]->format) == "L" && std::string(schema.children[0]->name) == "key");
+	assert_always(std::string(schema.children[1]->format) == "g" && std::string(schema.children[1]->name) == "value");
+	assert_always(array.length == (int64_t)map.Size() && array.null_count == 0 && array.n_children == 2);
+	assert_always(array.children[0]->n_buffers == 2 && array.children[0]->buffers[0] == nullptr);
+
+	const auto* key_column = static_cast<const uint64_t*>(array.children[0]->buffers[1]);
+	assert_always(std::equal(keys.begin(), keys.end(), key_column));
+
+	ArrowArray moved = *array.children[1]; // the consumer takes the value column
+	array.children[1]->release = nullptr;
+	array.release(&array);
+	assert_always(array.release == nullptr);
+
+	const auto* value_column = static_cast<const double*>(moved.buffers[1]);
+	assert_always(std::equal(values.begin(), values.end(), value_column));
+	moved.release(&moved);
+	schema.release(&schema);
+	assert_always(schema.release == nullptr);
+
+	LinearMap<int32_t> small;
+	small.Emplace(3, -4);
+	ExportArrow(small, &array, &schema);
+	assert_always(std::string(schema.children[0]->format) == "L" && std::string(schema.children[1]->format) == "i");
+	assert_always(array.length == 1 && static_cast<const int32_t*>(array.children[1]->buffers[1])[0] == -4);
+	array.release(&array);
+	schema.release(&schema);
+
+	std::cout << "TestExport passed!\n";
+}
+NO_OPTIMIZE_END
+NO_OPTIMIZE_BEGIN
 static void TestEmplaceAll()
 {
 	LinearMap<int> map;
@@ -665,6 +2046,25 @@ static void BenchmarkLinearMapVsUnorderedMap()
 	std::cout << sum << found << "\n"; // to prevent optimization
 }
 
+static void BenchmarkKeyAndValueTypes()
+{
+	MapBenchmarks::BenchmarkKeyTypes(
+		[](const size_t count)
+		{
+			MapBenchmarks::BenchmarkLargeValue<Coordinates>("size_t -> Coordinates", count, [](const size_t i)
+				{
+					return Coordinates{ (float)i, (float)i * 2, (float)i * 3 };
+				});
+		},
+		[](const size_t count)
+		{
+			MapBenchmarks::BenchmarkLargeValue<MyVector>("size_t -> MyVector", count, [](const size_t i)
+				{
+					return MyVector{ std::vector<int>(16, (int)i) };
+				});
+		});
+}
+
 static void RunAllTests()
 {
 	TestBasic();
@@ -673,6 +2073,24 @@ static void RunAllTests()
 	TestRandomStress();
 	TestIterator();
 	TestErase();
+	TestTombstoneErase();
+	TestProbingPolicies();
+	TestHopscotch();
+	TestCuckoo();
+	TestHotKeys();
+	TestHitReordering();
+	TestPartitioned();
+	TestVersioned();
+	TestCopyOnWrite();
+	TestMappedMap();
+	TestDictionaryMap();
+	TestCompactSet();
+	TestMapFile();
+	TestBufferedMap();
+	TestParallel();
+	TestViews();
+	TestSorted();
+	TestExport();
 	TestEmplaceAll();
 
 	std::cout << "All tests passed successfully!\n";
@@ -716,15 +2134,36 @@ static void HashTest()
 }
 
 NO_OPTIMIZE_BEGIN
-int main()
+int main(const int argc, char** argv)
 {
 	MapExamples::RunExamples();
 	RunAllTests();
 
+	// --tests skips the benchmarks, for ctest
+	if (argc > 1 && std::string(argv[1]) == "--tests")
+		return 0;
+
 #if NDEBUG
 
 	HashTest();
 	BenchmarkLinearMapVsUnorderedMap();
+	BenchmarkKeyAndValueTypes();
+	MapBenchmarks::BenchmarkErase();
+	MapBenchmarks::BenchmarkProbing();
+	MapBenchmarks::BenchmarkLookupLatency();
+	MapBenchmarks::BenchmarkHotKeys();
+	MapBenchmarks::BenchmarkPartitioned();
+	MapBenchmarks::BenchmarkVersioned();
+	MapBenchmarks::BenchmarkCopyOnWrite();
+	MapBenchmarks::BenchmarkMemoryUsage();
+	MapBenchmarks::BenchmarkDictionaryMemory();
+	MapBenchmarks::BenchmarkCompactSet();
+	MapBenchmarks::BenchmarkMapFile();
+	MapBenchmarks::BenchmarkBufferedWrites();
+	MapBenchmarks::BenchmarkParallel();
+	MapBenchmarks::BenchmarkViews();
+	MapBenchmarks::BenchmarkSorted();
+	MapBenchmarks::BenchmarkExport();
 #endif
 }
 NO_OPTIMIZE_END
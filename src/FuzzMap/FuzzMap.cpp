@@ -0,0 +1,522 @@
+// FuzzMap.cpp : Differential fuzzing of LinearCoreMap, HopscotchLinearMap, LinearCuckooMap and LinearSet against the std containers.
+//
+// Every input is decoded into a sequence of operations, which run on both containers in lockstep.
+// After each operation, the results and the touched key are compared, and every few operations
+// the whole content is compared. Any mismatch prints the operation and aborts.
+//
+// libFuzzer (clang):
+//   clang++ -std=c++20 -g -O1 -fsanitize=fuzzer,address,undefined -DLMAP_LIBFUZZER -Iinclude src/FuzzMap/FuzzMap.cpp
+//   ./a.out corpus/
+//
+// Standalone driver (any compiler, sanitizers recommended):
+//   FuzzMap [iterations] [seed]   random operation sequences
+//   FuzzMap <file>                replays one input, e.g. a crash found by libFuzzer
+
+#include "LinearMap.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace LinearProbing;
+
+namespace
+{
+	const std::vector<uint8_t>* current_input = nullptr; // standalone driver only, saved on failure
+
+	[[noreturn]] void Fail(const char* operation, const std::string& detail)
+	{
+		std::fprintf(stderr, "FuzzMap mismatch in %s: %s\n", operation, detail.c_str());
+
+		if (current_input)
+		{
+			std::ofstream file("fuzzmap-crash.bin", std::ios::binary);
+			file.write(reinterpret_cast<const char*>(current_input->data()), (std::streamsize)current_input->size());
+			std::fprintf(stderr, "Input saved to fuzzmap-crash.bin\n");
+		}
+
+		std::fflush(stderr);
+		std::abort();
+	}
+
+	/// <summary>
+	/// Hands out the fuzzer input byte by byte. Returns zeros once the input is used up.
+	/// </summary>
+	class ByteReader
+	{
+		const uint8_t* m_data;
+		size_t m_size;
+		size_t m_pos = 0;
+
+	public:
+
+		ByteReader(const uint8_t* data, const size_t size) noexcept : m_data(data), m_size(size) {}
+
+		[[nodiscard]] bool Empty() const noexcept
+		{
+			return m_pos >= m_size;
+		}
+
+		uint8_t Byte() noexcept
+		{
+			return m_pos < m_size ? m_data[m_pos++] : 0;
+		}
+
+		uint16_t Short() noexcept
+		{
+			return (uint16_t)(Byte() | (Byte() << 8));
+		}
+	};
+
+	enum class Operation : uint8_t
+	{
+		Emplace,
+		TryEmplace,
+		GetOrCreate,
+		Erase,
+		Get,
+		Contains,
+		Rehash,
+		Clear,
+		EmplaceAll,
+		Count
+	};
+
+	constexpr const char* operation_names[] = {
+		"Emplace", "TryEmplace", "GetOrCreate", "Erase", "Get", "Contains", "Rehash", "Clear", "EmplaceAll"
+	};
+
+	template <class K>
+	std::string KeyToString(const K& key)
+	{
+		if constexpr (std::is_same_v<K, std::string>)
+			return key;
+		else
+			return std::to_string(key);
+	}
+
+	template <class Map>
+	void CheckLoad(const Map& map, const char* operation)
+	{
+		// tombstones lengthen probes like entries, at least one slot must stay empty
+		if (map.Size() + map.Tombstones() > (size_t)((double)map.Capacity() * map.MaxLoadFactor()))
+			Fail(operation, "load factor " + std::to_string(map.LoadFactor()) + " above maximum, "
+				+ std::to_string(map.Tombstones()) + " tombstones");
+	}
+
+	template <class Map, class K, class V>
+	void CheckMapContent(Map& map, const std::unordered_map<K, V>& model, const char* operation)
+	{
+		if (map.Size() != model.size())
+			Fail(operation, "size " + std::to_string(map.Size()) + " != " + std::to_string(model.size()));
+
+		for (const auto& [key, value] : model)
+		{
+			auto& found = map.Get(key);
+			if (!map.IsValid(found) || found != value)
+				Fail(operation, "key " + KeyToString(key) + " lost or wrong value");
+		}
+
+		size_t iterated = 0;
+		for (auto [key, value] : map)
+		{
+			const auto it = model.find(key);
+			if (it == model.end() || it->second != value)
+				Fail(operation, "iterator returned unknown key " + KeyToString(key));
+
+			++iterated;
+		}
+
+		if (iterated != model.size())
+			Fail(operation, "iterator visited " + std::to_string(iterated) + " entries");
+	}
+
+	/// <summary>
+	/// Runs the decoded operations on 'Map' (LinearCoreMap, HopscotchLinearMap or LinearCuckooMap) and a std::unordered_map<K, V>.
+	/// </summary>
+	template <class K, class V, class Map, class MakeKey>
+	void FuzzMap(ByteReader& input, MakeKey&& make_key)
+	{
+		Map map(8); // small, so resizes and wrap arounds happen early
+		std::unordered_map<K, V> model;
+
+		size_t step = 0;
+		while (!input.Empty())
+		{
+			const auto operation = static_cast<Operation>(input.Byte() % (uint8_t)Operation::Count);
+			const char* name = operation_names[(size_t)operation];
+			const K key = make_key(input.Byte());
+			const V value = (V)input.Short();
+
+			switch (operation)
+			{
+			case Operation::Emplace:
+			{
+				map.Emplace(key, value);
+				model[key] = value;
+				break;
+			}
+			case Operation::TryEmplace:
+			{
+				const bool inserted = map.TryEmplace(key, value);
+				if (inserted != model.try_emplace(key, value).second)
+					Fail(name, "wrong result for key " + KeyToString(key));
+				break;
+			}
+			case Operation::GetOrCreate:
+			{
+				const V result = map.GetOrCreate(key, value);
+				if (result != model.try_emplace(key, value).first->second)
+					Fail(name, "wrong value for key " + KeyToString(key));
+				break;
+			}
+			case Operation::Erase:
+			{
+				if (map.Erase(key) != (model.erase(key) > 0))
+					Fail(name, "wrong result for key " + KeyToString(key));
+				break;
+			}
+			case Operation::Get:
+			{
+				auto& found = map.Get(key);
+				const auto it = model.find(key);
+				if (map.IsValid(found) != (it != model.end()) || (it != model.end() && found != it->second))
+					Fail(name, "wrong value for key " + KeyToString(key));
+				break;
+			}
+			case Operation::Contains:
+			{
+				if (map.Contains(key) != model.contains(key))
+					Fail(name, "wrong result for key " + KeyToString(key));
+				break;
+			}
+			case Operation::Rehash:
+			{
+				const size_t capacity = (value % 512) + 1;
+				try
+				{
+					map.Rehash(capacity);
+				}
+				catch (const std::out_of_range&)
+				{
+					// fine, as long as the map really couldn't hold its content
+					if (map.Size() <= capacity)
+						Fail(name, "refused capacity " + std::to_string(capacity));
+				}
+				break;
+			}
+			case Operation::Clear:
+			{
+				map.Clear();
+				model.clear();
+				break;
+			}
+			case Operation::EmplaceAll:
+			{
+				const size_t count = value % 64;
+				std::vector<K> keys;
+				std::vector<V> values;
+
+				for (size_t i = 0; i < count; ++i)
+				{
+					keys.push_back(make_key(input.Byte()));
+					values.push_back((V)(value + i));
+					model[keys.back()] = values.back(); // later duplicates win
+				}
+
+				map.EmplaceAll(keys.data(), values.data(), count);
+				break;
+			}
+			default:
+				UNREACHABLE();
+			}
+
+			CheckLoad(map, name);
+
+			if (++step % 16 == 0)
+				CheckMapContent(map, model, name);
+		}
+
+		CheckMapContent(map, model, "end of input");
+	}
+
+	/// <summary>
+	/// Same for LinearSet<K> and std::unordered_set<K>. Operations without a set equivalent are skipped.
+	/// </summary>
+	template <class K, MapPolicy policy, class MakeKey>
+	void FuzzSet(ByteReader& input, MakeKey&& make_key)
+	{
+		LinearSet<K, policy> set(8);
+		std::unordered_set<K> model;
+
+		while (!input.Empty())
+		{
+			const auto operation = static_cast<Operation>(input.Byte() % (uint8_t)Operation::Count);
+			const char* name = operation_names[(size_t)operation];
+			const K key = make_key(input.Byte());
+
+			switch (operation)
+			{
+			case Operation::Emplace:
+				set.Emplace(key);
+				model.insert(key);
+				break;
+			case Operation::TryEmplace:
+			case Operation::GetOrCreate:
+				if (set.TryEmplace(key) != model.insert(key).second)
+					Fail(name, "wrong result for key " + KeyToString(key));
+				break;
+			case Operation::Erase:
+				if (set.Erase(key) != (model.erase(key) > 0))
+					Fail(name, "wrong result for key " + KeyToString(key));
+				break;
+			case Operation::Get:
+			case Operation::Contains:
+				if (set.Contains(key) != model.contains(key))
+					Fail(name, "wrong result for key " + KeyToString(key));
+				break;
+			case Operation::Rehash:
+			{
+				const size_t capacity = (input.Short() % 512) + 1;
+				try
+				{
+					set.Rehash(capacity);
+				}
+				catch (const std::out_of_range&)
+				{
+					if (set.Size() <= capacity)
+						Fail(name, "refused capacity " + std::to_string(capacity));
+				}
+				break;
+			}
+			case Operation::Clear:
+				set.Clear();
+				model.clear();
+				break;
+			case Operation::EmplaceAll:
+			{
+				const size_t count = input.Byte() % 64;
+				std::vector<K> keys;
+				for (size_t i = 0; i < count; ++i)
+				{
+					keys.push_back(make_key(input.Byte()));
+					model.insert(keys.back());
+				}
+
+				set.EmplaceAll(keys.data(), count);
+				break;
+			}
+			default:
+				UNREACHABLE();
+			}
+
+			CheckLoad(set, name);
+		}
+
+		if (set.Size() != model.size())
+			Fail("end of input", "size " + std::to_string(set.Size()) + " != " + std::to_string(model.size()));
+
+		for (const auto& key : model)
+			if (!set.Contains(key))
+				Fail("end of input", "key " + KeyToString(key) + " lost");
+	}
+
+	/// <summary>
+	/// Runs container 0-3 (see 'RunInput') with 'policy'.
+	/// </summary>
+	template <MapPolicy policy>
+	void RunContainer(ByteReader& input, const uint8_t container, const uint64_t stride)
+	{
+		switch (container)
+		{
+		case 0:
+			FuzzMap<uint64_t, uint64_t, LinearCoreMap<uint64_t, uint64_t, policy>>(input, [stride](const uint8_t byte) { return (uint64_t)byte * stride; });
+			break;
+		case 1:
+			FuzzMap<uint32_t, int, LinearCoreMap<uint32_t, int, policy>>(input, [](const uint8_t byte) { return (uint32_t)(byte % 32); });
+			break;
+		case 2:
+			FuzzMap<std::string, int, LinearCoreMap<std::string, int, policy>>(input, [](const uint8_t byte) { return "key_" + std::to_string(byte); });
+			break;
+		case 3: // sets have no hot key cache or hit reordering
+			FuzzSet<uint64_t, MapPolicy{ policy.deletion, policy.probing }>(input, [stride](const uint8_t byte) { return (uint64_t)byte * stride; });
+			break;
+		default:
+			UNREACHABLE();
+		}
+	}
+
+	/// <summary>
+	/// Same containers for HopscotchLinearMap, which has no set. Container 3 runs a map with 8 slot neighborhoods,
+	/// the key spaces are too small to overflow the default ones and exercise the hops.
+	/// </summary>
+	void RunHopscotch(ByteReader& input, const uint8_t container, const uint64_t stride)
+	{
+		switch (container)
+		{
+		case 0:
+			FuzzMap<uint64_t, uint64_t, HopscotchLinearMap<uint64_t, uint64_t>>(input, [stride](const uint8_t byte) { return (uint64_t)byte * stride; });
+			break;
+		case 1:
+			FuzzMap<uint32_t, int, HopscotchLinearMap<uint32_t, int>>(input, [](const uint8_t byte) { return (uint32_t)(byte % 32); });
+			break;
+		case 2:
+			FuzzMap<std::string, int, HopscotchLinearMap<std::string, int>>(input, [](const uint8_t byte) { return "key_" + std::to_string(byte); });
+			break;
+		case 3:
+			FuzzMap<uint64_t, uint64_t, HopscotchLinearMap<uint64_t, uint64_t, 8>>(input, [stride](const uint8_t byte) { return (uint64_t)byte * stride; });
+			break;
+		default:
+			UNREACHABLE();
+		}
+	}
+
+	/// <summary>
+	/// Same containers for LinearCuckooMap, container 3 runs the uint64_t map with 8 slot buckets.
+	/// </summary>
+	void RunCuckoo(ByteReader& input, const uint8_t container, const uint64_t stride)
+	{
+		switch (container)
+		{
+		case 0:
+			FuzzMap<uint64_t, uint64_t, LinearCuckooMap<uint64_t, uint64_t>>(input, [stride](const uint8_t byte) { return (uint64_t)byte * stride; });
+			break;
+		case 1:
+			FuzzMap<uint32_t, int, LinearCuckooMap<uint32_t, int>>(input, [](const uint8_t byte) { return (uint32_t)(byte % 32); });
+			break;
+		case 2:
+			FuzzMap<std::string, int, LinearCuckooMap<std::string, int>>(input, [](const uint8_t byte) { return "key_" + std::to_string(byte); });
+			break;
+		case 3:
+			FuzzMap<uint64_t, uint64_t, LinearCuckooMap<uint64_t, uint64_t, 8>>(input, [stride](const uint8_t byte) { return (uint64_t)byte * stride; });
+			break;
+		default:
+			UNREACHABLE();
+		}
+	}
+
+	/// <summary>
+	/// Entry point for one input. The first byte picks the container, the policy and the key space.
+	/// Small key spaces give many duplicates and long clusters.
+	///
+	///   bits 0-1  container: uint64_t map, uint32_t map, string map, uint64_t set
+	///   bits 2-4  policy: backward shift, tombstones, triangular probing, group probing, HopscotchLinearMap,
+	///   and 7     LinearCuckooMap, backward shift and tombstones with a 16 entry hot key cache,
+	///             then with Transpose hit reordering (modulo 10)
+	///   bits 5-6  key stride
+	/// </summary>
+	void RunInput(const uint8_t* data, const size_t size)
+	{
+		ByteReader input(data, size);
+		const uint8_t mode = input.Byte();
+		const uint8_t container = mode % 4;
+		const uint8_t policy = ((mode >> 2) & 7) | ((mode >> 4) & 8);
+		const uint64_t stride = 1ull + ((mode >> 5) & 3); // strided keys collide more with the golden ratio hash
+
+		constexpr MapPolicy shift{ DeletionPolicy::BackwardShift };
+		constexpr MapPolicy tombstone{ DeletionPolicy::Tombstone };
+		constexpr MapPolicy triangular{ .probing = ProbingPolicy::Triangular };
+		constexpr MapPolicy group{ .probing = ProbingPolicy::GroupLinear };
+		constexpr MapPolicy hot_shift{ .hot_keys = 16 };
+		constexpr MapPolicy hot_tombstone{ DeletionPolicy::Tombstone, ProbingPolicy::Linear, 16 };
+		constexpr MapPolicy transpose_shift{ .reordering = HitReordering::Transpose };
+		constexpr MapPolicy transpose_tombstone{ DeletionPolicy::Tombstone, ProbingPolicy::Linear, 0, HitReordering::Transpose };
+
+		switch (policy % 10)
+		{
+		case 0:
+			RunContainer<shift>(input, container, stride);
+			break;
+		case 1:
+			RunContainer<tombstone>(input, container, stride);
+			break;
+		case 2:
+			RunContainer<triangular>(input, container, stride);
+			break;
+		case 3:
+			RunContainer<group>(input, container, stride);
+			break;
+		case 4:
+			RunHopscotch(input, container, stride);
+			break;
+		case 5:
+			RunCuckoo(input, container, stride);
+			break;
+		case 6:
+			RunContainer<hot_shift>(input, container, stride);
+			break;
+		case 7:
+			RunContainer<hot_tombstone>(input, container, stride);
+			break;
+		case 8:
+			RunContainer<transpose_shift>(input, container, stride);
+			break;
+		case 9:
+			RunContainer<transpose_tombstone>(input, container, stride);
+			break;
+		default:
+			UNREACHABLE();
+		}
+	}
+}
+
+#if defined(LMAP_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size)
+{
+	RunInput(data, size);
+	return 0;
+}
+
+#else
+
+int main(const int argc, char** argv)
+{
+	if (argc == 2 && !std::isdigit((unsigned char)argv[1][0]))
+	{
+		std::ifstream file(argv[1], std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cerr << "Can't open " << argv[1] << "\n";
+			return 1;
+		}
+
+		const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		RunInput(data.data(), data.size());
+		std::cout << "Input passed\n";
+		return 0;
+	}
+
+	const size_t iterations = argc > 1 ? std::stoull(argv[1]) : 2'000;
+	const uint64_t seed = argc > 2 ? std::stoull(argv[2]) : std::random_device{}();
+
+	std::cout << "FuzzMap: " << iterations << " sequences, seed " << seed << "\n";
+
+	std::mt19937_64 rng(seed);
+	std::vector<uint8_t> data;
+	current_input = &data;
+
+	for (size_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		// long sequences, a few thousand operations each
+		data.resize(1 + rng() % 16'384);
+		for (auto& byte : data)
+			byte = (uint8_t)rng();
+
+		RunInput(data.data(), data.size());
+	}
+
+	std::cout << "All sequences passed\n";
+	return 0;
+}
+
+#endif
@@ -0,0 +1,507 @@
+// HashAnalysis.cpp : Compares the hash mixers of LinearMap.h on real key dumps.
+//
+// Usage:
+//   HashAnalysis <file> [--u64 | --text] [--capacity N] [--probing linear | triangular | group]
+//   HashAnalysis [--capacity N] [--probing ...]   (synthetic key sets)
+//
+//   --u64    file holds raw little-endian 64-bit keys (default for *.bin)
+//   --text   file holds one string key per line (default otherwise)
+//   --capacity N   analyze this capacity too, rounded like the map does it
+//   --probing P    only this ProbingPolicy (default: Linear, Triangular and GroupLinear)
+//
+// For every probing policy and every mixer in 'Internal::all_hash_mixers', the keys are placed
+// into a table in the probe order of the map, at the capacity the map would grow to, and one
+// doubling above it. Hopscotch and Cuckoo bound their probes and aren't simulated.
+
+#include "LinearMap.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace LinearProbing;
+
+namespace
+{
+	/// <summary>
+	/// Exposes the capacity rules of the map.
+	/// </summary>
+	class CapacityRules : public Internal::LinearHash<uint64_t>
+	{
+	public:
+
+		static size_t Format(const size_t n) noexcept
+		{
+			return FormatCapacity(n);
+		}
+
+		/// <summary>
+		/// Capacity after inserting 'count' keys one by one, into a default map of 64 slots.
+		/// </summary>
+		static size_t Grown(const size_t count) noexcept
+		{
+			auto capacity = FormatCapacity(64);
+			while ((double)count / (double)capacity > max_load_factor)
+				capacity *= 2;
+
+			return capacity;
+		}
+	};
+
+	struct Histogram
+	{
+		static constexpr size_t bucket_count = 9;
+		static constexpr const char* labels[bucket_count] = { "0", "1", "2", "3", "4-7", "8-15", "16-31", "32-63", "64+" };
+		size_t buckets[bucket_count] = {};
+
+		void Add(const size_t value) noexcept
+		{
+			size_t bucket;
+			if (value < 4)
+				bucket = value;
+			else
+				bucket = (std::min)((size_t)std::bit_width(value) + 1, bucket_count - 1); // 4-7 -> 4, 8-15 -> 5 ...
+
+			++buckets[bucket];
+		}
+	};
+
+	struct RunStats
+	{
+		size_t count = 0;
+		size_t total = 0;
+		size_t max = 0;
+
+		void Add(const size_t length) noexcept
+		{
+			++count;
+			total += length;
+			max = (std::max)(max, length);
+		}
+
+		[[nodiscard]] double Mean() const noexcept
+		{
+			return count ? (double)total / (double)count : 0.0;
+		}
+	};
+
+	constexpr ProbingPolicy simulated_probing[] = { ProbingPolicy::Linear, ProbingPolicy::Triangular, ProbingPolicy::GroupLinear };
+
+	constexpr const char* ProbingName(const ProbingPolicy probing) noexcept
+	{
+		switch (probing)
+		{
+		case ProbingPolicy::Linear:      return "Linear";
+		case ProbingPolicy::Triangular:  return "Triangular";
+		case ProbingPolicy::GroupLinear: return "GroupLinear";
+		case ProbingPolicy::Hopscotch:   return "Hopscotch";
+		case ProbingPolicy::Cuckoo:      return "Cuckoo";
+		}
+		return "?";
+	}
+
+	/// <summary>
+	/// Slot the map puts a new key with home slot 'home' into, in a table without tombstones, and the extra
+	/// probes to reach it. The same order as 'FindEmptySlot' of the map. GroupLinear counts groups.
+	/// </summary>
+	static std::pair<size_t, size_t> PlaceKey(const ProbingPolicy probing, const size_t home, const std::vector<uint8_t>& used)
+	{
+		const auto last_index = used.size() - 1;
+		size_t probes = 0;
+
+		if (probing == ProbingPolicy::GroupLinear)
+		{
+			for (auto group = home & ~(Internal::probe_group_size - 1); ; group = (group + Internal::probe_group_size) & last_index, ++probes)
+			{
+				for (auto i = group; i < group + Internal::probe_group_size; ++i)
+				{
+					if (!used[i])
+						return { i, probes };
+				}
+			}
+		}
+
+		size_t step = 0;
+		auto i = home;
+		while (used[i])
+		{
+			i = probing == ProbingPolicy::Triangular ? (i + ++step) & last_index : (i + 1) & last_index;
+			++probes;
+		}
+
+		return { i, probes };
+	}
+
+	/// <summary>
+	/// Extra probes of a lookup that misses from home slot 'home': the used slots it passes before an empty one,
+	/// with GroupLinear the groups without an empty slot.
+	/// </summary>
+	static size_t MissProbes(const ProbingPolicy probing, const size_t home, const std::vector<uint8_t>& used)
+	{
+		const auto last_index = used.size() - 1;
+		size_t probes = 0;
+
+		if (probing == ProbingPolicy::GroupLinear)
+		{
+			for (auto group = home & ~(Internal::probe_group_size - 1); ; group = (group + Internal::probe_group_size) & last_index, ++probes)
+			{
+				const auto first = used.begin() + (ptrdiff_t)group;
+				if (std::find(first, first + (ptrdiff_t)Internal::probe_group_size, 0) != first + (ptrdiff_t)Internal::probe_group_size)
+					return probes;
+			}
+		}
+
+		size_t step = 0;
+		for (auto i = home; used[i]; i = probing == ProbingPolicy::Triangular ? (i + ++step) & last_index : (i + 1) & last_index)
+			++probes;
+
+		return probes;
+	}
+
+	struct MixerReport
+	{
+		Internal::HashMixer mixer{};
+		double mean_probe = 0;  // extra probes of a successful lookup
+		size_t p99_probe = 0;
+		size_t max_probe = 0;
+		double miss_probe = 0;  // probes of an unsuccessful lookup, averaged over all home slots
+		RunStats clusters;      // runs of used slots
+		RunStats empty_runs;    // runs of free slots
+		Histogram histogram;
+		double mhashes_per_s = 0;
+	};
+
+	template <Internal::HashMixer mixer>
+	static double TimeMixer(const std::vector<uint64_t>& hashes, const size_t capacity)
+	{
+		size_t sink = 0;
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		for (int round = 0; round < 4; ++round)
+			for (const auto hash : hashes)
+				sink += Internal::MixHash<mixer>(hash, capacity) & (capacity - 1);
+
+		const auto end = std::chrono::high_resolution_clock::now();
+		volatile size_t keep = sink;
+		(void)keep;
+
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		return seconds > 0 ? (double)hashes.size() * 4 / seconds / 1e6 : 0.0;
+	}
+
+	static double TimeMixer(const Internal::HashMixer mixer, const std::vector<uint64_t>& hashes, const size_t capacity)
+	{
+		switch (mixer)
+		{
+		case Internal::HashMixer::Custom:      return TimeMixer<Internal::HashMixer::Custom>(hashes, capacity);
+		case Internal::HashMixer::Splitmix64:  return TimeMixer<Internal::HashMixer::Splitmix64>(hashes, capacity);
+		case Internal::HashMixer::WyhashFinal: return TimeMixer<Internal::HashMixer::WyhashFinal>(hashes, capacity);
+		case Internal::HashMixer::GoldenRatio: return TimeMixer<Internal::HashMixer::GoldenRatio>(hashes, capacity);
+		}
+		return 0;
+	}
+
+	static MixerReport Analyze(const Internal::HashMixer mixer, const ProbingPolicy probing, const std::vector<uint64_t>& hashes, const size_t capacity)
+	{
+		MixerReport report;
+		report.mixer = mixer;
+
+		const auto last_index = capacity - 1;
+		std::vector<uint8_t> used(capacity, 0);
+		std::vector<size_t> probes;
+		probes.reserve(hashes.size());
+
+		// same placement as Emplace: first free slot on the probe sequence of the home slot
+		for (const auto hash : hashes)
+		{
+			const auto [i, distance] = PlaceKey(probing, Internal::MixHash(mixer, hash, capacity) & last_index, used);
+			used[i] = 1;
+			probes.push_back(distance);
+			report.histogram.Add(distance);
+		}
+
+		size_t total = 0;
+		for (const auto distance : probes)
+			total += distance;
+
+		report.mean_probe = probes.empty() ? 0.0 : (double)total / (double)probes.size();
+
+		if (!probes.empty())
+		{
+			auto p99 = probes.begin() + (ptrdiff_t)((double)(probes.size() - 1) * 0.99);
+			std::nth_element(probes.begin(), p99, probes.end());
+			report.p99_probe = *p99;
+			report.max_probe = *std::max_element(probes.begin(), probes.end());
+		}
+
+		// walk the table once, starting at a free slot, so runs don't get split by the wrap around
+		size_t origin = 0;
+		while (origin < capacity && used[origin])
+			++origin;
+
+		size_t run = 0;
+		bool run_used = false;
+
+		for (size_t step = 0; step <= capacity; ++step)
+		{
+			const bool is_used = step < capacity && used[(origin + step) & last_index];
+			if (step < capacity && (run == 0 || is_used == run_used))
+			{
+				run_used = is_used;
+				++run;
+				continue;
+			}
+
+			if (run_used)
+				report.clusters.Add(run);
+			else
+				report.empty_runs.Add(run);
+
+			run_used = is_used;
+			run = 1;
+		}
+
+		double miss_total = 0;
+		for (size_t home = 0; home < capacity; ++home)
+			miss_total += (double)MissProbes(probing, home, used);
+
+		report.miss_probe = miss_total / (double)capacity;
+		return report;
+	}
+
+	static void PrintReports(const std::vector<MixerReport>& reports, const ProbingPolicy probing, const size_t key_count, const size_t capacity)
+	{
+		std::cout << "\n" << ProbingName(probing) << " probing, capacity " << capacity << ", load factor " << std::fixed << std::setprecision(3)
+			<< (double)key_count / (double)capacity;
+		if (probing == ProbingPolicy::GroupLinear)
+			std::cout << ", probes in groups of " << Internal::probe_group_size << " slots";
+		std::cout << "\n\n";
+
+		std::cout << std::left << std::setw(14) << "Mixer" << std::right
+			<< std::setw(10) << "Probe" << std::setw(8) << "p99" << std::setw(8) << "Max"
+			<< std::setw(10) << "Miss" << std::setw(12) << "Clusters" << std::setw(10) << "Avg len"
+			<< std::setw(10) << "Max len" << std::setw(12) << "Empty avg" << std::setw(12) << "Mhash/s" << "\n";
+
+		for (const auto& report : reports)
+		{
+			std::cout << std::left << std::setw(14) << Internal::HashMixerName(report.mixer) << std::right
+				<< std::setprecision(3) << std::setw(10) << report.mean_probe
+				<< std::setw(8) << report.p99_probe << std::setw(8) << report.max_probe
+				<< std::setw(10) << report.miss_probe
+				<< std::setw(12) << report.clusters.count << std::setw(10) << report.clusters.Mean()
+				<< std::setw(10) << report.clusters.max << std::setw(12) << report.empty_runs.Mean()
+				<< std::setprecision(1) << std::setw(12) << report.mhashes_per_s << "\n";
+		}
+
+		std::cout << "\nProbe length distribution (% of keys)\n" << std::left << std::setw(14) << "Mixer" << std::right;
+		for (const auto* label : Histogram::labels)
+			std::cout << std::setw(8) << label;
+
+		std::cout << "\n";
+
+		for (const auto& report : reports)
+		{
+			std::cout << std::left << std::setw(14) << Internal::HashMixerName(report.mixer) << std::right << std::setprecision(2);
+			for (const auto bucket : report.histogram.buckets)
+				std::cout << std::setw(8) << (key_count ? 100.0 * (double)bucket / (double)key_count : 0.0);
+
+			std::cout << "\n";
+		}
+
+		std::cout.unsetf(std::ios::floatfield);
+	}
+
+	static void AnalyzeKeys(const std::string& name, const std::vector<uint64_t>& hashes, const size_t extra_capacity,
+		const std::vector<ProbingPolicy>& policies)
+	{
+		std::cout << "\n=== " << name << ": " << hashes.size() << " unique keys ===\n";
+
+		if (hashes.empty())
+			return;
+
+		std::vector<size_t> capacities;
+		const auto grown = CapacityRules::Grown(hashes.size());
+		capacities.push_back(grown);
+		capacities.push_back(grown * 2);
+
+		if (extra_capacity)
+		{
+			const auto capacity = CapacityRules::Format(extra_capacity);
+			if (capacity <= hashes.size())
+				std::cout << "Skipping capacity " << capacity << ", it can't hold all keys\n";
+			else if (std::find(capacities.begin(), capacities.end(), capacity) == capacities.end())
+				capacities.push_back(capacity);
+		}
+
+		for (const auto capacity : capacities)
+		{
+			std::vector<double> mhashes_per_s; // the same for every policy
+			for (const auto mixer : Internal::all_hash_mixers)
+				mhashes_per_s.push_back(TimeMixer(mixer, hashes, capacity));
+
+			for (const auto probing : policies)
+			{
+				std::vector<MixerReport> reports;
+				for (const auto mixer : Internal::all_hash_mixers)
+				{
+					reports.push_back(Analyze(mixer, probing, hashes, capacity));
+					reports.back().mhashes_per_s = mhashes_per_s[reports.size() - 1];
+				}
+
+				PrintReports(reports, probing, hashes.size(), capacity);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Reads raw 64-bit keys, and drops duplicates while keeping the file order.
+	/// </summary>
+	static bool LoadU64Keys(const std::string& path, std::vector<uint64_t>& hashes)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		std::unordered_set<uint64_t> seen;
+		uint64_t key;
+		while (file.read(reinterpret_cast<char*>(&key), sizeof(key)))
+		{
+			if (seen.insert(key).second)
+				hashes.push_back(key); // integer keys are used as their own hash
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Reads one string key per line, hashed like a LinearCoreMap<std::string, V> does it.
+	/// </summary>
+	static bool LoadTextKeys(const std::string& path, std::vector<uint64_t>& hashes)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+			return false;
+
+		std::unordered_set<std::string> seen;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			if (seen.insert(line).second)
+				hashes.push_back(std::hash<std::string>{}(line));
+		}
+
+		return true;
+	}
+
+	static void AnalyzeSyntheticKeys(const size_t extra_capacity, const std::vector<ProbingPolicy>& policies)
+	{
+		constexpr size_t count = 1'000'000;
+		std::vector<uint64_t> hashes(count);
+
+		for (size_t i = 0; i < count; ++i)
+			hashes[i] = i;
+		AnalyzeKeys("Sequential", hashes, extra_capacity, policies);
+
+		for (size_t i = 0; i < count; ++i)
+			hashes[i] = i * 4096;
+		AnalyzeKeys("Stride 4096", hashes, extra_capacity, policies);
+
+		uint64_t state = 0x853c49e6748fea9bull;
+		for (size_t i = 0; i < count; ++i)
+		{
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			hashes[i] = state;
+		}
+		AnalyzeKeys("Random", hashes, extra_capacity, policies);
+	}
+
+	static int Usage(const std::string& error)
+	{
+		std::cerr << error << "\n"
+			<< "usage: HashAnalysis [<file>] [--u64 | --text] [--capacity N] [--probing linear | triangular | group]\n";
+		return 1;
+	}
+
+	/// <summary>
+	/// Positive decimal number, or 0 if 'text' isn't one.
+	/// </summary>
+	static size_t ParseCount(const std::string& text) noexcept
+	{
+		size_t value = 0;
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		return error == std::errc{} && end == text.data() + text.size() ? value : 0;
+	}
+}
+
+int main(const int argc, char** argv)
+{
+	std::string path;
+	size_t extra_capacity = 0;
+	int format = 0; // 0 = by extension, 1 = u64, 2 = text
+	std::vector<ProbingPolicy> policies(std::begin(simulated_probing), std::end(simulated_probing));
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "--u64")
+			format = 1;
+		else if (arg == "--text")
+			format = 2;
+		else if (arg == "--capacity")
+		{
+			if (i + 1 >= argc || (extra_capacity = ParseCount(argv[i + 1])) == 0)
+				return Usage("--capacity needs a positive number");
+			++i;
+		}
+		else if (arg == "--probing")
+		{
+			const std::string name = i + 1 < argc ? argv[++i] : "";
+			if (name == "linear")
+				policies = { ProbingPolicy::Linear };
+			else if (name == "triangular")
+				policies = { ProbingPolicy::Triangular };
+			else if (name == "group")
+				policies = { ProbingPolicy::GroupLinear };
+			else
+				return Usage("--probing needs linear, triangular or group");
+		}
+		else if (!arg.empty() && arg[0] == '-')
+			return Usage("Unknown option: " + arg);
+		else
+			path = arg;
+	}
+
+	if (path.empty())
+	{
+		AnalyzeSyntheticKeys(extra_capacity, policies);
+		return 0;
+	}
+
+	if (format == 0)
+		format = path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0 ? 1 : 2;
+
+	std::vector<uint64_t> hashes;
+	const bool loaded = format == 1 ? LoadU64Keys(path, hashes) : LoadTextKeys(path, hashes);
+
+	if (!loaded)
+	{
+		std::cerr << "Can't open " << path << "\n";
+		return 1;
+	}
+
+	AnalyzeKeys(path, hashes, extra_capacity, policies);
+	return 0;
+}
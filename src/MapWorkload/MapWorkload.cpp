@@ -0,0 +1,68 @@
+// MapWorkload.cpp : Mixed Emplace/Get/Contains/Erase workloads over LinearMap, LinearCoreMap and LinearSet.
+//
+// Usage:
+//   MapWorkload [--scale X] [--repeat N] [--report file]
+//
+//   --scale X      multiplies key counts and operations (default 1.0)
+//   --repeat N     runs every workload N times and keeps the fastest (default 3)
+//   --report file  writes 'name<TAB>ms<TAB>checksum' lines
+//
+// This is the training run of the PGO build (scripts/pgo_build.sh), and the binary
+// the plain and optimized builds are compared with.
+
+#include "LinearMap.h"
+#include "workload_benchmark.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(const int argc, char** argv)
+{
+	double scale = 1.0;
+	size_t repeat = 3;
+	std::string report;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--scale" && i + 1 < argc)
+			scale = std::stod(argv[++i]);
+		else if (arg == "--repeat" && i + 1 < argc)
+			repeat = (std::max)(std::stoull(argv[++i]), 1ull);
+		else if (arg == "--report" && i + 1 < argc)
+			report = argv[++i];
+		else
+		{
+			std::cerr << "usage: MapWorkload [--scale X] [--repeat N] [--report file]\n";
+			return 1;
+		}
+	}
+
+	auto best = MapBenchmarks::RunMapWorkloads(scale);
+	for (size_t r = 1; r < repeat; ++r)
+	{
+		const auto results = MapBenchmarks::RunMapWorkloads(scale);
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			if (results[i].checksum != best[i].checksum)
+			{
+				std::cerr << results[i].name << ": checksum differs between runs\n";
+				return 1;
+			}
+
+			best[i].ms = (std::min)(best[i].ms, results[i].ms);
+		}
+	}
+
+	std::cout << "\n--- Map Workloads (scale " << scale << ", best of " << repeat << ") ---\n\n";
+	MapBenchmarks::PrintWorkloadResults(best);
+
+	if (!report.empty() && !MapBenchmarks::WriteWorkloadReport(report, best))
+	{
+		std::cerr << "can't write " << report << "\n";
+		return 1;
+	}
+
+	return 0;
+}
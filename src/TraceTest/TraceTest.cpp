@@ -0,0 +1,154 @@
+// TraceTest.cpp : Checks the 'Internal::erase_trace' reports of Erase, built with LMAP_TRACE.
+//
+// Every map and set builds the same cluster around one home slot, erases keys out of it,
+// and compares 'probes', 'scanned' and 'moved' with the backward shift worked out by hand.
+//
+//   g++ -std=c++20 -O2 -DLMAP_TRACE -Iinclude src/TraceTest/TraceTest.cpp
+//   ./a.out
+
+#if !defined(LMAP_TRACE)
+#error TraceTest needs LMAP_TRACE
+#endif
+
+#include "LinearMap.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace LinearProbing;
+
+#define check(expr) \
+	do { \
+		if (!(expr)) { \
+			std::cerr << "TraceTest failed: (" #expr ") in " << __FILE__ << ":" << __LINE__ << std::endl; \
+			std::abort(); \
+		} \
+	} while (0)
+
+namespace
+{
+	std::vector<Internal::EraseTrace> traces;
+
+	void Record(const Internal::EraseTrace& trace)
+	{
+		traces.push_back(trace);
+	}
+
+	/// <summary>
+	/// The only trace reported since the last call.
+	/// </summary>
+	Internal::EraseTrace TakeTrace()
+	{
+		check(traces.size() == 1);
+		const auto trace = traces.front();
+		traces.clear();
+		return trace;
+	}
+
+	/// <summary>
+	/// Smallest key above 0 with home slot 'home' in a table of 'capacity' slots, and no multiple of it.
+	/// </summary>
+	uint64_t KeyWithHome(const size_t home, const size_t capacity)
+	{
+		for (uint64_t key = 1; ; ++key)
+		{
+			if (key % capacity && (Internal::MixHash<Internal::default_hash_mixer>(key, capacity) & (capacity - 1)) == home)
+				return key;
+		}
+	}
+
+	/// <summary>
+	/// Builds, with h the home slot of key 0 and S the capacity:
+	///
+	///   slot  h   h+1  h+2  h+3  h+4
+	///   key   0   S    c    e    2S
+	///   home  h   h    h+1  h+3  h
+	///
+	/// Erasing S moves c and 2S, e stays. Then 2S sits in h+2, three probes from its home,
+	/// and its erase scans e, which stays.
+	/// </summary>
+	template <class Map, class Insert>
+	void TestCluster(const char* name, Map& map, Insert&& insert)
+	{
+		const size_t capacity = map.Capacity();
+		const size_t last_index = capacity - 1;
+		const size_t home = Internal::MixHash<Internal::default_hash_mixer>(0, capacity) & last_index;
+		const uint64_t c = KeyWithHome((home + 1) & last_index, capacity);
+		const uint64_t e = KeyWithHome((home + 3) & last_index, capacity);
+
+		for (const uint64_t key : { uint64_t(0), uint64_t(capacity), c, e, uint64_t(2 * capacity) })
+			insert(key);
+		check(traces.empty());
+
+		check(!map.Erase(uint64_t(3 * capacity))); // a miss reports nothing
+		check(traces.empty());
+
+		check(map.Erase(uint64_t(capacity)));
+		auto trace = TakeTrace();
+		check(trace.slot == ((home + 1) & last_index));
+		check(trace.probes == 2);
+		check(trace.scanned == 3);
+		check(trace.moved == 2);
+
+		check(map.Erase(uint64_t(2 * capacity)));
+		trace = TakeTrace();
+		check(trace.slot == ((home + 2) & last_index));
+		check(trace.probes == 3);
+		check(trace.scanned == 1);
+		check(trace.moved == 0);
+
+		check(map.Erase(uint64_t(0)));
+		trace = TakeTrace();
+		check(trace.slot == home);
+		check(trace.probes == 1);
+		check(trace.scanned == 1); // c, now at its home
+		check(trace.moved == 0);
+
+		check(map.Size() == 2 && map.Contains(c) && map.Contains(e));
+		std::cout << name << " passed\n";
+	}
+
+	/// <summary>
+	/// Tombstones don't shift, the trace only reports the probes.
+	/// </summary>
+	void TestTombstones()
+	{
+		constexpr MapPolicy tombstones{ DeletionPolicy::Tombstone };
+
+		LinearCoreMap<uint64_t, uint64_t, tombstones> map(64);
+		const size_t capacity = map.Capacity();
+		for (uint64_t i = 0; i < 4; ++i)
+			map.Emplace(i * capacity, i); // one home slot
+
+		check(map.Erase(uint64_t(2 * capacity)));
+		const auto trace = TakeTrace();
+		check(trace.probes == 3);
+		check(trace.scanned == 0);
+		check(trace.moved == 0);
+
+		std::cout << "Tombstones passed\n";
+	}
+}
+
+int main()
+{
+	Internal::erase_trace = Record;
+
+	LinearCoreMap<uint64_t, uint64_t> trivial(64); // blind moves
+	TestCluster("LinearCoreMap<uint64_t, uint64_t>", trivial, [&](const uint64_t key) { trivial.Emplace(key, key); });
+
+	LinearCoreMap<uint64_t, std::string> strings(64); // moves only the entries that may move
+	TestCluster("LinearCoreMap<uint64_t, std::string>", strings, [&](const uint64_t key) { strings.Emplace(key, std::to_string(key)); });
+
+	LinearSet<uint64_t> set(64);
+	TestCluster("LinearSet<uint64_t>", set, [&](const uint64_t key) { set.Emplace(key); });
+
+	TestTombstones();
+
+	Internal::erase_trace = nullptr;
+	std::cout << "TraceTest passed\n";
+	return 0;
+}